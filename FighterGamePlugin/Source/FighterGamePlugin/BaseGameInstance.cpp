@@ -2,4 +2,197 @@
 
 
 #include "BaseGameInstance.h"
+#include "Engine/AssetManager.h"
+#include "Engine/World.h"
+#include "Kismet/GameplayStatics.h"
+#include "FighterGamePluginCharacter.h"
+#include "FighterGamePlugin.h"
 
+UBaseGameInstance::UBaseGameInstance()
+{
+	characterClasses.Add(ECharacterClass::VE_Default, TSoftClassPtr<AFighterGamePluginCharacter>(FSoftObjectPath(TEXT("/Game/SideScrollerCPP/Blueprints/SideScrollerCharacter.SideScrollerCharacter_C"))));
+	characterClasses.Add(ECharacterClass::VE_YBot, TSoftClassPtr<AFighterGamePluginCharacter>(FSoftObjectPath(TEXT("/Game/SideScrollerCPP/Blueprints/YBotCharacterBP.YBotCharacterBP_C"))));
+
+	preloadSettleSeconds = 0.15f;
+	selectionToFightTargetSeconds = 1.0f;
+	lastSelectionToFightSeconds = -1.0f;
+
+	characterPreload.requestSeconds = 0.0;
+	stagePreload.requestSeconds = 0.0;
+	isFightPending = false;
+	selectionSeconds = 0.0;
+	isCharacterSelected = false;
+}
+
+void UBaseGameInstance::PreviewCharacter(ECharacterClass _characterClass)
+{
+	settlingCharacterPath = GetCharacterPath(_characterClass);
+
+	//Moving off a choice stops its load straight away, without waiting for the cursor to settle again
+	if (characterPreload.path != settlingCharacterPath)
+	{
+		CancelPreload(characterPreload);
+	}
+
+	//Restarted by every move, so it only fires for the choice the cursor rests on
+	GetTimerManager().SetTimer(characterSettleTimer, FTimerDelegate::CreateUObject(this, &UBaseGameInstance::OnCharacterSettled), FMath::Max(preloadSettleSeconds, KINDA_SMALL_NUMBER), false);
+}
+
+void UBaseGameInstance::SelectCharacter(ECharacterClass _characterClass)
+{
+	characterClass = _characterClass;
+	isCharacterSelected = true;
+
+	GetTimerManager().ClearTimer(characterSettleTimer);
+	RequestPreload(characterPreload, GetCharacterPath(_characterClass));
+}
+
+void UBaseGameInstance::PreviewStage(TSoftObjectPtr<UWorld> _stage)
+{
+	settlingStagePath = _stage.ToSoftObjectPath();
+
+	if (stagePreload.path != settlingStagePath)
+	{
+		CancelPreload(stagePreload);
+	}
+
+	GetTimerManager().SetTimer(stageSettleTimer, FTimerDelegate::CreateUObject(this, &UBaseGameInstance::OnStageSettled), FMath::Max(preloadSettleSeconds, KINDA_SMALL_NUMBER), false);
+}
+
+void UBaseGameInstance::StartFight(TSoftObjectPtr<UWorld> _stage)
+{
+	selectionSeconds = FPlatformTime::Seconds();
+	isCharacterSelected = true;
+
+	GetTimerManager().ClearTimer(characterSettleTimer);
+	GetTimerManager().ClearTimer(stageSettleTimer);
+
+	//Normally both are already loaded or loading from their previews, and these do nothing
+	RequestPreload(characterPreload, GetCharacterPath(characterClass));
+	RequestPreload(stagePreload, _stage.ToSoftObjectPath());
+
+	fightStage = _stage;
+	isFightPending = true;
+	TryStartFight();
+}
+
+TSubclassOf<AFighterGamePluginCharacter> UBaseGameInstance::GetLoadedCharacterClass(ECharacterClass _characterClass) const
+{
+	const TSoftClassPtr<AFighterGamePluginCharacter>* softClass = characterClasses.Find(_characterClass);
+	return softClass ? softClass->Get() : nullptr;
+}
+
+TSoftClassPtr<AFighterGamePluginCharacter> UBaseGameInstance::GetSelectedCharacterClass() const
+{
+	const TSoftClassPtr<AFighterGamePluginCharacter>* softClass = isCharacterSelected ? characterClasses.Find(characterClass) : nullptr;
+	return softClass ? *softClass : TSoftClassPtr<AFighterGamePluginCharacter>();
+}
+
+void UBaseGameInstance::OnFightStarted()
+{
+	if (selectionSeconds <= 0.0)
+	{
+		return;
+	}
+
+	lastSelectionToFightSeconds = (float)(FPlatformTime::Seconds() - selectionSeconds);
+	selectionSeconds = 0.0;
+
+	if (lastSelectionToFightSeconds > selectionToFightTargetSeconds)
+	{
+		UE_LOG(LogFighter, Warning, TEXT("Selection to fight took %.0f ms, over the %.0f ms target"), lastSelectionToFightSeconds * 1000.0f, selectionToFightTargetSeconds * 1000.0f);
+	}
+	else
+	{
+		UE_LOG(LogFighter, Log, TEXT("Selection to fight took %.0f ms"), lastSelectionToFightSeconds * 1000.0f);
+	}
+
+	//The stage is the loaded world now, so the preload does not need to hold it. The character stays loaded for a rematch.
+	CancelPreload(stagePreload);
+}
+
+void UBaseGameInstance::RequestPreload(FPreload& _preload, const FSoftObjectPath& _path)
+{
+	if (_preload.path == _path && _preload.handle.IsValid())
+	{
+		return;
+	}
+
+	CancelPreload(_preload);
+	_preload.path = _path;
+
+	if (_path.IsNull())
+	{
+		return;
+	}
+
+	_preload.requestSeconds = FPlatformTime::Seconds();
+	_preload.handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(_path,
+		FStreamableDelegate::CreateUObject(this, &UBaseGameInstance::OnPreloadCompleted), FStreamableManager::AsyncLoadHighPriority);
+}
+
+void UBaseGameInstance::CancelPreload(FPreload& _preload)
+{
+	if (_preload.handle.IsValid())
+	{
+		if (_preload.handle->IsLoadingInProgress())
+		{
+			_preload.handle->CancelHandle();
+		}
+		else
+		{
+			_preload.handle->ReleaseHandle();
+		}
+		_preload.handle.Reset();
+	}
+	_preload.path.Reset();
+}
+
+bool UBaseGameInstance::IsPreloaded(const FPreload& _preload) const
+{
+	return _preload.path.IsNull() || (_preload.handle.IsValid() && _preload.handle->HasLoadCompleted());
+}
+
+void UBaseGameInstance::OnPreloadCompleted()
+{
+	for (FPreload* preload : { &characterPreload, &stagePreload })
+	{
+		//Each request is only logged once, as this is called for either of them finishing
+		if (preload->requestSeconds > 0.0 && preload->handle.IsValid() && preload->handle->HasLoadCompleted())
+		{
+			UE_LOG(LogFighter, Log, TEXT("Preloaded %s in %.0f ms"), *preload->path.ToString(), (FPlatformTime::Seconds() - preload->requestSeconds) * 1000.0);
+			preload->requestSeconds = 0.0;
+		}
+	}
+
+	TryStartFight();
+}
+
+void UBaseGameInstance::OnCharacterSettled()
+{
+	RequestPreload(characterPreload, settlingCharacterPath);
+}
+
+void UBaseGameInstance::OnStageSettled()
+{
+	RequestPreload(stagePreload, settlingStagePath);
+}
+
+void UBaseGameInstance::TryStartFight()
+{
+	if (!isFightPending || !IsPreloaded(characterPreload) || !IsPreloaded(stagePreload))
+	{
+		return;
+	}
+
+	isFightPending = false;
+
+	//The map package is already in memory and held by the preload, so loading the map only has to set up the world
+	UGameplayStatics::OpenLevel(this, FName(*fightStage.GetLongPackageName()));
+}
+
+FSoftObjectPath UBaseGameInstance::GetCharacterPath(ECharacterClass _characterClass) const
+{
+	const TSoftClassPtr<AFighterGamePluginCharacter>* softClass = characterClasses.Find(_characterClass);
+	return softClass ? softClass->ToSoftObjectPath() : FSoftObjectPath();
+}
@@ -4,8 +4,12 @@
 
 #include "CoreMinimal.h"
 #include "Engine/GameInstance.h"
+#include "Engine/StreamableManager.h"
+#include "TimerManager.h"
 #include "BaseGameInstance.generated.h"
 
+class AFighterGamePluginCharacter;
+
 /**
  * 
  */
@@ -16,12 +20,21 @@ enum class ECharacterClass : uint8
 	VE_YBot		UMETA(DisplayName = "YBot")
 };
 
-UCLASS()
+/**
+ * Besides the menu choices, loads what the fight needs while the menus are still up.
+ *
+ * CharacterSelectScreen and LevelSelectScreen call PreviewCharacter and PreviewStage as their cursor moves. Once it has rested
+ * on a choice for preloadSettleSeconds, that choice's bundle (the character blueprint, which brings its skeletal mesh and
+ * animation blueprint, or the stage's map package) starts loading in the background, and moving on cancels it.
+ * StartFight opens the stage the moment both bundles are in memory, and the fight's first frame reports how long that took.
+ */
+UCLASS(config = Game)
 class FIGHTERGAMEPLUGIN_API UBaseGameInstance : public UGameInstance
 {
 	GENERATED_BODY()
 
 public:
+	UBaseGameInstance();
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Player References")
 		ECharacterClass characterClass;
@@ -29,4 +42,91 @@ public:
 	//Is the device intended to be used for multiple players (keyboard mode)
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Controller")
 		bool isDeviceForMultiplePlayers;
+
+	//The blueprint of each character class
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Loading")
+		TMap<ECharacterClass, TSoftClassPtr<AFighterGamePluginCharacter>> characterClasses;
+
+	//How long the cursor has to rest on a choice before it starts loading, so scrolling past choices loads nothing
+	UPROPERTY(Config, EditAnywhere, BlueprintReadWrite, Category = "Loading")
+		float preloadSettleSeconds;
+
+	//The time from the final choice to the fight's first frame that is logged as too slow
+	UPROPERTY(Config, EditAnywhere, BlueprintReadWrite, Category = "Loading")
+		float selectionToFightTargetSeconds;
+
+	//Seconds from the last StartFight to the first frame of that fight, or -1 before any
+	UPROPERTY(BlueprintReadOnly, Category = "Loading")
+		float lastSelectionToFightSeconds;
+
+	//Call whenever the character select cursor moves onto _characterClass
+	UFUNCTION(BlueprintCallable, Category = "Loading")
+		void PreviewCharacter(ECharacterClass _characterClass);
+
+	//Choose _characterClass, and load it now if its preview has not
+	UFUNCTION(BlueprintCallable, Category = "Loading")
+		void SelectCharacter(ECharacterClass _characterClass);
+
+	//Call whenever the level select cursor moves onto _stage
+	UFUNCTION(BlueprintCallable, Category = "Loading")
+		void PreviewStage(TSoftObjectPtr<UWorld> _stage);
+
+	//The final choice. Opens _stage as soon as it and the chosen character are loaded, instead of loading them while the screen is frozen.
+	UFUNCTION(BlueprintCallable, Category = "Loading")
+		void StartFight(TSoftObjectPtr<UWorld> _stage);
+
+	//The class of _characterClass if it is in memory, or null while it is still loading
+	UFUNCTION(BlueprintPure, Category = "Loading")
+		TSubclassOf<AFighterGamePluginCharacter> GetLoadedCharacterClass(ECharacterClass _characterClass) const;
+
+	//The chosen character's class, or null if the menus never chose one. Already loaded once StartFight has opened the stage.
+	TSoftClassPtr<AFighterGamePluginCharacter> GetSelectedCharacterClass() const;
+
+	//Called by the game mode on the first frame of a fight
+	void OnFightStarted();
+
+protected:
+	//One menu choice's assets, loaded as one request
+	struct FPreload
+	{
+		FSoftObjectPath path;
+		TSharedPtr<FStreamableHandle> handle;
+		double requestSeconds;
+	};
+
+	//Starts loading _path into _preload, unless it is already there, cancelling whatever _preload was loading
+	void RequestPreload(FPreload& _preload, const FSoftObjectPath& _path);
+
+	//Stops waiting for _preload and lets go of it. A package already being read still finishes in the background, but nothing holds on to it.
+	void CancelPreload(FPreload& _preload);
+
+	bool IsPreloaded(const FPreload& _preload) const;
+
+	void OnPreloadCompleted();
+	void OnCharacterSettled();
+	void OnStageSettled();
+
+	//Opens the stage if StartFight is waiting and everything has loaded
+	void TryStartFight();
+
+	FSoftObjectPath GetCharacterPath(ECharacterClass _characterClass) const;
+
+	FPreload characterPreload;
+	FPreload stagePreload;
+
+	//What the cursor is resting on, loaded when the settle timers fire
+	FSoftObjectPath settlingCharacterPath;
+	FSoftObjectPath settlingStagePath;
+	FTimerHandle characterSettleTimer;
+	FTimerHandle stageSettleTimer;
+
+	//The stage StartFight is waiting to open
+	TSoftObjectPtr<UWorld> fightStage;
+	bool isFightPending;
+
+	//When StartFight was called, or 0 once the fight has started
+	double selectionSeconds;
+
+	//Has SelectCharacter or StartFight settled on characterClass
+	bool isCharacterSelected;
 };
@@ -0,0 +1,260 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FighterAI.h"
+
+namespace
+{
+	//The opponent's replies tried against each CPU action. Fewer than the CPU's own actions, as they only need to cover what can punish it.
+	const EFighterAIAction Replies[] =
+	{
+		EFighterAIAction::Wait,
+		EFighterAIAction::WalkForward,
+		EFighterAIAction::WalkBack,
+		EFighterAIAction::Jump,
+		EFighterAIAction::Attack1,
+		EFighterAIAction::Attack3
+	};
+
+	//Score weights, per raw fixed-point unit of health or meter, per frame of stun and per world unit out of range
+	constexpr int64 HealthWeight = 16;
+	constexpr int64 MeterWeight = 2;
+	constexpr int64 StunFrameWeight = 2000;
+	constexpr int64 RangeWeight = 20;
+
+	//Close enough for the default moves' strikes to reach
+	constexpr int32 PreferredRange = 90;
+
+	constexpr int32 KnockOutScore = MAX_int32 / 2;
+
+	struct FSearchContext
+	{
+		const FFighterAISettings& settings;
+		const FFighterAISearchLimits& limits;
+		int32 playerIndex;
+		int32 numNodes;
+		bool isOutOfBudget;
+	};
+
+	bool IsKnockedOut(const FSimMatchState& _state)
+	{
+		return _state.fighters[0].health <= FFixed::Zero() || _state.fighters[1].health <= FFixed::Zero();
+	}
+
+	int32 GetStuckFrames(const FSimFighterState& _fighter, int32 _frame)
+	{
+		return FMath::Max(FighterSim::GetStunFramesRemaining(_fighter, _frame), _fighter.timers.GetRemainingFrames(EFighterTimer::Launch, _frame));
+	}
+
+	//Counts a node and checks every limit. Once out of budget, the whole search unwinds without a result.
+	bool ConsumeNode(FSearchContext& _context)
+	{
+		++_context.numNodes;
+
+		const FFighterAISearchLimits& limits = _context.limits;
+		_context.isOutOfBudget = (_context.settings.maxNodesPerAction > 0 && _context.numNodes > _context.settings.maxNodesPerAction)
+			|| (limits.deadlineCycles != 0 && FPlatformTime::Cycles64() >= limits.deadlineCycles)
+			|| (limits.cancelFlag && FPlatformAtomics::AtomicRead(limits.cancelFlag) != 0);
+
+		return !_context.isOutOfBudget;
+	}
+
+	//Plays one CPU action and one reply side by side on _state. Stops early on a knock out.
+	void SimulatePair(const FSearchContext& _context, FSimMatchState& _state, EFighterAIAction _action, EFighterAIAction _reply)
+	{
+		const int32 cpuIndex = _context.playerIndex;
+		const FFighterInput towards[2] = { FighterAI::GetTowardOpponent(_state, 0), FighterAI::GetTowardOpponent(_state, 1) };
+		const EFighterAIAction actions[2] = { cpuIndex == 0 ? _action : _reply, cpuIndex == 0 ? _reply : _action };
+
+		for (int32 actionFrame = 0; actionFrame < _context.settings.actionFrames && !IsKnockedOut(_state); ++actionFrame)
+		{
+			FighterSim::Step(_state, FighterAI::GetActionInput(actions[0], actionFrame, towards[0]), FighterAI::GetActionInput(actions[1], actionFrame, towards[1]));
+		}
+	}
+
+	int32 EvaluateLeaf(const FSearchContext& _context, const FSimMatchState& _state)
+	{
+		FSimMatchState settled = _state;
+		for (int32 frame = 0; frame < _context.settings.settleFrames && !IsKnockedOut(settled); ++frame)
+		{
+			FighterSim::Step(settled, EFighterInput::None, EFighterInput::None);
+		}
+		return FighterAI::Evaluate(settled, _context.playerIndex);
+	}
+
+	int32 SearchActions(FSearchContext& _context, const FSimMatchState& _state, int32 _depth);
+
+	//The score of _action against the opponent's best reply. Stops as soon as a reply scores no better than _alpha, which the CPU already has.
+	int32 SearchReplies(FSearchContext& _context, const FSimMatchState& _state, EFighterAIAction _action, int32 _depth, int32 _alpha)
+	{
+		int32 worst = MAX_int32;
+
+		for (EFighterAIAction reply : Replies)
+		{
+			if (!ConsumeNode(_context))
+			{
+				return 0;
+			}
+
+			FSimMatchState child = _state;
+			SimulatePair(_context, child, _action, reply);
+
+			const int32 value = (_depth <= 1 || IsKnockedOut(child)) ? EvaluateLeaf(_context, child) : SearchActions(_context, child, _depth - 1);
+			if (_context.isOutOfBudget)
+			{
+				return 0;
+			}
+
+			worst = FMath::Min(worst, value);
+			if (worst <= _alpha)
+			{
+				break;
+			}
+		}
+		return worst;
+	}
+
+	int32 SearchActions(FSearchContext& _context, const FSimMatchState& _state, int32 _depth)
+	{
+		int32 best = MIN_int32;
+
+		for (int32 action = 0; action < FighterAI::NumActions; ++action)
+		{
+			best = FMath::Max(best, SearchReplies(_context, _state, (EFighterAIAction)action, _depth, best));
+			if (_context.isOutOfBudget)
+			{
+				return 0;
+			}
+		}
+		return best;
+	}
+}
+
+const TCHAR* FighterAI::GetActionName(EFighterAIAction _action)
+{
+	static const TCHAR* names[NumActions] = { TEXT("Wait"), TEXT("WalkForward"), TEXT("WalkBack"), TEXT("Jump"), TEXT("JumpForward"), TEXT("JumpBack"),
+		TEXT("Attack1"), TEXT("Attack2"), TEXT("Attack3"), TEXT("Attack4"), TEXT("Exceptional") };
+	return (int32)_action < NumActions ? names[(int32)_action] : TEXT("Invalid");
+}
+
+FFighterInput FighterAI::GetTowardOpponent(const FSimMatchState& _state, int32 _playerIndex)
+{
+	return _state.fighters[1 - _playerIndex].positionX > _state.fighters[_playerIndex].positionX ? EFighterInput::Right : EFighterInput::Left;
+}
+
+FFighterInput FighterAI::GetActionInput(EFighterAIAction _action, int32 _actionFrame, FFighterInput _toward)
+{
+	const FFighterInput away = _toward ^ (EFighterInput::Left | EFighterInput::Right);
+
+	//Buttons are only pressed on the first frame, so the same action can follow itself
+	const bool isFirstFrame = _actionFrame == 0;
+
+	switch (_action)
+	{
+	case EFighterAIAction::WalkForward:
+		return _toward;
+	case EFighterAIAction::WalkBack:
+		return away;
+	case EFighterAIAction::Jump:
+		return isFirstFrame ? EFighterInput::Up : EFighterInput::None;
+	case EFighterAIAction::JumpForward:
+		return (isFirstFrame ? EFighterInput::Up : EFighterInput::None) | _toward;
+	case EFighterAIAction::JumpBack:
+		return (isFirstFrame ? EFighterInput::Up : EFighterInput::None) | away;
+	case EFighterAIAction::Attack1:
+		return isFirstFrame ? EFighterInput::Attack1 : EFighterInput::None;
+	case EFighterAIAction::Attack2:
+		return isFirstFrame ? EFighterInput::Attack2 : EFighterInput::None;
+	case EFighterAIAction::Attack3:
+		return isFirstFrame ? EFighterInput::Attack3 : EFighterInput::None;
+	case EFighterAIAction::Attack4:
+		return isFirstFrame ? EFighterInput::Attack4 : EFighterInput::None;
+	case EFighterAIAction::Exceptional:
+		return isFirstFrame ? EFighterInput::Exceptional : EFighterInput::None;
+	default:
+		return EFighterInput::None;
+	}
+}
+
+int32 FighterAI::Evaluate(const FSimMatchState& _state, int32 _playerIndex)
+{
+	const FSimFighterState& fighter = _state.fighters[_playerIndex];
+	const FSimFighterState& opponent = _state.fighters[1 - _playerIndex];
+
+	if (opponent.health <= FFixed::Zero() || fighter.health <= FFixed::Zero())
+	{
+		return opponent.health <= FFixed::Zero() && fighter.health > FFixed::Zero() ? KnockOutScore : -KnockOutScore;
+	}
+
+	const int32 distance = FFixed::Abs(fighter.positionX - opponent.positionX).raw >> FFixed::FractionBits;
+
+	int64 score = (int64)(fighter.health - opponent.health).raw * HealthWeight;
+	score += (int64)(fighter.superMeter - opponent.superMeter).raw * MeterWeight;
+	score += (int64)(GetStuckFrames(opponent, _state.frame) - GetStuckFrames(fighter, _state.frame)) * StunFrameWeight;
+	score -= (int64)FMath::Abs(distance - PreferredRange) * RangeWeight;
+
+	return (int32)FMath::Clamp<int64>(score, -KnockOutScore + 1, KnockOutScore - 1);
+}
+
+void FighterAI::SearchAction(const FSimMatchState& _state, int32 _playerIndex, EFighterAIAction _action,
+	const FFighterAISettings& _settings, const FFighterAISearchLimits& _limits, FFighterAIActionResult& _outResult)
+{
+	FMemory::Memzero(&_outResult, sizeof(_outResult));
+
+	FSearchContext context = { _settings, _limits, _playerIndex, 0, false };
+	const int32 maxDepth = FMath::Clamp(_settings.maxDepth, 1, MaxDepth);
+
+	//Each depth is searched from scratch, so a search cut short still has the last depth it finished
+	for (int32 depth = 1; depth <= maxDepth; ++depth)
+	{
+		const int32 score = SearchReplies(context, _state, _action, depth, MIN_int32);
+		if (context.isOutOfBudget)
+		{
+			break;
+		}
+
+		_outResult.scores[depth - 1] = score;
+		_outResult.completedDepth = depth;
+	}
+
+	_outResult.numNodes = context.numNodes;
+}
+
+EFighterAIAction FighterAI::PickAction(const FFighterAIActionResult (&_results)[NumActions], int32& _outDepth)
+{
+	//Scores from different depths cannot be compared, so only the depth every action reached counts
+	int32 depth = MaxDepth;
+	for (const FFighterAIActionResult& result : _results)
+	{
+		depth = FMath::Min(depth, result.completedDepth);
+	}
+
+	_outDepth = depth;
+	if (depth == 0)
+	{
+		return EFighterAIAction::Wait;
+	}
+
+	//Ties go to the earlier action, so the same results always pick the same one
+	int32 bestAction = 0;
+	for (int32 action = 1; action < NumActions; ++action)
+	{
+		if (_results[action].scores[depth - 1] > _results[bestAction].scores[depth - 1])
+		{
+			bestAction = action;
+		}
+	}
+	return (EFighterAIAction)bestAction;
+}
+
+EFighterAIAction FighterAI::Search(const FSimMatchState& _state, int32 _playerIndex, const FFighterAISettings& _settings, const FFighterAISearchLimits& _limits)
+{
+	FFighterAIActionResult results[NumActions];
+	for (int32 action = 0; action < NumActions; ++action)
+	{
+		SearchAction(_state, _playerIndex, (EFighterAIAction)action, _settings, _limits, results[action]);
+	}
+
+	int32 depth = 0;
+	return PickAction(results, depth);
+}
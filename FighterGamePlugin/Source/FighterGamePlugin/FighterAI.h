@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FighterSimulation.h"
+
+/**
+ * Search for a CPU opponent, run on copies of the match state with FighterSim::Step and nothing else.
+ *
+ * The CPU picks from a small set of actions, each held for a few frames. Every action is tried against every reply
+ * the opponent could make, a few actions deep, and scored on the state it leads to. The CPU takes the action whose
+ * worst reply leaves it best off (maximin). Each first action is searched on its own with iterative deepening,
+ * so the actions can be spread over threads and stopped at any time with the deepest finished result kept.
+ */
+
+//What the CPU can do, each held for FFighterAISettings::actionFrames. Directions are relative to the opponent.
+enum class EFighterAIAction : uint8
+{
+	Wait,
+	WalkForward,
+
+	//Walking back also blocks attacks that get close
+	WalkBack,
+
+	Jump,
+	JumpForward,
+	JumpBack,
+	Attack1,
+	Attack2,
+	Attack3,
+	Attack4,
+
+	//Turns the move being done into its exceptional version
+	Exceptional,
+
+	Count
+};
+
+struct FFighterAISettings
+{
+	//How long each action is held
+	int32 actionFrames = 8;
+
+	//How many actions ahead to search, at most
+	int32 maxDepth = 3;
+
+	//Frames run with no input after the last action, so attacks still in startup get to land before scoring
+	int32 settleFrames = 12;
+
+	//The most action and reply pairs to simulate for one first action, or 0 for no limit. Unlike time, always gives the same result.
+	int32 maxNodesPerAction = 0;
+};
+
+//When a search has to stop, on top of the settings' node limit
+struct FFighterAISearchLimits
+{
+	//FPlatformTime::Cycles64() to stop at, or 0 for no deadline
+	uint64 deadlineCycles = 0;
+
+	//Stops the search when set to anything but 0, from any thread
+	const volatile int32* cancelFlag = nullptr;
+};
+
+struct FFighterAIActionResult
+{
+	static constexpr int32 MaxDepth = 8;
+
+	//The score of the action at each depth, higher is better for the CPU. Only the first completedDepth are filled in.
+	int32 scores[MaxDepth];
+	int32 completedDepth;
+
+	//Action and reply pairs simulated
+	int32 numNodes;
+};
+
+namespace FighterAI
+{
+	constexpr int32 NumActions = (int32)EFighterAIAction::Count;
+	constexpr int32 MaxDepth = FFighterAIActionResult::MaxDepth;
+
+	FIGHTERGAMEPLUGIN_API const TCHAR* GetActionName(EFighterAIAction _action);
+
+	//The direction toward the other fighter from fighter _playerIndex, EFighterInput::Right or EFighterInput::Left
+	FIGHTERGAMEPLUGIN_API FFighterInput GetTowardOpponent(const FSimMatchState& _state, int32 _playerIndex);
+
+	//The input for frame _actionFrame of _action, where 0 is the frame it starts, with _toward from GetTowardOpponent when it started
+	FIGHTERGAMEPLUGIN_API FFighterInput GetActionInput(EFighterAIAction _action, int32 _actionFrame, FFighterInput _toward);
+
+	//How good _state is for fighter _playerIndex. Health matters most, then stun, meter and being in range.
+	FIGHTERGAMEPLUGIN_API int32 Evaluate(const FSimMatchState& _state, int32 _playerIndex);
+
+	//Searches what happens when fighter _playerIndex starts with _action, deeper and deeper until maxDepth or a limit is reached
+	FIGHTERGAMEPLUGIN_API void SearchAction(const FSimMatchState& _state, int32 _playerIndex, EFighterAIAction _action,
+		const FFighterAISettings& _settings, const FFighterAISearchLimits& _limits, FFighterAIActionResult& _outResult);
+
+	//The best action at the deepest depth every action finished, or Wait if one of them did not finish any. _outDepth is that depth.
+	FIGHTERGAMEPLUGIN_API EFighterAIAction PickAction(const FFighterAIActionResult (&_results)[NumActions], int32& _outDepth);
+
+	//Searches every action on the calling thread and picks one
+	FIGHTERGAMEPLUGIN_API EFighterAIAction Search(const FSimMatchState& _state, int32 _playerIndex, const FFighterAISettings& _settings, const FFighterAISearchLimits& _limits);
+}
@@ -0,0 +1,247 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FighterAnimInstance.h"
+#include "Animation/AnimSequence.h"
+#include "Animation/AnimNodeBase.h"
+#include "Animation/AnimationPoseData.h"
+#include "FighterGamePluginCharacter.h"
+#include "FighterSimulation.h"
+#include "FighterGamePlugin.h"
+
+DECLARE_CYCLE_STAT(TEXT("Anim Move Pose Evaluate"), STAT_FighterMovePoseEvaluate, STATGROUP_Fighter);
+DECLARE_CYCLE_STAT(TEXT("Anim Move Pose Prewarm"), STAT_FighterMovePosePrewarm, STATGROUP_Fighter);
+
+FFighterPoseCache::FFighterPoseCache()
+{
+	capacity = 0;
+	useCount = 0;
+}
+
+void FFighterPoseCache::Reset(int32 _capacity)
+{
+	entries.Reset();
+	capacity = FMath::Max(_capacity, 1);
+	useCount = 0;
+}
+
+int32 FFighterPoseCache::FindEntry(const UAnimSequence* _sequence, int32 _frame) const
+{
+	//Small enough that a straight search beats hashing
+	for (int32 index = 0; index < entries.Num(); ++index)
+	{
+		if (entries[index].sequence == _sequence && entries[index].frame == _frame)
+		{
+			return index;
+		}
+	}
+	return INDEX_NONE;
+}
+
+bool FFighterPoseCache::Contains(const UAnimSequence* _sequence, int32 _frame) const
+{
+	return FindEntry(_sequence, _frame) != INDEX_NONE;
+}
+
+bool FFighterPoseCache::Find(const UAnimSequence* _sequence, int32 _frame, FPoseContext& _output)
+{
+	const int32 index = FindEntry(_sequence, _frame);
+	if (index == INDEX_NONE)
+	{
+		return false;
+	}
+
+	FEntry& entry = entries[index];
+	entry.lastUsed = ++useCount;
+	_output.Pose.CopyBonesFrom(entry.boneTransforms);
+	_output.Curve.CopyFrom(entry.curve);
+	return true;
+}
+
+void FFighterPoseCache::Add(const UAnimSequence* _sequence, int32 _frame, const FPoseContext& _pose)
+{
+	int32 index = FindEntry(_sequence, _frame);
+	if (index == INDEX_NONE && entries.Num() < capacity)
+	{
+		index = entries.AddDefaulted();
+	}
+	else if (index == INDEX_NONE)
+	{
+		//The least recently used pose makes way, keeping its arrays' memory
+		index = 0;
+		for (int32 candidate = 1; candidate < entries.Num(); ++candidate)
+		{
+			if (entries[candidate].lastUsed < entries[index].lastUsed)
+			{
+				index = candidate;
+			}
+		}
+	}
+
+	FEntry& entry = entries[index];
+	entry.sequence = _sequence;
+	entry.frame = _frame;
+	entry.lastUsed = ++useCount;
+	entry.boneTransforms.Reset(_pose.Pose.GetNumBones());
+	entry.boneTransforms.Append(_pose.Pose.GetBones());
+	entry.curve.CopyFrom(_pose.Curve);
+}
+
+FFighterAnimInstanceProxy::FFighterAnimInstanceProxy()
+{
+	cachedBoneContainerSerial = 0;
+	poseCacheCapacity = 1;
+	prewarmPosesPerEvaluation = 0;
+	prewarmMoveIndex = 0;
+	prewarmFrame = 0;
+	moveAnimation = nullptr;
+	moveFrame = 0;
+}
+
+FFighterAnimInstanceProxy::FFighterAnimInstanceProxy(UAnimInstance* _animInstance)
+	: FAnimInstanceProxy(_animInstance)
+{
+	cachedBoneContainerSerial = 0;
+	poseCacheCapacity = 1;
+	prewarmPosesPerEvaluation = 0;
+	prewarmMoveIndex = 0;
+	prewarmFrame = 0;
+	moveAnimation = nullptr;
+	moveFrame = 0;
+}
+
+void FFighterAnimInstanceProxy::Initialize(UAnimInstance* _animInstance)
+{
+	FAnimInstanceProxy::Initialize(_animInstance);
+
+	const UFighterAnimInstance* fighterAnimInstance = CastChecked<UFighterAnimInstance>(_animInstance);
+	moveAnimations.Reset();
+	for (const TPair<EFighterMoveId, UAnimSequence*>& moveAnimationPair : fighterAnimInstance->moveAnimations)
+	{
+		if (moveAnimationPair.Value)
+		{
+			moveAnimations.Add(moveAnimationPair.Key, moveAnimationPair.Value);
+		}
+	}
+	hotMoves = fighterAnimInstance->hotMoves;
+	poseCacheCapacity = fighterAnimInstance->poseCacheCapacity;
+	prewarmPosesPerEvaluation = fighterAnimInstance->prewarmPosesPerEvaluation;
+
+	poseCache.Reset(poseCacheCapacity);
+	cachedBoneContainerSerial = 0;
+	prewarmMoveIndex = 0;
+	prewarmFrame = 0;
+}
+
+void FFighterAnimInstanceProxy::PreUpdate(UAnimInstance* _animInstance, float _deltaSeconds)
+{
+	FAnimInstanceProxy::PreUpdate(_animInstance, _deltaSeconds);
+
+	//Read straight from the character, since this runs before NativeUpdateAnimation would get a chance to copy them.
+	//Only the frame the match is on now matters, however many frames were stepped or resimulated to get here.
+	UFighterAnimInstance* fighterAnimInstance = CastChecked<UFighterAnimInstance>(_animInstance);
+	if (const AFighterGamePluginCharacter* character = Cast<AFighterGamePluginCharacter>(fighterAnimInstance->TryGetPawnOwner()))
+	{
+		fighterAnimInstance->currentMove = character->currentMove;
+		fighterAnimInstance->currentMoveFrame = character->currentMoveFrame;
+	}
+
+	const UAnimSequence* const* sequence = moveAnimations.Find(fighterAnimInstance->currentMove);
+	moveAnimation = sequence ? *sequence : nullptr;
+	moveFrame = fighterAnimInstance->currentMoveFrame;
+}
+
+void FFighterAnimInstanceProxy::UpdateAnimationNode(const FAnimationUpdateContext& _context)
+{
+	//A move's pose does not depend on anything the graph would update
+	if (!moveAnimation)
+	{
+		FAnimInstanceProxy::UpdateAnimationNode(_context);
+	}
+}
+
+bool FFighterAnimInstanceProxy::Evaluate(FPoseContext& _output)
+{
+	const uint16 boneContainerSerial = GetRequiredBones().GetSerialNumber();
+	if (boneContainerSerial != cachedBoneContainerSerial)
+	{
+		poseCache.Reset(poseCacheCapacity);
+		cachedBoneContainerSerial = boneContainerSerial;
+		prewarmMoveIndex = 0;
+		prewarmFrame = 0;
+	}
+
+	if (!moveAnimation)
+	{
+		PrewarmHotMoves();
+		return false;
+	}
+
+	FIGHTER_SCOPE_CYCLE_COUNTER(MovePoseEvaluate);
+
+	if (!poseCache.Find(moveAnimation, moveFrame, _output))
+	{
+		EvaluateMoveFrame(moveAnimation, moveFrame, _output);
+		poseCache.Add(moveAnimation, moveFrame, _output);
+	}
+	return true;
+}
+
+void FFighterAnimInstanceProxy::EvaluateMoveFrame(const UAnimSequence* _sequence, int32 _frame, FPoseContext& _output) const
+{
+	const float time = FMath::Min((float)_frame / FighterSim::FramesPerSecond, _sequence->SequenceLength);
+
+	FAnimationPoseData poseData(_output);
+	_sequence->GetAnimationPose(poseData, FAnimExtractContext(time, false));
+}
+
+void FFighterAnimInstanceProxy::PrewarmHotMoves()
+{
+	//Poses are only prewarmed into free space, never in place of ones in use
+	if (prewarmPosesPerEvaluation <= 0 || prewarmMoveIndex >= hotMoves.Num() || poseCache.Num() >= poseCache.GetCapacity())
+	{
+		return;
+	}
+
+	FIGHTER_SCOPE_CYCLE_COUNTER(MovePosePrewarm);
+
+	FPoseContext pose(this);
+	int32 numPrewarmed = 0;
+	while (numPrewarmed < prewarmPosesPerEvaluation && prewarmMoveIndex < hotMoves.Num() && poseCache.Num() < poseCache.GetCapacity())
+	{
+		const UAnimSequence* const* sequence = moveAnimations.Find(hotMoves[prewarmMoveIndex]);
+		const int32 lastFrame = sequence ? FMath::FloorToInt((*sequence)->SequenceLength * FighterSim::FramesPerSecond) : INDEX_NONE;
+		if (prewarmFrame > lastFrame)
+		{
+			++prewarmMoveIndex;
+			prewarmFrame = 0;
+			continue;
+		}
+
+		if (!poseCache.Contains(*sequence, prewarmFrame))
+		{
+			EvaluateMoveFrame(*sequence, prewarmFrame, pose);
+			poseCache.Add(*sequence, prewarmFrame, pose);
+			++numPrewarmed;
+		}
+		++prewarmFrame;
+	}
+}
+
+UFighterAnimInstance::UFighterAnimInstance()
+{
+	poseCacheCapacity = 96;
+	prewarmPosesPerEvaluation = 2;
+	currentMove = EFighterMoveId::MV_None;
+	currentMoveFrame = 0;
+}
+
+FAnimInstanceProxy* UFighterAnimInstance::CreateAnimInstanceProxy()
+{
+	return new FFighterAnimInstanceProxy(this);
+}
+
+void UFighterAnimInstance::DestroyAnimInstanceProxy(FAnimInstanceProxy* _proxy)
+{
+	delete static_cast<FFighterAnimInstanceProxy*>(_proxy);
+}
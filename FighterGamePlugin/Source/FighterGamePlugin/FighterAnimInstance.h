@@ -0,0 +1,144 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "FighterMoveSetAsset.h"
+#include "FighterAnimInstance.generated.h"
+
+class UAnimSequence;
+class AFighterGamePluginCharacter;
+
+/**
+ * The most recently used poses of move animations, by animation and frame, in local space for one bone container.
+ * Never holds more than its capacity: the least recently used pose makes way, and its memory is reused for the new one.
+ */
+class FIGHTERGAMEPLUGIN_API FFighterPoseCache
+{
+public:
+	FFighterPoseCache();
+
+	//Empties the cache, which then holds at most _capacity poses
+	void Reset(int32 _capacity);
+
+	//Copies the pose of _sequence at _frame into _output and returns true if it is cached
+	bool Find(const UAnimSequence* _sequence, int32 _frame, FPoseContext& _output);
+
+	bool Contains(const UAnimSequence* _sequence, int32 _frame) const;
+
+	//Caches _pose as _sequence at _frame, in place of the least recently used pose if the cache is full
+	void Add(const UAnimSequence* _sequence, int32 _frame, const FPoseContext& _pose);
+
+	int32 Num() const { return entries.Num(); }
+	int32 GetCapacity() const { return capacity; }
+
+private:
+	struct FEntry
+	{
+		const UAnimSequence* sequence;
+		int32 frame;
+
+		//useCount when the pose was last found or added
+		uint64 lastUsed;
+
+		TArray<FTransform> boneTransforms;
+		FBlendedCurve curve;
+	};
+
+	int32 FindEntry(const UAnimSequence* _sequence, int32 _frame) const;
+
+	TArray<FEntry> entries;
+	int32 capacity;
+	uint64 useCount;
+};
+
+/**
+ * Evaluates a fighter's pose. While the fighter is doing a move that has an animation, the pose is that animation at the
+ * move's frame, straight from the gameplay state: it never plays on by itself, so after a rollback or a replay seek the
+ * pose is simply the one for the frame the match is now on. The anim graph is then neither updated nor evaluated, and
+ * the pose comes from the cache whenever it can. Otherwise the anim graph runs as usual.
+ */
+USTRUCT()
+struct FIGHTERGAMEPLUGIN_API FFighterAnimInstanceProxy : public FAnimInstanceProxy
+{
+	GENERATED_BODY()
+
+public:
+	FFighterAnimInstanceProxy();
+	FFighterAnimInstanceProxy(UAnimInstance* _animInstance);
+
+	virtual void Initialize(UAnimInstance* _animInstance) override;
+	virtual void PreUpdate(UAnimInstance* _animInstance, float _deltaSeconds) override;
+	virtual void UpdateAnimationNode(const FAnimationUpdateContext& _context) override;
+	virtual bool Evaluate(FPoseContext& _output) override;
+
+private:
+	//Extracts _sequence at _frame into _output
+	void EvaluateMoveFrame(const UAnimSequence* _sequence, int32 _frame, FPoseContext& _output) const;
+
+	//Caches up to prewarmPosesPerEvaluation frames of the hot moves that are not cached yet
+	void PrewarmHotMoves();
+
+	FFighterPoseCache poseCache;
+
+	//The bone container the cached poses were made for. They are thrown away when it changes, such as on an LOD change.
+	uint16 cachedBoneContainerSerial;
+
+	//Copied from the anim instance when it is initialized
+	TMap<EFighterMoveId, const UAnimSequence*> moveAnimations;
+	TArray<EFighterMoveId> hotMoves;
+	int32 poseCacheCapacity;
+	int32 prewarmPosesPerEvaluation;
+
+	//Where prewarming got to, as an index into hotMoves and a frame of that move's animation
+	int32 prewarmMoveIndex;
+	int32 prewarmFrame;
+
+	//The move animation to show and its frame, read from the character in PreUpdate. Null while the anim graph runs.
+	const UAnimSequence* moveAnimation;
+	int32 moveFrame;
+};
+
+/**
+ * The base for fighter animation blueprints. Moves with an animation in moveAnimations are posed straight from the
+ * character's currentMove and currentMoveFrame, see FFighterAnimInstanceProxy. Hitboxes and hurtboxes come from the
+ * move data in the simulation and never from the pose, so how or whether the pose is evaluated cannot change a fight.
+ */
+UCLASS(Transient, Blueprintable)
+class FIGHTERGAMEPLUGIN_API UFighterAnimInstance : public UAnimInstance
+{
+	GENERATED_BODY()
+
+public:
+	UFighterAnimInstance();
+
+	//The animation shown during each move, played at one animation frame per simulation frame from the move's first frame
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Moves")
+		TMap<EFighterMoveId, UAnimSequence*> moveAnimations;
+
+	//Moves whose frames are cached ahead of being needed, a few each evaluation, most used first
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Moves")
+		TArray<EFighterMoveId> hotMoves;
+
+	//The most poses kept ready for each fighter
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Moves", meta = (ClampMin = "1"))
+		int32 poseCacheCapacity;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Moves", meta = (ClampMin = "0"))
+		int32 prewarmPosesPerEvaluation;
+
+	//The fighter's move and the frame of it, copied from the character by the proxy at the start of every update
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Moves")
+		EFighterMoveId currentMove;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Moves")
+		int32 currentMoveFrame;
+
+protected:
+	virtual FAnimInstanceProxy* CreateAnimInstanceProxy() override;
+	virtual void DestroyAnimInstanceProxy(FAnimInstanceProxy* _proxy) override;
+
+	friend struct FFighterAnimInstanceProxy;
+};
@@ -0,0 +1,137 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FighterCamera.h"
+#include "Camera/CameraComponent.h"
+#include "FighterGamePluginCharacter.h"
+#include "FighterGamePlugin.h"
+
+DECLARE_CYCLE_STAT(TEXT("Fight Camera Update"), STAT_FighterCameraUpdate, STATGROUP_Fighter);
+
+namespace
+{
+	//Side on to the stage, which runs along world Y, as the characters' camera booms used to be
+	const FRotator FightShotRotation(0.0f, 180.0f, 0.0f);
+}
+
+AFighterCamera::AFighterCamera()
+{
+	//Updated by the game mode after the characters move, so it never ticks itself
+	PrimaryActorTick.bCanEverTick = false;
+
+	//The game mode makes it every player's view target when the match starts
+	AutoActivateForPlayer = EAutoReceiveInput::Disabled;
+
+	fieldOfView = 90.0f;
+	framingMargin = 150.0f;
+	minDistance = 500.0f;
+	maxDistance = 1100.0f;
+	heightOffset = 75.0f;
+	verticalFollow = 0.5f;
+	followSpeed = 8.0f;
+
+	superFieldOfView = 60.0f;
+	superDistance = 300.0f;
+	superSideOffset = 120.0f;
+	superHeightOffset = 40.0f;
+	superYaw = 20.0f;
+	superBlendSeconds = 0.25f;
+
+	player1 = nullptr;
+	player2 = nullptr;
+	stageOrigin = FVector::ZeroVector;
+	fightShotLocation = FVector::ZeroVector;
+	superFighterIndex = INDEX_NONE;
+	superCameraBlend = 0.0f;
+}
+
+void AFighterCamera::StartMatch(AFighterGamePluginCharacter* _player1, AFighterGamePluginCharacter* _player2, const FSimMatchState& _state)
+{
+	player1 = _player1;
+	player2 = _player2;
+
+	const FVector player1Origin = player1->GetSimulationOrigin();
+	const FVector player2Origin = player2->GetSimulationOrigin();
+	stageOrigin = FVector((player1Origin.X + player2Origin.X) * 0.5f, 0.0f, FMath::Min(player1Origin.Z, player2Origin.Z));
+
+	superFighterIndex = INDEX_NONE;
+	superCameraBlend = 0.0f;
+
+	fightShotLocation = GetFightShotLocation(_state);
+	SetActorLocationAndRotation(fightShotLocation, FightShotRotation);
+	GetCameraComponent()->SetFieldOfView(fieldOfView);
+}
+
+FVector AFighterCamera::GetFightShotLocation(const FSimMatchState& _state) const
+{
+	const FVector player1Location = player1->GetActorLocation();
+	const FVector player2Location = player2->GetActorLocation();
+	const float tanHalfFieldOfView = FMath::Tan(FMath::DegreesToRadians(fieldOfView * 0.5f));
+
+	//Far enough back for both fighters and a margin either side to fit across the shot
+	const float separation = FMath::Abs(player1Location.Y - player2Location.Y);
+	const float distance = FMath::Clamp((separation * 0.5f + framingMargin) / tanHalfFieldOfView, minDistance, maxDistance);
+
+	//Slid along so the shot stops the margin past the walls, or centred on the stage if it is narrower than the shot
+	const float visibleHalfWidth = distance * tanHalfFieldOfView;
+	const float stageLeftY = _state.stageLeftX.ToFloat() - framingMargin;
+	const float stageRightY = _state.stageRightX.ToFloat() + framingMargin;
+	const float midpointY = (player1Location.Y + player2Location.Y) * 0.5f;
+	const float y = visibleHalfWidth * 2.0f < stageRightY - stageLeftY
+		? FMath::Clamp(midpointY, stageLeftY + visibleHalfWidth, stageRightY - visibleHalfWidth)
+		: (stageLeftY + stageRightY) * 0.5f;
+
+	const float highestAboveGround = FMath::Max(FMath::Max(player1Location.Z, player2Location.Z) - stageOrigin.Z, 0.0f);
+	const float z = stageOrigin.Z + heightOffset + highestAboveGround * verticalFollow;
+
+	return FVector(stageOrigin.X + distance, y, z);
+}
+
+void AFighterCamera::UpdateCamera(float _deltaSeconds, const FSimMatchState& _state)
+{
+	FIGHTER_SCOPE_CYCLE_COUNTER(CameraUpdate);
+
+	if (!player1 || !player2)
+	{
+		return;
+	}
+
+	fightShotLocation = followSpeed > 0.0f ? FMath::VInterpTo(fightShotLocation, GetFightShotLocation(_state), _deltaSeconds, followSpeed) : GetFightShotLocation(_state);
+
+	//A new super takes the shot, even from one still blending out
+	int32 activeSuperFighterIndex = INDEX_NONE;
+	for (int32 playerIndex = 0; playerIndex < 2; ++playerIndex)
+	{
+		if (_state.fighters[playerIndex].move == EFighterMove::Super)
+		{
+			activeSuperFighterIndex = playerIndex;
+		}
+	}
+	if (activeSuperFighterIndex != INDEX_NONE)
+	{
+		superFighterIndex = activeSuperFighterIndex;
+	}
+
+	const float blendStep = superBlendSeconds > 0.0f ? _deltaSeconds / superBlendSeconds : 1.0f;
+	superCameraBlend = FMath::Clamp(superCameraBlend + (activeSuperFighterIndex != INDEX_NONE ? blendStep : -blendStep), 0.0f, 1.0f);
+
+	if (superCameraBlend <= 0.0f || superFighterIndex == INDEX_NONE)
+	{
+		superFighterIndex = INDEX_NONE;
+		SetActorLocationAndRotation(fightShotLocation, FightShotRotation);
+		GetCameraComponent()->SetFieldOfView(fieldOfView);
+		return;
+	}
+
+	const FVector attackerLocation = (superFighterIndex == 0 ? player1 : player2)->GetActorLocation();
+	const FVector defenderLocation = (superFighterIndex == 0 ? player2 : player1)->GetActorLocation();
+	const float towardsDefender = defenderLocation.Y >= attackerLocation.Y ? 1.0f : -1.0f;
+
+	const FVector superShotLocation(stageOrigin.X + superDistance, attackerLocation.Y + towardsDefender * superSideOffset, attackerLocation.Z + superHeightOffset);
+	const FRotator superShotRotation(0.0f, FightShotRotation.Yaw - towardsDefender * superYaw, 0.0f);
+
+	const float blend = FMath::InterpEaseInOut(0.0f, 1.0f, superCameraBlend, 2.0f);
+	SetActorLocationAndRotation(FMath::Lerp(fightShotLocation, superShotLocation, blend),
+		FQuat::Slerp(FightShotRotation.Quaternion(), superShotRotation.Quaternion(), blend));
+	GetCameraComponent()->SetFieldOfView(FMath::Lerp(fieldOfView, superFieldOfView, blend));
+}
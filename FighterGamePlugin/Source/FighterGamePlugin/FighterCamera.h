@@ -0,0 +1,104 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Camera/CameraActor.h"
+#include "FighterSimulation.h"
+#include "FighterCamera.generated.h"
+
+class AFighterGamePluginCharacter;
+
+/**
+ * The one camera of a fight. It looks at the stage side on, centred between the fighters and far enough back to fit both,
+ * never shows more than a margin past the stage's walls, and cuts in close on whoever starts a super.
+ *
+ * It never ticks itself: the game mode updates it once per frame after the characters have been moved, so it is always
+ * framing where they are drawn. A camera placed in the level is used if there is one, otherwise the game mode spawns one.
+ */
+UCLASS()
+class FIGHTERGAMEPLUGIN_API AFighterCamera : public ACameraActor
+{
+	GENERATED_BODY()
+
+public:
+	AFighterCamera();
+
+	//Frame _player1 and _player2 from now on, cutting straight to the shot of _state
+	void StartMatch(AFighterGamePluginCharacter* _player1, AFighterGamePluginCharacter* _player2, const FSimMatchState& _state);
+
+	//Follow the fighters, and blend to or from the super shot if a fighter started or finished a super in _state
+	void UpdateCamera(float _deltaSeconds, const FSimMatchState& _state);
+
+	//How far the super shot is blended in, from 0 to 1
+	UFUNCTION(BlueprintPure, Category = "Fight Camera")
+		float GetSuperCameraBlend() const { return superCameraBlend; }
+
+	//The horizontal field of view of the fight shot
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fight Camera")
+		float fieldOfView;
+
+	//Space kept between each fighter and the side of the shot, and shown past the stage's walls
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fight Camera")
+		float framingMargin;
+
+	//The closest and furthest the camera gets from the fighters, whatever their separation
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fight Camera")
+		float minDistance;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fight Camera")
+		float maxDistance;
+
+	//How far above the fighters' starting height the camera sits
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fight Camera")
+		float heightOffset;
+
+	//How much of the higher fighter's height above the ground the camera rises by, so jumps stay in shot without losing the floor
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fight Camera", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+		float verticalFollow;
+
+	//How quickly the camera catches up with the fighters. 0 follows them exactly.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fight Camera")
+		float followSpeed;
+
+	//The super shot, relative to the fighter doing the super. Its side offset and yaw are towards the opponent.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Super Camera")
+		float superFieldOfView;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Super Camera")
+		float superDistance;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Super Camera")
+		float superSideOffset;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Super Camera")
+		float superHeightOffset;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Super Camera")
+		float superYaw;
+
+	//How long blending into or out of the super shot takes
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Super Camera")
+		float superBlendSeconds;
+
+protected:
+	//Where the fight shot wants to be this frame, before smoothing
+	FVector GetFightShotLocation(const FSimMatchState& _state) const;
+
+	UPROPERTY(Transient)
+		AFighterGamePluginCharacter* player1;
+
+	UPROPERTY(Transient)
+		AFighterGamePluginCharacter* player2;
+
+	//The stage plane's X and the ground's Z, from where the fighters started. The simulation's stage positions are world Y.
+	FVector stageOrigin;
+
+	//The fight shot after smoothing
+	FVector fightShotLocation;
+
+	//The fighter the super shot is on, kept while it blends out
+	int32 superFighterIndex;
+
+	float superCameraBlend;
+};
@@ -0,0 +1,141 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FighterCollision.h"
+#include "FighterMovement.h"
+
+namespace
+{
+	//Orders hits by type, then attacker, then position, then box index for ties
+	bool IsHitBefore(const FFighterHitboxTable& _table, const FSimHit& _a, const FSimHit& _b)
+	{
+		if (_a.type != _b.type)
+		{
+			return _a.type < _b.type;
+		}
+		if (_a.attackerIndex != _b.attackerIndex)
+		{
+			return _a.attackerIndex < _b.attackerIndex;
+		}
+		if (_table.attackMinX[_a.attackBox] != _table.attackMinX[_b.attackBox])
+		{
+			return _table.attackMinX[_a.attackBox] < _table.attackMinX[_b.attackBox];
+		}
+		return _a.attackBox < _b.attackBox;
+	}
+}
+
+bool FFighterHitboxTable::AddAttackBox(int32 _ownerIndex, ESimHitboxType _type, FFixed _centerX, FFixed _centerZ, FFixed _halfWidth, FFixed _halfHeight,
+	FFixed _damage, int32 _hitstunFrames, int32 _blockstunFrames, FFixed _pushback, int32 _userData)
+{
+	check(_type != ESimHitboxType::Hurtbox);
+
+	if (numAttackBoxes == MaxBoxes)
+	{
+		return false;
+	}
+
+	const int32 box = numAttackBoxes++;
+	attackMinX[box] = (_centerX - _halfWidth).raw;
+	attackMaxX[box] = (_centerX + _halfWidth).raw;
+	attackMinZ[box] = (_centerZ - _halfHeight).raw;
+	attackMaxZ[box] = (_centerZ + _halfHeight).raw;
+	attackOwner[box] = (uint8)_ownerIndex;
+	attackType[box] = _type;
+	attackDamage[box] = _damage;
+	attackHitstunFrames[box] = _hitstunFrames;
+	attackBlockstunFrames[box] = _blockstunFrames;
+	attackPushback[box] = _pushback;
+	attackUserData[box] = _userData;
+	return true;
+}
+
+bool FFighterHitboxTable::AddHurtbox(int32 _ownerIndex, FFixed _centerX, FFixed _centerZ, FFixed _halfWidth, FFixed _halfHeight)
+{
+	if (numHurtboxes == MaxBoxes)
+	{
+		return false;
+	}
+
+	const int32 box = numHurtboxes++;
+	hurtMinX[box] = (_centerX - _halfWidth).raw;
+	hurtMaxX[box] = (_centerX + _halfWidth).raw;
+	hurtMinZ[box] = (_centerZ - _halfHeight).raw;
+	hurtMaxZ[box] = (_centerZ + _halfHeight).raw;
+	hurtOwner[box] = (uint8)_ownerIndex;
+	return true;
+}
+
+bool FFighterHitboxTable::AddBodyHurtbox(int32 _ownerIndex, const FSimFighterState& _fighter, const FFighterMovementParams& _movement)
+{
+	//The position is at the fighter's feet, so the body's centre is half its height above it
+	return AddHurtbox(_ownerIndex, _fighter.positionX, _fighter.positionZ + _movement.pushboxHalfHeight, _movement.pushboxHalfWidth, _movement.pushboxHalfHeight);
+}
+
+int32 FighterCollision::FindHits(const FFighterHitboxTable& _table, FSimHit* _outHits)
+{
+	int32 numHits = 0;
+
+	for (int32 attackBox = 0; attackBox < _table.numAttackBoxes; ++attackBox)
+	{
+		const int32 minX = _table.attackMinX[attackBox];
+		const int32 maxX = _table.attackMaxX[attackBox];
+		const int32 minZ = _table.attackMinZ[attackBox];
+		const int32 maxZ = _table.attackMaxZ[attackBox];
+		const uint8 owner = _table.attackOwner[attackBox];
+
+		//No early out or branches, so this vectorizes across the hurtboxes
+		int32 overlaps = 0;
+		for (int32 hurtbox = 0; hurtbox < _table.numHurtboxes; ++hurtbox)
+		{
+			overlaps |= (int32)(minX <= _table.hurtMaxX[hurtbox]) & (int32)(_table.hurtMinX[hurtbox] <= maxX)
+				& (int32)(minZ <= _table.hurtMaxZ[hurtbox]) & (int32)(_table.hurtMinZ[hurtbox] <= maxZ)
+				& (int32)(_table.hurtOwner[hurtbox] != owner);
+		}
+
+		if (overlaps)
+		{
+			FSimHit& hit = _outHits[numHits++];
+			hit.type = _table.attackType[attackBox];
+			hit.attackerIndex = owner;
+			hit.defenderIndex = (uint8)(1 - owner);
+			hit.attackBox = attackBox;
+		}
+	}
+
+	//At most MaxBoxes hits, so an insertion sort on the output is all that is needed
+	for (int32 index = 1; index < numHits; ++index)
+	{
+		const FSimHit hit = _outHits[index];
+		int32 insertAt = index;
+		while (insertAt > 0 && IsHitBefore(_table, hit, _outHits[insertAt - 1]))
+		{
+			_outHits[insertAt] = _outHits[insertAt - 1];
+			--insertAt;
+		}
+		_outHits[insertAt] = hit;
+	}
+
+	return numHits;
+}
+
+void FighterCollision::ApplyHits(FSimMatchState& _state, const FFighterHitboxTable& _table, const FSimHit* _hits, int32 _numHits)
+{
+	bool hasStruck[2] = { false, false };
+
+	for (int32 index = 0; index < _numHits; ++index)
+	{
+		const FSimHit& hit = _hits[index];
+
+		if (hit.type == ESimHitboxType::Proximity)
+		{
+			FighterSim::CollideWithProximityHitbox(_state.fighters[hit.defenderIndex]);
+		}
+		else if (!hasStruck[hit.attackerIndex])
+		{
+			hasStruck[hit.attackerIndex] = true;
+			FighterSim::ApplyHit(_state, hit.defenderIndex, _table.attackDamage[hit.attackBox],
+				_table.attackHitstunFrames[hit.attackBox], _table.attackBlockstunFrames[hit.attackBox], _table.attackPushback[hit.attackBox]);
+		}
+	}
+}
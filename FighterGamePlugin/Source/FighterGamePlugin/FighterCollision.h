@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FighterSimulation.h"
+
+struct FFighterMovementParams;
+
+//Mirrors EHitboxEnum value for value so the simulation does not depend on the reflected enum
+enum class ESimHitboxType : uint8
+{
+	Proximity,
+	Strike,
+	Hurtbox
+};
+
+/**
+ * Every active box of a frame as 2D AABBs in simulation space (stage X and height Z, raw 16.16 fixed point).
+ *
+ * Stored as structure-of-arrays with attack boxes and hurtboxes apart, so the overlap test of one attack box
+ * against all hurtboxes is a straight loop over four int arrays that the compiler vectorizes.
+ */
+struct FFighterHitboxTable
+{
+	static constexpr int32 MaxBoxes = 64;
+
+	//Proximity and strike boxes
+	int32 numAttackBoxes;
+	int32 attackMinX[MaxBoxes];
+	int32 attackMaxX[MaxBoxes];
+	int32 attackMinZ[MaxBoxes];
+	int32 attackMaxZ[MaxBoxes];
+	uint8 attackOwner[MaxBoxes];
+	ESimHitboxType attackType[MaxBoxes];
+	FFixed attackDamage[MaxBoxes];
+	int32 attackHitstunFrames[MaxBoxes];
+	int32 attackBlockstunFrames[MaxBoxes];
+	FFixed attackPushback[MaxBoxes];
+
+	//Whatever the caller wants back with each hit, like the index of the actor the box came from
+	int32 attackUserData[MaxBoxes];
+
+	int32 numHurtboxes;
+	int32 hurtMinX[MaxBoxes];
+	int32 hurtMaxX[MaxBoxes];
+	int32 hurtMinZ[MaxBoxes];
+	int32 hurtMaxZ[MaxBoxes];
+	uint8 hurtOwner[MaxBoxes];
+
+	void Reset()
+	{
+		numAttackBoxes = 0;
+		numHurtboxes = 0;
+	}
+
+	//Returns false if the table is full
+	bool AddAttackBox(int32 _ownerIndex, ESimHitboxType _type, FFixed _centerX, FFixed _centerZ, FFixed _halfWidth, FFixed _halfHeight,
+		FFixed _damage, int32 _hitstunFrames, int32 _blockstunFrames, FFixed _pushback, int32 _userData);
+
+	//Returns false if the table is full
+	bool AddHurtbox(int32 _ownerIndex, FFixed _centerX, FFixed _centerZ, FFixed _halfWidth, FFixed _halfHeight);
+
+	//Adds the body of fighter _ownerIndex as a hurtbox, the size of their pushbox and standing on their position. Every fighter has one, whatever their move adds.
+	bool AddBodyHurtbox(int32 _ownerIndex, const FSimFighterState& _fighter, const FFighterMovementParams& _movement);
+};
+
+//One attack box overlapping the other fighter's hurtboxes
+struct FSimHit
+{
+	ESimHitboxType type;
+	uint8 attackerIndex;
+	uint8 defenderIndex;
+
+	//Index into the table's attack box arrays
+	int32 attackBox;
+};
+
+namespace FighterCollision
+{
+	constexpr int32 MaxHits = FFighterHitboxTable::MaxBoxes;
+
+	/**
+	 * Finds every attack box touching a hurtbox of the other fighter, one hit per box however many hurtboxes it touches.
+	 * The hits come back sorted: proximity before strike so blocking is decided first, then by attacker, then left to right,
+	 * so the result depends only on the boxes and never on the order they were added or on engine overlap events.
+	 */
+	FIGHTERGAMEPLUGIN_API int32 FindHits(const FFighterHitboxTable& _table, FSimHit* _outHits);
+
+	/**
+	 * Applies a frame's sorted hits: proximity boxes make the defender block if they are holding back,
+	 * and each attacker's first strike deals its damage. Later strikes from the same attacker that frame are part of the same attack.
+	 */
+	FIGHTERGAMEPLUGIN_API void ApplyHits(FSimMatchState& _state, const FFighterHitboxTable& _table, const FSimHit* _hits, int32 _numHits);
+}
@@ -0,0 +1,247 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FighterCommandMatcher.h"
+
+namespace
+{
+	//Returns the symbol for a single-bit input, or INDEX_NONE
+	int32 GetSymbol(FFighterInput _input)
+	{
+		if (_input == 0 || (_input & (_input - 1)) != 0)
+		{
+			return INDEX_NONE;
+		}
+
+		const int32 symbol = (int32)FPlatformMath::CountTrailingZeros(_input);
+		return symbol < FFighterCommandMatcher::NumSymbols ? symbol : INDEX_NONE;
+	}
+}
+
+FFighterCommandMatcher::FFighterCommandMatcher()
+{
+	isCompiled = false;
+
+	//The root node
+	AddNode(0);
+}
+
+int32 FFighterCommandMatcher::AddNode(int32 _depth)
+{
+	const int32 node = nodeDepths.Add(_depth);
+
+	for (int32 symbol = 0; symbol < NumSymbols; ++symbol)
+	{
+		transitions.Add(INDEX_NONE);
+	}
+	failLinks.Add(0);
+
+	return node;
+}
+
+int32 FFighterCommandMatcher::AddCommand(const FFighterInput* _steps, const int32* _frameWindows, int32 _numSteps, int32 _priority)
+{
+	check(!isCompiled);
+
+	if (_numSteps <= 0 || _numSteps > MaxCommandLength)
+	{
+		return INDEX_NONE;
+	}
+
+	for (int32 step = 0; step < _numSteps; ++step)
+	{
+		if (GetSymbol(_steps[step]) == INDEX_NONE)
+		{
+			return INDEX_NONE;
+		}
+	}
+
+	int32 node = 0;
+	for (int32 step = 0; step < _numSteps; ++step)
+	{
+		const int32 edge = node * NumSymbols + GetSymbol(_steps[step]);
+		if (transitions[edge] == INDEX_NONE)
+		{
+			const int32 child = AddNode(step + 1);
+			transitions[edge] = child;
+		}
+		node = transitions[edge];
+	}
+
+	const int32 command = commandNodes.Add(node);
+	commandPriorities.Add(_priority);
+	commandLengths.Add(_numSteps);
+	commandWindowStarts.Add(commandWindows.Num());
+	for (int32 step = 0; step < _numSteps; ++step)
+	{
+		commandWindows.Add(step == 0 ? 0 : _frameWindows[step]);
+	}
+
+	return command;
+}
+
+void FFighterCommandMatcher::Compile()
+{
+	check(!isCompiled);
+
+	//Visit the trie breadth first so every failure link points at a node that is already complete
+	TArray<int32> queue;
+	queue.Reserve(GetNumNodes());
+
+	for (int32 symbol = 0; symbol < NumSymbols; ++symbol)
+	{
+		int32& child = transitions[symbol];
+		if (child == INDEX_NONE)
+		{
+			child = 0;
+		}
+		else
+		{
+			failLinks[child] = 0;
+			queue.Add(child);
+		}
+	}
+
+	for (int32 queueIndex = 0; queueIndex < queue.Num(); ++queueIndex)
+	{
+		const int32 node = queue[queueIndex];
+
+		for (int32 symbol = 0; symbol < NumSymbols; ++symbol)
+		{
+			const int32 fallback = transitions[failLinks[node] * NumSymbols + symbol];
+			int32& child = transitions[node * NumSymbols + symbol];
+
+			//Missing edges jump straight to where the failure link would go, which turns the trie into a DFA
+			if (child == INDEX_NONE)
+			{
+				child = fallback;
+			}
+			else
+			{
+				failLinks[child] = fallback;
+				queue.Add(child);
+			}
+		}
+	}
+
+	//Each node outputs its own commands plus everything its failure link outputs
+	outputStarts.SetNumZeroed(GetNumNodes());
+	outputCounts.SetNumZeroed(GetNumNodes());
+
+	auto addOutputs = [this](int32 _node)
+	{
+		const int32 start = outputCommands.Num();
+
+		for (int32 command = 0; command < commandNodes.Num(); ++command)
+		{
+			if (commandNodes[command] == _node)
+			{
+				outputCommands.Add(command);
+			}
+		}
+
+		if (_node != 0)
+		{
+			const int32 failNode = failLinks[_node];
+			for (int32 output = 0; output < outputCounts[failNode]; ++output)
+			{
+				outputCommands.Add(outputCommands[outputStarts[failNode] + output]);
+			}
+		}
+
+		//Highest priority first, then in the order the commands were added
+		for (int32 sorted = start + 1; sorted < outputCommands.Num(); ++sorted)
+		{
+			const int32 command = outputCommands[sorted];
+			int32 insertAt = sorted;
+			while (insertAt > start && commandPriorities[outputCommands[insertAt - 1]] < commandPriorities[command])
+			{
+				outputCommands[insertAt] = outputCommands[insertAt - 1];
+				--insertAt;
+			}
+			outputCommands[insertAt] = command;
+		}
+
+		outputStarts[_node] = start;
+		outputCounts[_node] = outputCommands.Num() - start;
+	};
+
+	addOutputs(0);
+	for (const int32 node : queue)
+	{
+		addOutputs(node);
+	}
+
+	isCompiled = true;
+}
+
+void FFighterCommandMatcher::ResetState(FState& _state)
+{
+	FMemory::Memzero(&_state, sizeof(_state));
+}
+
+bool FFighterCommandMatcher::IsWithinFrameWindows(const FState& _state, int32 _command) const
+{
+	const int32 length = commandLengths[_command];
+	const int32* windows = &commandWindows[commandWindowStarts[_command]];
+
+	if (length > _state.numPresses)
+	{
+		return false;
+	}
+
+	const int32 firstPress = _state.numPresses - length;
+	for (int32 step = 1; step < length; ++step)
+	{
+		const int32 previousFrame = _state.pressFrames[(firstPress + step - 1) & (MaxCommandLength - 1)];
+		const int32 frame = _state.pressFrames[(firstPress + step) & (MaxCommandLength - 1)];
+		if (frame - previousFrame > windows[step])
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int32 FFighterCommandMatcher::Advance(FState& _state, FFighterInput _pressed, int32 _frame, int32* _outCommands) const
+{
+	check(isCompiled);
+
+	int32 numMatches = 0;
+
+	uint32 remaining = _pressed;
+	while (remaining != 0)
+	{
+		const int32 symbol = (int32)FPlatformMath::CountTrailingZeros(remaining);
+		remaining &= remaining - 1;
+
+		if (symbol >= NumSymbols)
+		{
+			continue;
+		}
+
+		_state.node = transitions[_state.node * NumSymbols + symbol];
+		_state.pressFrames[_state.numPresses & (MaxCommandLength - 1)] = _frame;
+		++_state.numPresses;
+
+		const int32 outputStart = outputStarts[_state.node];
+		for (int32 output = 0; output < outputCounts[_state.node]; ++output)
+		{
+			const int32 command = outputCommands[outputStart + output];
+			if (numMatches < MaxMatchesPerFrame && IsWithinFrameWindows(_state, command))
+			{
+				//Keep the frame's matches sorted by priority even when several presses complete commands
+				int32 insertAt = numMatches++;
+				while (insertAt > 0 && commandPriorities[_outCommands[insertAt - 1]] < commandPriorities[command])
+				{
+					_outCommands[insertAt] = _outCommands[insertAt - 1];
+					--insertAt;
+				}
+				_outCommands[insertAt] = command;
+			}
+		}
+	}
+
+	return numMatches;
+}
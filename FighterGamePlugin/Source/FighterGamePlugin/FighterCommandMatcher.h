@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FighterSimulation.h"
+
+/**
+ * Aho-Corasick automaton over input presses, compiled once from a character's command list.
+ *
+ * Every pressed input advances the automaton with a single table lookup. The commands that end on the new state
+ * are precomputed and sorted by priority, and each one only has to check the frame gaps between its own steps.
+ */
+class FIGHTERGAMEPLUGIN_API FFighterCommandMatcher
+{
+public:
+	//Each input bit of FFighterInput is one symbol of the automaton
+	static constexpr int32 NumSymbols = 10;
+
+	//The longest command that can be matched. Must be a power of two.
+	static constexpr int32 MaxCommandLength = 16;
+
+	//The most commands that can complete on a single frame
+	static constexpr int32 MaxMatchesPerFrame = 8;
+
+	//Per-player progress through the automaton. Plain data, so it can be reset or snapshotted freely.
+	struct FState
+	{
+		//The automaton node for the longest command prefix that ends on the newest press
+		int32 node;
+
+		//How many presses have been fed in
+		int32 numPresses;
+
+		//The frame of each of the last MaxCommandLength presses
+		int32 pressFrames[MaxCommandLength];
+	};
+
+	FFighterCommandMatcher();
+
+	//Adds a command made of _numSteps single-bit inputs. _frameWindows[step] is the most frames allowed since the previous step (ignored for step 0).
+	//Returns the command's index, or INDEX_NONE if the command cannot be matched.
+	int32 AddCommand(const FFighterInput* _steps, const int32* _frameWindows, int32 _numSteps, int32 _priority);
+
+	//Builds the automaton. Must be called once after all commands are added and before Advance.
+	void Compile();
+
+	static void ResetState(FState& _state);
+
+	//Feeds the inputs pressed on _frame, in bit order, and writes the commands that completed on it to _outCommands, highest priority first.
+	//_outCommands must hold MaxMatchesPerFrame entries. Returns how many were written.
+	int32 Advance(FState& _state, FFighterInput _pressed, int32 _frame, int32* _outCommands) const;
+
+	int32 GetNumCommands() const { return commandPriorities.Num(); }
+
+	int32 GetNumNodes() const { return nodeDepths.Num(); }
+
+private:
+	int32 AddNode(int32 _depth);
+
+	bool IsWithinFrameWindows(const FState& _state, int32 _command) const;
+
+	//Trie edges while building, then the complete DFA transition table after Compile, indexed by node * NumSymbols + symbol
+	TArray<int32> transitions;
+
+	//The Aho-Corasick failure link of each node
+	TArray<int32> failLinks;
+
+	TArray<int32> nodeDepths;
+
+	//The commands ending at each node, as a range of outputCommands
+	TArray<int32> outputStarts;
+	TArray<int32> outputCounts;
+	TArray<int32> outputCommands;
+
+	//The node each command's last step ends on
+	TArray<int32> commandNodes;
+
+	TArray<int32> commandPriorities;
+	TArray<int32> commandLengths;
+
+	//The frame windows of every command's steps, as a range starting at commandWindowStarts
+	TArray<int32> commandWindowStarts;
+	TArray<int32> commandWindows;
+
+	bool isCompiled;
+};
+
+//A compiled matcher and, for each of its commands, the index of the command in the list it was compiled from
+struct FFighterCompiledCommands
+{
+	FFighterCommandMatcher matcher;
+
+	TArray<int32> sourceIndices;
+};
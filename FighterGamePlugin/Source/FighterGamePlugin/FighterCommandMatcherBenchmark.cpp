@@ -0,0 +1,135 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+#include "FighterGamePlugin.h"
+#include "FighterGamePluginCharacter.h"
+#include "FighterCommandMatcher.h"
+
+/**
+ * Microbenchmark comparing the compiled command matcher with the old string-based buffer scan.
+ * Run "Fighter.BenchmarkCommandMatcher [NumCommands] [BufferFrames]" from the console.
+ */
+namespace
+{
+	//The old CheckInputBufferForCommand, scanning with each command instead of the never-filled tempCommand so it does real work
+	int32 LegacyCheckInputBufferForCommand(const TArray<FCommand>& _characterCommands, const TArray<FInputInfo>& _inputBuffer)
+	{
+		int32 numMatches = 0;
+		int correctSequenceCounter = 0;
+
+		for (auto currentCommand : _characterCommands)
+		{
+			for (int commandInput = 0; commandInput < currentCommand.inputs.Num(); ++commandInput)
+			{
+				for (int input = 0; input < _inputBuffer.Num(); ++input)
+				{
+					if (input + correctSequenceCounter < _inputBuffer.Num())
+					{
+						if (_inputBuffer[input + correctSequenceCounter].inputName.Compare(currentCommand.inputs[commandInput]) == 0)
+						{
+							++correctSequenceCounter;
+
+							if (correctSequenceCounter == currentCommand.inputs.Num())
+							{
+								++numMatches;
+							}
+
+							break;
+						}
+						else
+						{
+							correctSequenceCounter = 0;
+						}
+					}
+					else
+					{
+						correctSequenceCounter = 0;
+					}
+				}
+			}
+		}
+
+		return numMatches;
+	}
+
+	void BenchmarkCommandMatcher(const TArray<FString>& _args)
+	{
+		const int32 numCommands = _args.Num() > 0 ? FCString::Atoi(*_args[0]) : 64;
+		const int32 bufferFrames = _args.Num() > 1 ? FCString::Atoi(*_args[1]) : 600;
+
+		static const TCHAR* inputNames[] = { TEXT("Left"), TEXT("Right"), TEXT("Up"), TEXT("Down"), TEXT("A"), TEXT("B"), TEXT("C"), TEXT("D") };
+		FRandomStream random(1234);
+
+		TArray<FCommand> commands;
+		commands.SetNum(numCommands);
+		for (int32 commandIndex = 0; commandIndex < numCommands; ++commandIndex)
+		{
+			FCommand& command = commands[commandIndex];
+			command.name = FString::Printf(TEXT("Command #%d"), commandIndex);
+			command.hasUsedCommand = false;
+			command.priority = random.RandRange(0, 3);
+
+			const int32 numInputs = random.RandRange(3, 6);
+			for (int32 input = 0; input < numInputs; ++input)
+			{
+				command.inputs.Add(inputNames[random.RandRange(0, (int32)UE_ARRAY_COUNT(inputNames) - 1)]);
+			}
+		}
+
+		//One press per frame, so the string buffer and the frame buffer hold the same inputs
+		TArray<FInputInfo> legacyBuffer;
+		TArray<FFighterInput> presses;
+		for (int32 frame = 0; frame < bufferFrames; ++frame)
+		{
+			FInputInfo inputInfo;
+			inputInfo.inputName = inputNames[random.RandRange(0, (int32)UE_ARRAY_COUNT(inputNames) - 1)];
+			inputInfo.timeStamp = (float)frame / FighterSim::FramesPerSecond;
+			legacyBuffer.Add(inputInfo);
+			presses.Add(AFighterGamePluginCharacter::ParseInputName(inputInfo.inputName));
+		}
+
+		//The old code rescanned the whole buffer every time an input was added
+		const int32 legacyIterations = 200;
+		int32 legacyMatches = 0;
+		const double legacyStart = FPlatformTime::Seconds();
+		for (int32 iteration = 0; iteration < legacyIterations; ++iteration)
+		{
+			legacyMatches += LegacyCheckInputBufferForCommand(commands, legacyBuffer);
+		}
+		const double legacySecondsPerInput = (FPlatformTime::Seconds() - legacyStart) / legacyIterations;
+
+		const double compileStart = FPlatformTime::Seconds();
+		const TSharedRef<FFighterCompiledCommands> compiled = AFighterGamePluginCharacter::CompileCommands(commands);
+		const double compileSeconds = FPlatformTime::Seconds() - compileStart;
+
+		//The matcher only looks at the new input, so feed the whole buffer many times over
+		const int32 matcherPasses = 2000;
+		int32 matcherMatches = 0;
+		int32 matchedCommands[FFighterCommandMatcher::MaxMatchesPerFrame];
+		FFighterCommandMatcher::FState state;
+		FFighterCommandMatcher::ResetState(state);
+
+		const double matcherStart = FPlatformTime::Seconds();
+		for (int32 pass = 0; pass < matcherPasses; ++pass)
+		{
+			for (int32 frame = 0; frame < presses.Num(); ++frame)
+			{
+				matcherMatches += compiled->matcher.Advance(state, presses[frame], pass * bufferFrames + frame, matchedCommands);
+			}
+		}
+		const double matcherSecondsPerInput = (FPlatformTime::Seconds() - matcherStart) / ((double)matcherPasses * bufferFrames);
+
+		UE_LOG(LogFighter, Display, TEXT("Command matcher benchmark: %d commands, %d frame buffer, %d automaton nodes compiled in %.3f ms"),
+			numCommands, bufferFrames, compiled->matcher.GetNumNodes(), compileSeconds * 1000.0);
+		UE_LOG(LogFighter, Display, TEXT("  Legacy scan:   %10.1f ns per input (%d matches)"), legacySecondsPerInput * 1.0e9, legacyMatches);
+		UE_LOG(LogFighter, Display, TEXT("  Matcher:       %10.1f ns per input (%d matches)"), matcherSecondsPerInput * 1.0e9, matcherMatches);
+		UE_LOG(LogFighter, Display, TEXT("  Speedup:       %10.1fx"), legacySecondsPerInput / FMath::Max(matcherSecondsPerInput, 1.0e-12));
+	}
+
+	FAutoConsoleCommand BenchmarkCommandMatcherCommand(
+		TEXT("Fighter.BenchmarkCommandMatcher"),
+		TEXT("Compares the compiled command matcher with the old buffer scan. Arguments: [NumCommands=64] [BufferFrames=600]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkCommandMatcher));
+}
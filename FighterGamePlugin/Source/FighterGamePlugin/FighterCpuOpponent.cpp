@@ -0,0 +1,153 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FighterCpuOpponent.h"
+#include "FighterGamePluginCharacter.h"
+#include "FighterGamePlugin.h"
+
+DECLARE_CYCLE_STAT(TEXT("CPU Opponent Tick"), STAT_FighterCpuOpponentTick, STATGROUP_Fighter);
+DECLARE_CYCLE_STAT(TEXT("CPU Opponent Search Action"), STAT_FighterCpuSearchAction, STATGROUP_Fighter);
+
+FFighterCpuOpponent::FFighterCpuOpponent(AFighterGamePluginCharacter* _character, int32 _playerIndex, const FFighterAISettings& _settings, float _budgetMilliseconds)
+{
+	check(_character && (_playerIndex == 0 || _playerIndex == 1));
+
+	character = _character;
+	playerIndex = _playerIndex;
+	settings = _settings;
+	settings.actionFrames = FMath::Max(settings.actionFrames, 1);
+	budgetMilliseconds = FMath::Max(_budgetMilliseconds, 0.1f);
+	action = EFighterAIAction::Wait;
+	actionFrame = settings.actionFrames;
+	actionToward = EFighterInput::None;
+	heldInput = EFighterInput::None;
+	FMemory::Memzero(&stats, sizeof(stats));
+}
+
+FFighterCpuOpponent::~FFighterCpuOpponent()
+{
+	if (search.IsValid())
+	{
+		FPlatformAtomics::InterlockedExchange(&search->cancelFlag, 1);
+	}
+}
+
+void FFighterCpuOpponent::ReleaseInputs()
+{
+	PressInput(EFighterInput::None);
+}
+
+void FFighterCpuOpponent::Tick(const FSimMatchState& _state)
+{
+	FIGHTER_SCOPE_CYCLE_COUNTER(CpuOpponentTick);
+
+	//Never waits: a search that is not done yet is checked again next frame
+	if (searchDoneEvent.IsValid() && searchDoneEvent->IsComplete())
+	{
+		action = search->pickedAction;
+		actionFrame = 0;
+		actionToward = FighterAI::GetTowardOpponent(_state, playerIndex);
+
+		++stats.numSearches;
+		stats.totalDepth += search->pickedDepth;
+		for (const FFighterAIActionResult& result : search->results)
+		{
+			stats.totalNodes += result.numNodes;
+		}
+		stats.maxSearchSeconds = FMath::Max(stats.maxSearchSeconds, search->endSeconds - search->startSeconds);
+
+		searchDoneEvent = nullptr;
+		search.Reset();
+	}
+
+	//The next action is searched from the state the current one ended in
+	const bool isActionDone = actionFrame >= settings.actionFrames;
+	if (isActionDone && !searchDoneEvent.IsValid())
+	{
+		StartSearch(_state);
+	}
+
+	if (isActionDone)
+	{
+		++stats.waitingFrames;
+		PressInput(EFighterInput::None);
+		return;
+	}
+
+	PressInput(FighterAI::GetActionInput(action, actionFrame++, actionToward));
+}
+
+void FFighterCpuOpponent::StartSearch(const FSimMatchState& _state)
+{
+	search = MakeShared<FSearch, ESPMode::ThreadSafe>();
+	search->state = _state;
+	search->cancelFlag = 0;
+	search->limits.cancelFlag = &search->cancelFlag;
+	search->limits.deadlineCycles = FPlatformTime::Cycles64() + (uint64)(budgetMilliseconds * 0.001 / FPlatformTime::GetSecondsPerCycle64());
+	search->pickedAction = EFighterAIAction::Wait;
+	search->pickedDepth = 0;
+	search->startSeconds = FPlatformTime::Seconds();
+	search->endSeconds = search->startSeconds;
+
+	//Each task holds its own reference, so the search outlives this object if it is cancelled
+	const TSharedPtr<FSearch, ESPMode::ThreadSafe> currentSearch = search;
+	const int32 searchPlayerIndex = playerIndex;
+	const FFighterAISettings searchSettings = settings;
+
+	FGraphEventArray actionEvents;
+	actionEvents.Reserve(FighterAI::NumActions);
+	for (int32 actionIndex = 0; actionIndex < FighterAI::NumActions; ++actionIndex)
+	{
+		actionEvents.Add(FFunctionGraphTask::CreateAndDispatchWhenReady([currentSearch, searchPlayerIndex, searchSettings, actionIndex]()
+		{
+			FIGHTER_SCOPE_CYCLE_COUNTER(CpuSearchAction);
+			FighterAI::SearchAction(currentSearch->state, searchPlayerIndex, (EFighterAIAction)actionIndex, searchSettings, currentSearch->limits, currentSearch->results[actionIndex]);
+		}, TStatId(), nullptr, ENamedThreads::AnyBackgroundThreadNormalTask));
+	}
+
+	searchDoneEvent = FFunctionGraphTask::CreateAndDispatchWhenReady([currentSearch]()
+	{
+		currentSearch->pickedAction = FighterAI::PickAction(currentSearch->results, currentSearch->pickedDepth);
+		currentSearch->endSeconds = FPlatformTime::Seconds();
+	}, TStatId(), &actionEvents, ENamedThreads::AnyBackgroundThreadNormalTask);
+}
+
+void FFighterCpuOpponent::PressInput(FFighterInput _input)
+{
+	const FFighterInput pressed = _input & ~heldInput;
+	const FFighterInput released = heldInput & ~_input;
+	heldInput = _input;
+
+	if (pressed & EFighterInput::Up)
+	{
+		character->P2KeyboardJump();
+	}
+	if (released & EFighterInput::Up)
+	{
+		character->P2KeyboardStopJumping();
+	}
+	if (pressed & EFighterInput::Attack1)
+	{
+		character->P2KeyboardAttack1();
+	}
+	if (pressed & EFighterInput::Attack2)
+	{
+		character->P2KeyboardAttack2();
+	}
+	if (pressed & EFighterInput::Attack3)
+	{
+		character->P2KeyboardAttack3();
+	}
+	if (pressed & EFighterInput::Attack4)
+	{
+		character->P2KeyboardAttack4();
+	}
+	if (pressed & EFighterInput::Exceptional)
+	{
+		character->P2KeyboardExceptionalAttack();
+	}
+
+	//The axis is sent every frame, as it would be from a key binding
+	const float axisValue = (_input & EFighterInput::Right) ? 1.0f : ((_input & EFighterInput::Left) ? -1.0f : 0.0f);
+	character->P2KeyboardMoveRight(axisValue);
+}
@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "FighterAI.h"
+
+class AFighterGamePluginCharacter;
+
+struct FFighterCpuOpponentStats
+{
+	int32 numSearches;
+
+	//Added up over every search, divide by numSearches for the average
+	int32 totalDepth;
+	int64 totalNodes;
+
+	//Frames the CPU did nothing because a search had not finished yet
+	int32 waitingFrames;
+
+	double maxSearchSeconds;
+};
+
+/**
+ * Plays a character with FighterAI's search, pressing the same P2Keyboard inputs a second player on the keyboard would.
+ *
+ * Each search runs on a copy of the match state, with one task graph task per action and one more that picks the best.
+ * The game thread only ever checks whether the last task is done, and the search stops itself when its time budget
+ * runs out, so a slow search costs the CPU reaction time and never costs the game a frame.
+ */
+class FIGHTERGAMEPLUGIN_API FFighterCpuOpponent
+{
+public:
+	FFighterCpuOpponent(AFighterGamePluginCharacter* _character, int32 _playerIndex, const FFighterAISettings& _settings, float _budgetMilliseconds);
+
+	//Cancels a running search without waiting for it. Its tasks finish on their own.
+	~FFighterCpuOpponent();
+
+	//Presses the character's inputs for the frame after _state. Call before the match manager gathers the inputs.
+	void Tick(const FSimMatchState& _state);
+
+	//Lets go of everything, so the character is not left walking or holding jump when the CPU stops
+	void ReleaseInputs();
+
+	const FFighterCpuOpponentStats& GetStats() const { return stats; }
+
+private:
+	//Everything the search tasks touch, kept alive by them until the last one is done
+	struct FSearch
+	{
+		FSimMatchState state;
+		FFighterAISearchLimits limits;
+		volatile int32 cancelFlag;
+		FFighterAIActionResult results[FighterAI::NumActions];
+
+		//Filled in by the last task
+		EFighterAIAction pickedAction;
+		int32 pickedDepth;
+		double startSeconds;
+		double endSeconds;
+	};
+
+	void StartSearch(const FSimMatchState& _state);
+
+	//Calls the P2Keyboard functions for whatever changed since the last input
+	void PressInput(FFighterInput _input);
+
+	AFighterGamePluginCharacter* character;
+	int32 playerIndex;
+	FFighterAISettings settings;
+	float budgetMilliseconds;
+
+	TSharedPtr<FSearch, ESPMode::ThreadSafe> search;
+	FGraphEventRef searchDoneEvent;
+
+	//The action being done, how far into it the CPU is and the way it was facing when it started
+	EFighterAIAction action;
+	int32 actionFrame;
+	FFighterInput actionToward;
+
+	FFighterInput heldInput;
+
+	FFighterCpuOpponentStats stats;
+};
@@ -9,5 +9,14 @@ public class FighterGamePlugin : ModuleRules
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 
 		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore" });
+
+		//The hitbox display's scene proxy, and the input history widget
+		PrivateDependencyModuleNames.AddRange(new string[] { "RenderCore", "UMG", "Slate", "SlateCore" });
+
+		//The input sampler reads pads itself through XInput
+		if (Target.Platform == UnrealTargetPlatform.Win64)
+		{
+			AddEngineThirdPartyPrivateStaticDependencies(Target, "XInput");
+		}
 	}
 }
@@ -4,4 +4,14 @@
 #include "Modules/ModuleManager.h"
 
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, FighterGamePlugin, "FighterGamePlugin" );
- 
\ No newline at end of file
+
+DEFINE_LOG_CATEGORY(LogFighter);
+
+UE_TRACE_CHANNEL_DEFINE(FighterChannel);
+CSV_DEFINE_CATEGORY_MODULE(FIGHTERGAMEPLUGIN_API, Fighter, true);
+
+DEFINE_STAT(STAT_FighterInputBufferSize);
+DEFINE_STAT(STAT_FighterCommandsMatched);
+DEFINE_STAT(STAT_FighterHitsResolved);
+DEFINE_STAT(STAT_FighterSimulationSteps);
+DEFINE_STAT(STAT_FighterSpectatorBytesSent);
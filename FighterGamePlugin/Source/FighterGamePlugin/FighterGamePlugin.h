@@ -3,3 +3,34 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogFighter, Log, All);
+
+//Gameplay profiling. "stat Fighter" shows it in game, "-trace=cpu,Fighter" records it for Unreal Insights and "csvprofile start" captures it to CSV.
+DECLARE_STATS_GROUP(TEXT("Fighter"), STATGROUP_Fighter, STATCAT_Advanced);
+UE_TRACE_CHANNEL_EXTERN(FighterChannel, FIGHTERGAMEPLUGIN_API);
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(FIGHTERGAMEPLUGIN_API, Fighter);
+
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Input Buffer Size"), STAT_FighterInputBufferSize, STATGROUP_Fighter, FIGHTERGAMEPLUGIN_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Commands Matched"), STAT_FighterCommandsMatched, STATGROUP_Fighter, FIGHTERGAMEPLUGIN_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Hits Resolved"), STAT_FighterHitsResolved, STATGROUP_Fighter, FIGHTERGAMEPLUGIN_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Simulation Steps"), STAT_FighterSimulationSteps, STATGROUP_Fighter, FIGHTERGAMEPLUGIN_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Spectator Bytes Sent"), STAT_FighterSpectatorBytesSent, STATGROUP_Fighter, FIGHTERGAMEPLUGIN_API);
+
+//Times the rest of the scope as stat STAT_Fighter<Name>, which the file declares with DECLARE_CYCLE_STAT, as well as in traces and CSV profiles
+#define FIGHTER_SCOPE_CYCLE_COUNTER(Name) \
+	SCOPE_CYCLE_COUNTER(STAT_Fighter##Name); \
+	CSV_SCOPED_TIMING_STAT(Fighter, Name); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Fighter##Name, FighterChannel)
+
+//Sets or adds to one of the counters declared above, and the CSV stat of the same name
+#define FIGHTER_SET_COUNTER(Name, Value) \
+	SET_DWORD_STAT(STAT_Fighter##Name, Value); \
+	CSV_CUSTOM_STAT(Fighter, Name, (int32)(Value), ECsvCustomStatOp::Set)
+
+#define FIGHTER_ADD_COUNTER(Name, Value) \
+	INC_DWORD_STAT_BY(STAT_Fighter##Name, Value); \
+	CSV_CUSTOM_STAT(Fighter, Name, (int32)(Value), ECsvCustomStatOp::Accumulate)
@@ -1,48 +1,68 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "FighterGamePluginCharacter.h"
-#include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/InputComponent.h"
-#include "GameFramework/SpringArmComponent.h"
-#include "GameFramework/CharacterMovementComponent.h"
 #include <FighterGamePlugin/FighterGamePluginGameMode.h>
 #include <FighterGamePlugin/BaseGameInstance.h>
+#include "FighterGamePlugin.h"
 
-AFighterGamePluginCharacter::AFighterGamePluginCharacter()
+static_assert((uint8)EFighterSimState::Launched == (uint8)ECharacterState::VE_Launched, "EFighterSimState must mirror ECharacterState");
+static_assert((uint8)EFighterSimState::BlockStunned == (uint8)ECharacterState::VE_Launched + 1, "Only BlockStunned may be missing from ECharacterState");
+static_assert((uint8)EFighterSimState::Stunned == (uint8)ECharacterState::VE_Stunned, "EFighterSimState must mirror ECharacterState");
+static_assert((uint8)EFighterSimState::Blocking == (uint8)ECharacterState::VE_Blocking, "EFighterSimState must mirror ECharacterState");
+
+DECLARE_CYCLE_STAT(TEXT("Character MoveRight"), STAT_FighterMoveRight, STATGROUP_Fighter);
+DECLARE_CYCLE_STAT(TEXT("Character Input Action"), STAT_FighterInputAction, STATGROUP_Fighter);
+DECLARE_CYCLE_STAT(TEXT("Character RecordInput"), STAT_FighterRecordInput, STATGROUP_Fighter);
+DECLARE_CYCLE_STAT(TEXT("Character CheckInputBufferForCommand"), STAT_FighterCheckInputBufferForCommand, STATGROUP_Fighter);
+DECLARE_CYCLE_STAT(TEXT("Character TakeDamage"), STAT_FighterTakeDamage, STATGROUP_Fighter);
+DECLARE_CYCLE_STAT(TEXT("Character CollidedWithProximityHitbox"), STAT_FighterCollidedWithProximityHitbox, STATGROUP_Fighter);
+DECLARE_CYCLE_STAT(TEXT("Character SyncFromSimulation"), STAT_FighterSyncFromSimulation, STATGROUP_Fighter);
+
+namespace
+{
+	//How many named inputs the blueprint-visible inputBuffer keeps
+	constexpr int32 MaxNamedInputs = 16;
+
+	//The name of each input bit, as ParseInputName reads it, in bit order
+	const TCHAR* const InputBitNames[] =
+	{
+		TEXT("Left"),
+		TEXT("Right"),
+		TEXT("Up"),
+		TEXT("Down"),
+		TEXT("Attack1"),
+		TEXT("Attack2"),
+		TEXT("Attack3"),
+		TEXT("Attack4"),
+		TEXT("Block"),
+		TEXT("Exceptional")
+	};
+}
+
+//The simulation moves the character, so it has no CharacterMovementComponent
+AFighterGamePluginCharacter::AFighterGamePluginCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.DoNotCreateDefaultSubobject(ACharacter::CharacterMovementComponentName))
 {
 	// Set size for collision capsule
 	GetCapsuleComponent()->InitCapsuleSize(42.f, 96.0f);
 
+	//The simulation's pushboxes keep the fighters apart, so the capsules must not
+	GetCapsuleComponent()->SetCollisionResponseToChannel(ECC_Pawn, ECR_Ignore);
+
+	//The game mode's match manager updates the character, so it never ticks itself
+	PrimaryActorTick.bCanEverTick = false;
+
 	// Don't rotate when the controller rotates.
 	bUseControllerRotationPitch = false;
 	bUseControllerRotationYaw = false;
 	bUseControllerRotationRoll = false;
 
-	// Create a camera boom attached to the root (capsule)
-	CameraBoom = CreateDefaultSubobject<USpringArmComponent>(TEXT("CameraBoom"));
-	CameraBoom->SetupAttachment(RootComponent);
-	CameraBoom->SetUsingAbsoluteRotation(true); // Rotation of the character should not affect rotation of boom
-	CameraBoom->bDoCollisionTest = false;
-	CameraBoom->TargetArmLength = 500.f;
-	CameraBoom->SocketOffset = FVector(0.f,0.f,75.f);
-	CameraBoom->SetRelativeRotation(FRotator(0.f,180.f,0.f));
-
-	// Create a camera and attach to boom
-	SideViewCameraComponent = CreateDefaultSubobject<UCameraComponent>(TEXT("SideViewCamera"));
-	SideViewCameraComponent->SetupAttachment(CameraBoom, USpringArmComponent::SocketName);
-	SideViewCameraComponent->bUsePawnControlRotation = false; // We don't want the controller rotating the camera
-
-	// Configure character movement
-	GetCharacterMovement()->bOrientRotationToMovement = true; // Face in the direction we are moving..
-	GetCharacterMovement()->RotationRate = FRotator(0.0f, 720.0f, 0.0f); // ...at this rotation rate
-	GetCharacterMovement()->GravityScale = 2.f;
-	GetCharacterMovement()->AirControl = 0.80f;
-	GetCharacterMovement()->JumpZVelocity = 1000.f;
-	GetCharacterMovement()->GroundFriction = 3.f;
-	GetCharacterMovement()->MaxWalkSpeed = 600.f;
-	GetCharacterMovement()->MaxFlySpeed = 600.f;
-	//GetCharacterMovement()->OrientRotationToMovement = false;
+	// Both players watch the game mode's AFighterCamera, so the character has no camera of its own
+
+	// Configure character movement, in frames
+	fighterMovement = CreateDefaultSubobject<UFighterMovementComponent>(TEXT("FighterMovement"));
 
 	// Note: The skeletal mesh and anim blueprint references on the Mesh component (inherited from Character) 
 	// are set in the derived blueprint asset named MyCharacter (to avoid direct content references in C++)
@@ -58,18 +78,34 @@ AFighterGamePluginCharacter::AFighterGamePluginCharacter()
 	wasHeavyAttackUsed = false;
 	wasSpecialAttackUsed = false;
 	isFlipped = false;
+	distanceToOtherPlayer = 0.0f;
+	hasSwitchedSides = false;
 	hasLandedHit = false;
 	canMove = false;
 	maxDistanceApart = 800.0f;
 	stunTime = 0.0f;
 	hurtbox = nullptr;
+	hitboxPoolSize = 8;
+	hurtboxPoolSize = 4;
+	moveSet = nullptr;
+	currentMove = EFighterMoveId::MV_None;
+	currentMoveFrame = 0;
 	hasUsedTempCommand = false;
 	wasLightExAttackUsed = false;
 	wasHeavyExAttackUsed = false;
 	wasMediumExAttackUsed = false;
 	wasSuperUsed = false;
 	superMeterAmount = 0.0f;
-
+	heldInput = EFighterInput::None;
+	pressedInput = EFighterInput::None;
+	axisInputFrame = 0;
+	previousAxisInput = EFighterInput::None;
+	simulationOrigin = FVector::ZeroVector;
+	modelComponent = nullptr;
+	inputHistory.Reset();
+	inputBuffer.Reserve(MaxNamedInputs + UE_ARRAY_COUNT(InputBitNames));
+	FFighterCommandMatcher::ResetState(commandMatcherState);
+	lastCheckedFrame = 0;
 
 	hasReleasedAxisInput = true;
 
@@ -91,6 +127,27 @@ AFighterGamePluginCharacter::AFighterGamePluginCharacter()
 	characterCommands[1].hasUsedCommand = false;
 }
 
+void AFighterGamePluginCharacter::BeginPlay()
+{
+	Super::BeginPlay();
+
+	CompileCharacterCommands();
+}
+
+#if WITH_EDITOR
+void AFighterGamePluginCharacter::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	//The matcher's command indices point into characterCommands, so any change to it needs a new matcher
+	if (PropertyChangedEvent.GetPropertyName() == GET_MEMBER_NAME_CHECKED(AFighterGamePluginCharacter, characterCommands)
+		|| PropertyChangedEvent.GetMemberPropertyName() == GET_MEMBER_NAME_CHECKED(AFighterGamePluginCharacter, characterCommands))
+	{
+		CompileCharacterCommands();
+	}
+}
+#endif
+
 //////////////////////////////////////////////////////////////////////////
 // Input
 
@@ -146,97 +203,45 @@ void AFighterGamePluginCharacter::SetupPlayerInputComponent(class UInputComponen
 
 void AFighterGamePluginCharacter::MoveRight(float Value)
 {
+	FIGHTER_SCOPE_CYCLE_COUNTER(MoveRight);
+
 	if (auto baseGameInstance = Cast<UBaseGameInstance>(GetGameInstance()))
 	{
 		if (baseGameInstance->isDeviceForMultiplePlayers)
 		{
-			if (canMove && characterState != ECharacterState::VE_Crouching && characterState != ECharacterState::VE_Blocking)
+			//Several axis bindings can call this in one frame, so directions are combined and only cleared by the first call of the next frame.
+			//That way every simulation step run during this frame sees them held.
+			if (axisInputFrame != GFrameCounter)
 			{
-				if (characterState != ECharacterState::VE_Jumping && characterState != ECharacterState::VE_Launched)
-				{
-					if (Value > 0.20f)
-					{
-						characterState = ECharacterState::VE_MovingRight;
-						AddInputIconToScreen(1, hasReleasedAxisInput);
-						hasReleasedAxisInput = false;
-					}
-					else if (Value < -0.20f)
-					{
-						characterState = ECharacterState::VE_MovingLeft;
-						AddInputIconToScreen(3, hasReleasedAxisInput);
-						hasReleasedAxisInput = false;
-					}
-					else
-					{
-						characterState = ECharacterState::VE_MovingRight;
-						hasReleasedAxisInput = true;
-					}
-				}
+				previousAxisInput = heldInput & (EFighterInput::Left | EFighterInput::Right);
+				heldInput &= ~(EFighterInput::Left | EFighterInput::Right);
+				axisInputFrame = GFrameCounter;
 			}
 
-			float currentDistanceApart = abs(otherPlayer->GetActorLocation().Y - GetActorLocation().Y);
-
-			if (currentDistanceApart >= maxDistanceApart)
+			//Input icons come from the recorded input once per simulation frame, not from every axis callback
+			FFighterInput axisInput = EFighterInput::None;
+			if (Value > 0.20f)
 			{
-				if ((currentDistanceApart + Value < currentDistanceApart && !isFlipped) || (currentDistanceApart - Value < currentDistanceApart && isFlipped))
-				{
-					AddMovementInput(FVector(0.f, 1.0f, 0.f), Value);
-				}
-				else
-				{
-					AddMovementInput(FVector(0.0f, 1.0f, 0.0f), Value);
-				}
+				axisInput = EFighterInput::Right;
+				hasReleasedAxisInput = false;
+			}
+			else if (Value < -0.20f)
+			{
+				axisInput = EFighterInput::Left;
+				hasReleasedAxisInput = false;
+			}
+			else
+			{
+				hasReleasedAxisInput = true;
 			}
 
-		}
-	}
-	
-		
-}
-
-void AFighterGamePluginCharacter::Tick(float DeltaTime)
-{
-	Super::Tick(DeltaTime);
+			//Only a direction not held on the last frame, or by an earlier call this frame, is a new press
+			const FFighterInput newAxisInput = axisInput & ~(previousAxisInput | heldInput);
+			heldInput |= axisInput;
 
-	if (characterState != ECharacterState::VE_Jumping)
-	{
-		if (otherPlayer)
-		{
-			if (auto characterMovement = GetCharacterMovement())
+			if (newAxisInput != EFighterInput::None)
 			{
-				if (auto enemyMovement = otherPlayer->GetCharacterMovement())
-				{
-					if (enemyMovement->GetActorLocation().Y <= characterMovement->GetActorLocation().Y)
-					{
-						if (isFlipped)
-						{
-							if (auto mesh = GetCapsuleComponent()->GetChildComponent(1))
-							{
-								transform = mesh->GetRelativeTransform();
-								scale = transform.GetScale3D();
-								scale.Y = -1;
-								transform.SetScale3D(scale);
-								mesh->SetRelativeTransform(transform);
-							}
-							isFlipped = false;
-						}
-					}
-					else
-					{
-						if (!isFlipped)
-						{
-							if (auto mesh = GetCapsuleComponent()->GetChildComponent(1))
-							{
-								transform = mesh->GetRelativeTransform();
-								scale = transform.GetScale3D();
-								scale.Y = -1;
-								transform.SetScale3D(scale);
-								mesh->SetRelativeTransform(transform);
-							}
-							isFlipped = true;
-						}
-					}
-				}
+				NoteInputHandled(newAxisInput);
 			}
 		}
 	}
@@ -255,126 +260,56 @@ void AFighterGamePluginCharacter::TouchStopped(const ETouchIndex::Type FingerInd
 
 void AFighterGamePluginCharacter::StartAttack1()
 {
-	wasLightAttackUsed = true;
-	AddInputIconToScreen(4);
+	AddPressedInput(EFighterInput::Attack1);
 }
 
 void AFighterGamePluginCharacter::StartAttack2()
 {
-	wasMediumAttackUsed = true;
-	AddInputIconToScreen(5);
+	AddPressedInput(EFighterInput::Attack2);
 }
 
 void AFighterGamePluginCharacter::StartAttack3()
 {
-	wasHeavyAttackUsed = true;
-	AddInputIconToScreen(6);
+	AddPressedInput(EFighterInput::Attack3);
 }
 
 void AFighterGamePluginCharacter::StartAttack4()
 {
-	if (superMeterAmount >= 1.0f)
-	{
-		wasSuperUsed = true;
-		AddInputIconToScreen(7);
-	}
-	
+	AddPressedInput(EFighterInput::Attack4);
 }
 
 void AFighterGamePluginCharacter::StartExceptionalAttack()
 {
-	if (wasLightAttackUsed)
-	{
-		wasLightExAttackUsed = true;
-		superMeterAmount -= 0.20f;
-	}
-	else if (wasMediumAttackUsed)
-	{
-		wasMediumExAttackUsed = true;
-		superMeterAmount -= 0.35f;
-	}
-	else if (wasHeavyAttackUsed)
-	{
-		wasHeavyExAttackUsed = true;
-		superMeterAmount -= 0.50f;
-	}
-
-	if (superMeterAmount < 0.00f)
-	{
-		superMeterAmount = 0.00f;
-	}
+	AddPressedInput(EFighterInput::Exceptional);
 }
 
 void AFighterGamePluginCharacter::CollidedWithProximityHitbox()
 {
-	if ((characterState == ECharacterState::VE_MovingLeft && !isFlipped) || (characterState == ECharacterState::VE_MovingRight && isFlipped))
+	FIGHTER_SCOPE_CYCLE_COUNTER(CollidedWithProximityHitbox);
+
+	if (auto gamemode = Cast<AFighterGamePluginGameMode>(GetWorld()->GetAuthGameMode()))
 	{
-		characterState = ECharacterState::VE_Blocking;
+		const int32 playerIndex = gamemode->GetPlayerIndex(this);
+		if (playerIndex != INDEX_NONE)
+		{
+			FighterSim::CollideWithProximityHitbox(gamemode->matchState.fighters[playerIndex]);
+			gamemode->SyncPlayersFromSimulation();
+		}
 	}
 }
 
 void AFighterGamePluginCharacter::TakeDamage(float _damageAmount, float _hitstunTime, float _blockstunTime)
 {
-	if (characterState != ECharacterState::VE_Blocking)
-	{
-		
-		stunTime = _hitstunTime;
-		playerHealth -= _damageAmount;
-		superMeterAmount += _damageAmount * 0.85f;
-
-		if (stunTime > 0.0f)
-		{
-			characterState = ECharacterState::VE_Stunned;
-			BeginStun();
-		}
+	FIGHTER_SCOPE_CYCLE_COUNTER(TakeDamage);
 
-		if (otherPlayer)
-		{
-			otherPlayer->hasLandedHit = true;
-			//otherPlayer->PerformPushback(_pushbackAmount, 0.0f, false);
-
-			if (!otherPlayer->wasLightExAttackUsed)
-			{
-				otherPlayer->superMeterAmount += _damageAmount * 0.30f;
-			}
-		}
-
-		//PerformPushback(_pushbackAmount, _launchAmount, false);
-	}
-	else
+	if (auto gamemode = Cast<AFighterGamePluginGameMode>(GetWorld()->GetAuthGameMode()))
 	{
-		float reducedDamage = _damageAmount * 0.5f;
-		playerHealth -= reducedDamage;
-
-		stunTime = _blockstunTime;
-
-		if (stunTime > 0.0f)
+		const int32 playerIndex = gamemode->GetPlayerIndex(this);
+		if (playerIndex != INDEX_NONE)
 		{
-			BeginStun();
+			FighterSim::ApplyHit(gamemode->matchState, playerIndex, FFixed::FromFloat(_damageAmount), FighterSim::SecondsToFrames(_hitstunTime), FighterSim::SecondsToFrames(_blockstunTime), FighterSim::DefaultPushback);
+			gamemode->SyncPlayersFromSimulation();
 		}
-		else
-		{
-			if (characterState != ECharacterState::VE_Launched)
-			{
-				characterState = ECharacterState::VE_Default;
-			}
-			
-		}
-
-		if (otherPlayer)
-		{
-			otherPlayer->hasLandedHit = false;
-			//otherPlayer->PerformPushback(_pushbackAmount, 0.0f, false);
-		}
-
-		//PerformPushback(_pushbackAmount, 0.0f, true);
-	}
-	
-	
-
-	if (playerHealth < 0.00f)
-	{
-		playerHealth = 0.00f;
 	}
 }
 
@@ -420,112 +355,379 @@ void AFighterGamePluginCharacter::P2KeyboardMoveRight(float _value)
 
 void AFighterGamePluginCharacter::Jump()
 {
-	if (canMove)
-	{
-		ACharacter::Jump();
-		characterState = ECharacterState::VE_Jumping;
-		AddInputIconToScreen(0);
-	}
-	
+	PressInput(EFighterInput::Up);
 }
 
 void AFighterGamePluginCharacter::StopJumping()
 {
-	characterState = ECharacterState::VE_Default;
-}
-
-void AFighterGamePluginCharacter::Landed(const FHitResult& Hit)
-{
-	characterState = ECharacterState::VE_Default;
+	ReleaseInput(EFighterInput::Up);
 }
 
 void AFighterGamePluginCharacter::StartCrouching()
 {
-	characterState = ECharacterState::VE_Crouching;
+	PressInput(EFighterInput::Down);
 }
 
 void AFighterGamePluginCharacter::StopCrouching()
 {
-	characterState = ECharacterState::VE_Default;
+	ReleaseInput(EFighterInput::Down);
 }
 
 void AFighterGamePluginCharacter::StartBlocking()
 {
-	characterState = ECharacterState::VE_Blocking;
+	PressInput(EFighterInput::Block);
 }
 
 void AFighterGamePluginCharacter::StopBlocking()
 {
-	characterState = ECharacterState::VE_Default;
+	ReleaseInput(EFighterInput::Block);
 }
 
-void AFighterGamePluginCharacter::BeginStun()
+void AFighterGamePluginCharacter::PressInput(FFighterInput _input)
 {
-	canMove = false;
+	FIGHTER_SCOPE_CYCLE_COUNTER(InputAction);
+
+	const FFighterInput newInput = _input & ~(heldInput | pressedInput);
+	heldInput |= _input;
+	pressedInput |= _input;
 
-	GetWorld()->GetTimerManager().SetTimer(stunTimerHandle, this, &AFighterGamePluginCharacter::ExitStun, stunTime, false);
+	if (newInput != EFighterInput::None)
+	{
+		NoteInputHandled(newInput);
+	}
 }
 
-void AFighterGamePluginCharacter::ExitStun()
+void AFighterGamePluginCharacter::AddPressedInput(FFighterInput _input)
 {
-	characterState = ECharacterState::VE_Default;
-	canMove = true;
+	FIGHTER_SCOPE_CYCLE_COUNTER(InputAction);
+
+	const FFighterInput newInput = _input & ~pressedInput;
+	pressedInput |= _input;
+
+	if (newInput != EFighterInput::None)
+	{
+		NoteInputHandled(newInput);
+	}
+}
+
+void AFighterGamePluginCharacter::NoteInputHandled(FFighterInput _input)
+{
+	//Only new presses get here, so the game mode lookup is not paid every frame
+	if (auto gamemode = Cast<AFighterGamePluginGameMode>(GetWorld()->GetAuthGameMode()))
+	{
+		const int32 playerIndex = gamemode->GetPlayerIndex(this);
+		if (gamemode->inputLatency.IsValid() && playerIndex != INDEX_NONE)
+		{
+			gamemode->inputLatency->OnInputHandled(playerIndex, _input);
+		}
+	}
+}
+
+void AFighterGamePluginCharacter::ReleaseInput(FFighterInput _input)
+{
+	FIGHTER_SCOPE_CYCLE_COUNTER(InputAction);
+
+	heldInput &= ~_input;
+}
+
+FFighterInput AFighterGamePluginCharacter::ConsumeSimulationInput()
+{
+	const FFighterInput input = heldInput | pressedInput;
+	pressedInput = EFighterInput::None;
+
+	return input;
+}
+
+void AFighterGamePluginCharacter::InitializeSimulationView(AFighterGamePluginCharacter* _otherPlayer)
+{
+	otherPlayer = _otherPlayer;
+	simulationOrigin = GetActorLocation();
+	modelComponent = GetCapsuleComponent()->GetChildComponent(1);
+
+	//The simulation moves the character, so it must not tick
+	SetActorTickEnabled(false);
+}
+
+void AFighterGamePluginCharacter::SyncFromSimulation(const FSimFighterState& _state, int32 _frame, const FFighterMatchView& _view)
+{
+	FIGHTER_SCOPE_CYCLE_COUNTER(SyncFromSimulation);
+
+	playerHealth = _state.health.ToFloat();
+	superMeterAmount = _state.superMeter.ToFloat();
+	//Blockstun only exists in the simulation, blueprints see it as blocking
+	characterState = _state.characterState == EFighterSimState::BlockStunned ? ECharacterState::VE_Blocking : (ECharacterState)_state.characterState;
+	stunTime = (float)FighterSim::GetStunFramesRemaining(_state, _frame) / FighterSim::FramesPerSecond;
+	canMove = _state.canMove;
+	hasLandedHit = _state.hasLandedHit;
+	currentMove = (EFighterMoveId)_state.move;
+	currentMoveFrame = _state.moveFrame;
+
+	//The exceptional moves are exceptional versions of the normal ones, so both flags are set
+	wasLightAttackUsed = _state.move == EFighterMove::Light || _state.move == EFighterMove::LightEx;
+	wasMediumAttackUsed = _state.move == EFighterMove::Medium || _state.move == EFighterMove::MediumEx;
+	wasHeavyAttackUsed = _state.move == EFighterMove::Heavy || _state.move == EFighterMove::HeavyEx;
+	wasSuperUsed = _state.move == EFighterMove::Super;
+	wasLightExAttackUsed = _state.move == EFighterMove::LightEx;
+	wasMediumExAttackUsed = _state.move == EFighterMove::MediumEx;
+	wasHeavyExAttackUsed = _state.move == EFighterMove::HeavyEx;
+	distanceToOtherPlayer = _view.distanceApart;
+	hasSwitchedSides = _view.hasSwitchedSides;
+
+	SetActorLocation(FVector(simulationOrigin.X, _state.positionX.ToFloat(), simulationOrigin.Z + _state.positionZ.ToFloat()));
+
+	//Let the animation blueprint keep reading the velocity and whether the character is falling
+	fighterMovement->SyncFromSimulation(_state);
+
+	if (isFlipped != _state.isFlipped)
+	{
+		if (modelComponent)
+		{
+			transform = modelComponent->GetRelativeTransform();
+			scale = transform.GetScale3D();
+			scale.Y = _state.isFlipped ? -1.0f : 1.0f;
+			transform.SetScale3D(scale);
+			modelComponent->SetRelativeTransform(transform);
+		}
+		isFlipped = _state.isFlipped;
+	}
 }
 
 void AFighterGamePluginCharacter::AddInputToInputBuffer(FInputInfo _inputInfo)
 {
-	inputBuffer.Add(_inputInfo);
-	CheckInputBufferForCommand();
+	AddPressedInput(ParseInputName(_inputInfo.inputName));
 }
 
-void AFighterGamePluginCharacter::CheckInputBufferForCommand()
+int32 AFighterGamePluginCharacter::GetInputBufferNum() const
+{
+	return inputHistory.Num();
+}
+
+FBufferedInput AFighterGamePluginCharacter::GetBufferedInput(int32 _age) const
 {
-	int correctSequenceCounter = 0;
+	FBufferedInput bufferedInput;
+	bufferedInput.inputBits = 0;
+	bufferedInput.pressedBits = 0;
+	bufferedInput.frame = 0;
 
-	for (auto currentCommand : characterCommands)
+	if (_age >= 0 && _age < inputHistory.Num())
 	{
-		for (int commandInput = 0; commandInput < tempCommand.inputs.Num(); ++commandInput)
+		bufferedInput.inputBits = inputHistory.GetByAge(_age);
+		bufferedInput.pressedBits = inputHistory.GetPressedByAge(_age);
+		bufferedInput.frame = inputHistory.GetFrameByAge(_age);
+	}
+
+	return bufferedInput;
+}
+
+void AFighterGamePluginCharacter::RecordInput(int32 _frame, FFighterInput _input)
+{
+	FIGHTER_SCOPE_CYCLE_COUNTER(RecordInput);
+
+	inputHistory.Add(_frame, _input);
+	FIGHTER_SET_COUNTER(InputBufferSize, inputHistory.Num());
+
+	const FFighterInput pressedInput = inputHistory.GetPressedByAge(0);
+	if (pressedInput != EFighterInput::None)
+	{
+		CheckInputBufferForCommand();
+		AddNamedInputs(pressedInput);
+	}
+
+	//A bound input history widget replaces the blueprint's own input stack
+	if (onInputRecorded.IsBound())
+	{
+		onInputRecorded.Broadcast(_frame, _input);
+	}
+	else
+	{
+		AddRecordedInputIcons();
+	}
+}
+
+void AFighterGamePluginCharacter::AddRecordedInputIcons()
+{
+	struct FInputIcon
+	{
+		FFighterInput input;
+		int iconIndex;
+	};
+
+	//Only the icons the input callbacks used to add
+	static const FInputIcon InputIcons[] =
+	{
+		{ EFighterInput::Up, 0 },
+		{ EFighterInput::Right, 1 },
+		{ EFighterInput::Left, 3 },
+		{ EFighterInput::Attack1, 4 },
+		{ EFighterInput::Attack2, 5 },
+		{ EFighterInput::Attack3, 6 },
+		{ EFighterInput::Attack4, 7 }
+	};
+
+	const FFighterInput heldInput = inputHistory.GetByAge(0);
+	const FFighterInput pressedInput = inputHistory.GetPressedByAge(0);
+
+	for (const FInputIcon& inputIcon : InputIcons)
+	{
+		if (pressedInput & inputIcon.input)
 		{
-			for (int input = 0; input < inputBuffer.Num(); ++input)
+			//Jumping only showed when the character could, and the super only with a full meter
+			if ((inputIcon.input == EFighterInput::Up && !canMove) || (inputIcon.input == EFighterInput::Attack4 && superMeterAmount < 1.0f))
 			{
-				if (input + correctSequenceCounter < inputBuffer.Num())
-				{
-					if (inputBuffer[input + correctSequenceCounter].inputName.Compare(tempCommand.inputs[commandInput]) == 0)
-					{
-						++correctSequenceCounter;
-
-						if (correctSequenceCounter == tempCommand.inputs.Num())
-						{
-							StartCommand(tempCommand.name);
-						}
-
-						break;
-					}
-					else
-					{
-						correctSequenceCounter = 0;
-					}
-				}
-				else
-				{
-					correctSequenceCounter = 0;
-				}
+				continue;
 			}
+			AddInputIconToScreen(inputIcon.iconIndex, true);
+		}
+		else if ((heldInput & inputIcon.input) && (inputIcon.input == EFighterInput::Right || inputIcon.input == EFighterInput::Left))
+		{
+			//A held direction carries on its row, as every axis callback did
+			AddInputIconToScreen(inputIcon.iconIndex, false);
 		}
 	}
+}
 
-	
+void AFighterGamePluginCharacter::AddNamedInputs(FFighterInput _pressedInput)
+{
+	const float timeStamp = GetWorld() ? GetWorld()->GetTimeSeconds() : 0.0f;
+	for (int32 bit = 0; bit < UE_ARRAY_COUNT(InputBitNames); ++bit)
+	{
+		if (_pressedInput & (1 << bit))
+		{
+			FInputInfo& inputInfo = inputBuffer.AddDefaulted_GetRef();
+			inputInfo.inputName = InputBitNames[bit];
+			inputInfo.timeStamp = timeStamp;
+		}
+	}
+
+	//Only ever a few entries to shift, and the array never grows past what the constructor reserved
+	if (inputBuffer.Num() > MaxNamedInputs)
+	{
+		inputBuffer.RemoveAt(0, inputBuffer.Num() - MaxNamedInputs, false);
+	}
+}
+
+void AFighterGamePluginCharacter::ResetInputHistory()
+{
+	inputHistory.Reset();
+	inputBuffer.Reset();
+	FFighterCommandMatcher::ResetState(commandMatcherState);
+	lastCheckedFrame = 0;
 }
 
-void AFighterGamePluginCharacter::StartCommand(FString _commandName)
+FFighterInput AFighterGamePluginCharacter::ParseInputName(const FString& _inputName)
 {
-	for (int currentCommand = 0; currentCommand < characterCommands.Num(); ++currentCommand)
+	struct FInputName
+	{
+		const TCHAR* name;
+		FFighterInput input;
+	};
+
+	static const FInputName inputNames[] =
+	{
+		{ TEXT("Left"), EFighterInput::Left },
+		{ TEXT("Right"), EFighterInput::Right },
+		{ TEXT("Up"), EFighterInput::Up },
+		{ TEXT("Jump"), EFighterInput::Up },
+		{ TEXT("Down"), EFighterInput::Down },
+		{ TEXT("Crouch"), EFighterInput::Down },
+		{ TEXT("Block"), EFighterInput::Block },
+		{ TEXT("Exceptional"), EFighterInput::Exceptional },
+		{ TEXT("Attack1"), EFighterInput::Attack1 },
+		{ TEXT("Attack2"), EFighterInput::Attack2 },
+		{ TEXT("Attack3"), EFighterInput::Attack3 },
+		{ TEXT("Attack4"), EFighterInput::Attack4 },
+		{ TEXT("A"), EFighterInput::Attack1 },
+		{ TEXT("B"), EFighterInput::Attack2 },
+		{ TEXT("C"), EFighterInput::Attack3 },
+		{ TEXT("D"), EFighterInput::Attack4 }
+	};
+
+	for (const FInputName& inputName : inputNames)
 	{
-		if (_commandName.Compare(characterCommands[currentCommand].name) == 0)
+		if (_inputName.Equals(inputName.name, ESearchCase::IgnoreCase))
 		{
-			characterCommands[currentCommand].hasUsedCommand = true;
+			return inputName.input;
 		}
 	}
-	
+
+	return EFighterInput::None;
+}
+
+TSharedRef<FFighterCompiledCommands> AFighterGamePluginCharacter::CompileCommands(const TArray<FCommand>& _commands)
+{
+	TSharedRef<FFighterCompiledCommands> compiled = MakeShared<FFighterCompiledCommands>();
+
+	FFighterInput steps[FFighterCommandMatcher::MaxCommandLength];
+	int32 frameWindows[FFighterCommandMatcher::MaxCommandLength];
+
+	for (int32 commandIndex = 0; commandIndex < _commands.Num(); ++commandIndex)
+	{
+		const FCommand& command = _commands[commandIndex];
+		const int32 numSteps = FMath::Min(command.inputs.Num(), FFighterCommandMatcher::MaxCommandLength);
+
+		for (int32 step = 0; step < numSteps; ++step)
+		{
+			steps[step] = ParseInputName(command.inputs[step]);
+			frameWindows[step] = command.inputFrameWindows.IsValidIndex(step) ? command.inputFrameWindows[step] : command.frameWindow;
+		}
+
+		if (command.inputs.Num() > FFighterCommandMatcher::MaxCommandLength
+			|| compiled->matcher.AddCommand(steps, frameWindows, numSteps, command.priority) == INDEX_NONE)
+		{
+			UE_LOG(LogFighter, Warning, TEXT("Command \"%s\" cannot be matched and is ignored"), *command.name);
+			continue;
+		}
+
+		compiled->sourceIndices.Add(commandIndex);
+	}
+
+	compiled->matcher.Compile();
+	return compiled;
+}
+
+void AFighterGamePluginCharacter::CheckInputBufferForCommand()
+{
+	FIGHTER_SCOPE_CYCLE_COUNTER(CheckInputBufferForCommand);
+
+	//Characters that never began play have not compiled their commands yet
+	if (!compiledCommands.IsValid())
+	{
+		CompileCharacterCommands();
+	}
+
+	matchedCommandIndices.Reset();
+
+	//Only feed the frames that arrived since the last check; frames older than the buffer are gone
+	const int32 newestFrame = inputHistory.GetFrameByAge(0);
+	const int32 numNewFrames = FMath::Min(newestFrame - lastCheckedFrame, inputHistory.Num());
+	lastCheckedFrame = newestFrame;
+
+	int32 matchedCommands[FFighterCommandMatcher::MaxMatchesPerFrame];
+
+	for (int32 age = numNewFrames - 1; age >= 0; --age)
+	{
+		const FFighterInput pressed = inputHistory.GetPressedByAge(age);
+		if (pressed == EFighterInput::None)
+		{
+			continue;
+		}
+
+		const int32 numMatches = compiledCommands->matcher.Advance(commandMatcherState, pressed, inputHistory.GetFrameByAge(age), matchedCommands);
+
+		//Every command that completed on the frame is used, highest priority first
+		FIGHTER_ADD_COUNTER(CommandsMatched, numMatches);
+		for (int32 match = 0; match < numMatches; ++match)
+		{
+			const int32 commandIndex = compiledCommands->sourceIndices[matchedCommands[match]];
+			characterCommands[commandIndex].hasUsedCommand = true;
+			matchedCommandIndices.Add(commandIndex);
+		}
+	}
+}
+
+void AFighterGamePluginCharacter::CompileCharacterCommands()
+{
+	compiledCommands = CompileCommands(characterCommands);
+	FFighterCommandMatcher::ResetState(commandMatcherState);
 }
 
@@ -4,6 +4,12 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "FighterSimulation.h"
+#include "FighterInputBuffer.h"
+#include "FighterCommandMatcher.h"
+#include "FighterMatchManager.h"
+#include "FighterMoveSetAsset.h"
+#include "FighterMovementComponent.h"
 #include "FighterGamePluginCharacter.generated.h"
 
 UENUM(BlueprintType)
@@ -19,6 +25,9 @@ enum class ECharacterState : uint8
 	VE_Launched		UMETA(DisplayName = "LAUNCHED")
 };
 
+//The frame and the input recorded for it
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnFighterInputRecorded, int32, FFighterInput);
+
 USTRUCT(BlueprintType)
 struct FCommand
 {
@@ -33,6 +42,18 @@ public:
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Input")
 		bool hasUsedCommand;
+
+	//The most frames allowed between one input of the command and the next
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Input")
+		int32 frameWindow = 12;
+
+	//Overrides frameWindow for each input of the command. The first entry is not used.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Input")
+		TArray<int32> inputFrameWindows;
+
+	//When several commands complete on the same frame, the one with the highest priority is used
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Input")
+		int32 priority = 0;
 };
 
 USTRUCT(BlueprintType)
@@ -48,26 +69,40 @@ public:
 		float timeStamp;
 };
 
-UCLASS(config=Game)
-class AFighterGamePluginCharacter : public ACharacter
+//One frame of the input buffer, as seen by blueprints
+USTRUCT(BlueprintType)
+struct FBufferedInput
 {
 	GENERATED_BODY()
 
-	/** Side view camera */
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
-	class UCameraComponent* SideViewCameraComponent;
+public:
+	//The EFighterInput bits held on this frame
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Input")
+		int32 inputBits;
 
-	/** Camera boom positioning the camera beside the character */
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
-	class USpringArmComponent* CameraBoom;
+	//The bits that went down on this frame
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Input")
+		int32 pressedBits;
 
+	//The simulation frame the input belongs to
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Input")
+		int32 frame;
+};
+
+UCLASS(config=Game)
+class AFighterGamePluginCharacter : public ACharacter
+{
+	GENERATED_BODY()
+
+public:
+	//Bound to the attack actions. The performance tests press them directly.
 	void StartAttack1();
 	void StartAttack2();
 	void StartAttack3();
 	void StartAttack4();
 	void StartExceptionalAttack();
 
-	//When in Keyboard-Only mode, use these functions to perform actions with player 2
+	//When in Keyboard-Only mode, use these functions to perform actions with player 2. The CPU opponent presses player 2's inputs through them too.
 	UFUNCTION(BlueprintCallable)
 		void P2KeyboardAttack1();
 
@@ -100,8 +135,6 @@ protected:
 	/** Called for side to side input using gamepad */
 	void MoveRightController(float _val);
 
-	void Tick(float DeltaTime);
-
 	/** Handle touch inputs. */
 	void TouchStarted(const ETouchIndex::Type FingerIndex, const FVector Location);
 
@@ -112,36 +145,76 @@ protected:
 	virtual void SetupPlayerInputComponent(class UInputComponent* InputComponent) override;
 	// End of APawn interface
 
+	virtual void BeginPlay() override;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+	//Compiles this character's own characterCommands into compiledCommands
+	void CompileCharacterCommands();
+
+	//Calls AddInputIconToScreen for the input recorded this frame, as the input callbacks used to
+	void AddRecordedInputIcons();
+
+	//Adds the names of _pressedInput's bits to inputBuffer, dropping the oldest past its limit
+	void AddNamedInputs(FFighterInput _pressedInput);
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hitbox")
 		AActor* hurtbox;
 
+public:
+	//The blueprint used for this character's proximity and strike boxes (HitboxActorBP)
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Hitbox")
+		TSubclassOf<class AHitboxActor> hitboxClass;
+
+	//The blueprint used for this character's hurtboxes (HurtboxActorBP)
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Hitbox")
+		TSubclassOf<class AHitboxActor> hurtboxClass;
+
+	//How many proximity and strike boxes are spawned for this character when the match starts
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Hitbox")
+		int32 hitboxPoolSize;
+
+	//How many hurtboxes are spawned for this character when the match starts
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Hitbox")
+		int32 hurtboxPoolSize;
+
+	//The character's frame data. Without one, the default moves are used.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Attacks")
+		UFighterMoveSetAsset* moveSet;
+
+	//The character's walk, jump and air control, in place of the CharacterMovementComponent. GetCharacterMovement() is always null on fighters,
+	//so blueprints read this or GetMovementComponent, which returns it, and set movement values here instead of on CharacterMovement.
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement")
+		UFighterMovementComponent* fighterMovement;
+
+protected:
+
 	//Override the ACharacter and APawn functionality to have functionality to have more control over jumps and landings
 	virtual void Jump() override;
 	virtual void StopJumping() override;
-	virtual void Landed(const FHitResult& Hit) override;
 
 	//Make the character begin crouching
 	UFUNCTION(BlueprintCallable)
 		void StartCrouching();
 
-	//Enter the stun-state
-	void BeginStun();
-
-	//Exit the stun-state
-	void ExitStun();
-
-	//Adds input to the input buffer
+	//Adds input to the input buffer. It is recorded with the rest of this frame's input on the next simulation frame.
 	UFUNCTION(BlueprintCallable)
 		void AddInputToInputBuffer(FInputInfo _inputInfo);
 
+	//The number of frames stored in the input buffer
+	UFUNCTION(BlueprintPure, Category = "Input")
+		int32 GetInputBufferNum() const;
+
+	//The input from _age frames ago, where 0 is the newest frame
+	UFUNCTION(BlueprintPure, Category = "Input")
+		FBufferedInput GetBufferedInput(int32 _age) const;
+
 	//Check if the input buffer contains any sequences from the character's list of commands
 	UFUNCTION(BlueprintCallable)
 		void CheckInputBufferForCommand();
 
-	//Make the character begin using a command based off the command's name
-	UFUNCTION(BlueprintCallable)
-		void StartCommand(FString _commandName);
-
 	//Make the character stop crouching
 	UFUNCTION(BlueprintCallable)
 		void StopCrouching();
@@ -154,14 +227,16 @@ protected:
 	UFUNCTION(BlueprintCallable)
 		void StopBlocking();
 
-	//Determine what the character should do when colliding with a proximity hitbox
+	//Determine what the character should do when colliding with a proximity hitbox. Pooled hitboxes do this through the game mode's hit resolution.
 	UFUNCTION(BlueprintCallable)
 		void CollidedWithProximityHitbox();
 
-	//Damage the player
+	//Damage the player. Pooled hitboxes do this through the game mode's hit resolution.
 	UFUNCTION(BlueprintCallable)
 		void TakeDamage(float _damageAmount, float _hitstunTime, float _blockstunTime);
 
+	//Called from the recorded input once per simulation frame, but only while no UFighterInputHistoryWidget shows this character.
+	//Kept for input stack blueprints that have not moved to the widget; set the game mode's inputHistoryWidgetClass to replace them.
 	UFUNCTION(BlueprintImplementableEvent)
 		void AddInputIconToScreen(int _iconIndex, bool _shouldAddInput = true);
 	
@@ -187,14 +262,19 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Model")
 		FVector scale;
 
-	//The timer handle for all stuns (hitstuns, blockstuns, and stunning attacks)
-		FTimerHandle stunTimerHandle;
-
 	//The amount of time the character will be stunned (hitStun, blockStun, or from a stunning attack)
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
 		float stunTime;
 
-	//Has the player used the light attack
+	//The move the character is doing
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Attacks")
+		EFighterMoveId currentMove;
+
+	//How many frames into currentMove the character is, from 0 on the frame it started
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Attacks")
+		int32 currentMoveFrame;
+
+	//Has the player used the light attack. This and the other attack flags are set from currentMove.
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Attacks")
 	bool wasLightAttackUsed;
 
@@ -214,6 +294,14 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Model")
 		bool isFlipped;
 
+	//How far apart the players are, set by the match manager so the other player does not have to be queried
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Player References")
+		float distanceToOtherPlayer;
+
+	//Did the players swap sides on the last update
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Player References")
+		bool hasSwitchedSides;
+
 	//Has the player landed a hit with their last attack
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Attacks")
 		bool hasLandedHit;
@@ -233,15 +321,28 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Input")
 		TArray<FCommand> characterCommands;
 
-	//Commands to be used when a correct series of inputs has been pressed
-	FCommand tempCommand;
+	//This character's commands compiled into a matcher, rebuilt whenever characterCommands is edited
+	TSharedPtr<const FFighterCompiledCommands> compiledCommands;
+
+	//Indices into characterCommands of the commands completed on the frames the last check looked at, oldest frame first and highest priority first within a frame
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "Input")
+		TArray<int32> matchedCommandIndices;
+
+	//This character's progress through the command matcher
+	FFighterCommandMatcher::FState commandMatcherState;
+
+	//The newest input buffer frame that has been checked for commands
+	int32 lastCheckedFrame;
 
 	//Have the temp commands been used
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Input")
 		bool hasUsedTempCommand;
 
-	//The array of inputs the player controlling this character has performed
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Input")
+	//The inputs the player controlling this character has performed, one word per simulation frame
+	FFighterInputBuffer inputHistory;
+
+	//The newest inputs pressed, by name and oldest first, for blueprints that read the old input buffer. Filled from inputHistory.
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "Input")
 		TArray<FInputInfo> inputBuffer;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Input Stack")
@@ -267,11 +368,65 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Attacks")
 		float superMeterAmount;
 
+	//Input held down since the last simulation frame
+	FFighterInput heldInput;
+
+	//Input pressed since the last simulation frame, kept separately so a press and release inside one frame is not lost
+	FFighterInput pressedInput;
+
+	//The engine frame whose axis callbacks set the held directions
+	uint64 axisInputFrame;
+
+	//The directions the axis callbacks held on the engine frame before axisInputFrame
+	FFighterInput previousAxisInput;
+
+	//Where the character stood when the match started. The simulation works relative to its ground height.
+	FVector simulationOrigin;
+
+	//The component flipped to face the other player, looked up once by InitializeSimulationView
+	UPROPERTY(Transient)
+		USceneComponent* modelComponent;
+
+	//Marks _input as pressed for the next simulation frame only, as attacks are
+	void AddPressedInput(FFighterInput _input);
+
+	//Tells the game mode's input latency capture, if one is running, that _input has reached its handler
+	void NoteInputHandled(FFighterInput _input);
+
 public:
-	AFighterGamePluginCharacter();
+	AFighterGamePluginCharacter(const FObjectInitializer& ObjectInitializer);
+
+	virtual UPawnMovementComponent* GetMovementComponent() const override { return fighterMovement; }
+
+	//Marks _input as pressed, and held until ReleaseInput is called
+	void PressInput(FFighterInput _input);
+
+	//Marks _input as no longer held
+	void ReleaseInput(FFighterInput _input);
+
+	//Returns the input held now plus anything pressed since the last call, to be fed into one simulation frame
+	FFighterInput ConsumeSimulationInput();
+
+	//Remember where the character stands as the simulation's origin, and hand its updates over to the match manager
+	void InitializeSimulationView(AFighterGamePluginCharacter* _otherPlayer);
+
+	const FVector& GetSimulationOrigin() const { return simulationOrigin; }
+
+	//Copy the simulation state onto the character's properties, transform and model. _frame is the match's current frame.
+	void SyncFromSimulation(const FSimFighterState& _state, int32 _frame, const FFighterMatchView& _view);
+
+	//Store the input that was simulated on _frame and look for commands
+	void RecordInput(int32 _frame, FFighterInput _input);
+
+	//Forget every recorded input and any command in progress, for when the match jumps to another frame
+	void ResetInputHistory();
+
+	//Broadcast by RecordInput, once per simulation frame, for input displays
+	FOnFighterInputRecorded onInputRecorded;
+
+	//Converts an input name ("Left", "Jump", "Attack1", "A", ...) to its EFighterInput bits
+	static FFighterInput ParseInputName(const FString& _inputName);
 
-	/** Returns SideViewCameraComponent subobject **/
-	FORCEINLINE class UCameraComponent* GetSideViewCameraComponent() const { return SideViewCameraComponent; }
-	/** Returns CameraBoom subobject **/
-	FORCEINLINE class USpringArmComponent* GetCameraBoom() const { return CameraBoom; }
+	//Builds a command matcher for _commands. Commands with unknown or combined inputs are left out.
+	static TSharedRef<FFighterCompiledCommands> CompileCommands(const TArray<FCommand>& _commands);
 };
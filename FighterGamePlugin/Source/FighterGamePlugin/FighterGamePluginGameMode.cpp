@@ -2,14 +2,874 @@
 
 #include "FighterGamePluginGameMode.h"
 #include "FighterGamePluginCharacter.h"
-#include "UObject/ConstructorHelpers.h"
+#include "HitboxPoolSubsystem.h"
+#include "HitboxDisplayComponent.h"
+#include "FighterCollision.h"
+#include "FighterMoveSetAsset.h"
+#include "FighterInputHistoryWidget.h"
+#include "BaseGameInstance.h"
+#include "GameFramework/DefaultPawn.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Engine/Engine.h"
+#include "Components/CapsuleComponent.h"
+#include "DrawDebugHelpers.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Parse.h"
+#include "FighterGamePlugin.h"
+
+DECLARE_CYCLE_STAT(TEXT("GameMode Tick"), STAT_FighterGameModeTick, STATGROUP_Fighter);
+DECLARE_CYCLE_STAT(TEXT("GameMode StepMatch"), STAT_FighterStepMatch, STATGROUP_Fighter);
+DECLARE_CYCLE_STAT(TEXT("Simulation Step"), STAT_FighterSimulationStep, STATGROUP_Fighter);
+DECLARE_CYCLE_STAT(TEXT("GameMode SyncPlayersFromSimulation"), STAT_FighterSyncPlayersFromSimulation, STATGROUP_Fighter);
 
 AFighterGamePluginGameMode::AFighterGamePluginGameMode()
 {
-	// set default pawn class to our Blueprinted character
-	static ConstructorHelpers::FClassFinder<APawn> PlayerPawnBPClass(TEXT("/Game/SideScrollerCPP/Blueprints/YBotCharacter"));
-	if (PlayerPawnBPClass.Class != nullptr)
+	// set default pawn class to our Blueprinted character, resolved in InitGame so making the game mode never loads it
+	defaultPawnSoftClass = TSoftClassPtr<APawn>(FSoftObjectPath(TEXT("/Game/SideScrollerCPP/Blueprints/YBotCharacterBP.YBotCharacterBP_C")));
+
+	PrimaryActorTick.bCanEverTick = true;
+
+	player1 = nullptr;
+	player2 = nullptr;
+	FMemory::Memzero(&matchState, sizeof(matchState));
+	isMatchStarted = false;
+	unsimulatedSeconds = 0.0;
+	hitboxDisplay = nullptr;
+	hitboxPool = nullptr;
+	lastRecordedFrame = 0;
+	shouldExitAfterLatencyTest = false;
+	stepEndCycles = 0;
+	spectatorView = nullptr;
+	fightCameraClass = AFighterCamera::StaticClass();
+	fightCamera = nullptr;
+}
+
+void AFighterGamePluginGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	Super::InitGame(MapName, Options, ErrorMessage);
+
+	//Blueprint game modes that pick their own pawn class keep it
+	if (DefaultPawnClass != ADefaultPawn::StaticClass())
+	{
+		return;
+	}
+
+	//The character chosen in the menus, which the game instance loaded before opening the stage. The default is only for maps opened directly.
+	TSoftClassPtr<APawn> pawnSoftClass = defaultPawnSoftClass;
+	if (const UBaseGameInstance* baseGameInstance = Cast<UBaseGameInstance>(GetGameInstance()))
+	{
+		const TSoftClassPtr<AFighterGamePluginCharacter> selectedClass = baseGameInstance->GetSelectedCharacterClass();
+		if (!selectedClass.IsNull())
+		{
+			pawnSoftClass = TSoftClassPtr<APawn>(selectedClass.ToSoftObjectPath());
+		}
+	}
+
+	if (!pawnSoftClass.IsNull())
+	{
+		//Only a map opened directly, without the menus, waits on this load
+		if (!pawnSoftClass.IsValid())
+		{
+			UE_LOG(LogFighter, Log, TEXT("%s was not preloaded, loading it now"), *pawnSoftClass.ToString());
+		}
+		DefaultPawnClass = pawnSoftClass.LoadSynchronous();
+	}
+}
+
+void AFighterGamePluginGameMode::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	FIGHTER_SCOPE_CYCLE_COUNTER(GameModeTick);
+
+	//The player references are filled in by blueprint once both characters exist
+	if (!player1 || !player2)
+	{
+		return;
+	}
+
+	if (!isMatchStarted)
+	{
+		hitboxPool = GetWorld()->GetSubsystem<UHitboxPoolSubsystem>();
+		if (hitboxPool)
+		{
+			for (AFighterGamePluginCharacter* player : { player1, player2 })
+			{
+				hitboxPool->PreallocateForFighter(player, player->hitboxClass, player->hurtboxClass, player->hitboxPoolSize, player->hurtboxPoolSize);
+			}
+		}
+
+		uint8 moveSetIds[2];
+		RegisterMoveSets(moveSetIds[0], moveSetIds[1]);
+
+		FighterSim::ResetMatch(matchState, FFixed::FromFloat(player1->GetActorLocation().Y), FFixed::FromFloat(player2->GetActorLocation().Y), moveSetIds[0], moveSetIds[1]);
+		matchManager.Start(player1, player2, matchState);
+		isMatchStarted = true;
+		unsimulatedSeconds = 0.0;
+
+		StartFightCamera();
+		StartInputHistoryWidgets();
+
+		if (UBaseGameInstance* baseGameInstance = Cast<UBaseGameInstance>(GetGameInstance()))
+		{
+			baseGameInstance->OnFightStarted();
+		}
+	}
+
+	//The match always runs at FighterSim::FramesPerSecond, however fast the game renders
+	const double secondsPerStep = 1.0 / FighterSim::FramesPerSecond;
+	unsimulatedSeconds += DeltaSeconds;
+	const uint64 tickCycles = FPlatformTime::Cycles64();
+
+	int32 numSteps = 0;
+	while (unsimulatedSeconds >= secondsPerStep && numSteps < MaxStepsPerTick)
+	{
+		//The time left unsimulated after this step is how long ago its frame ended
+		const uint64 unsimulatedCycles = (uint64)((unsimulatedSeconds - secondsPerStep) / FPlatformTime::GetSecondsPerCycle64());
+		stepEndCycles = FMath::Max(stepEndCycles, tickCycles - FMath::Min(unsimulatedCycles, tickCycles));
+
+		StepMatch();
+		unsimulatedSeconds -= secondsPerStep;
+		++numSteps;
+	}
+
+	//After a hitch, drop the time that could not be caught up instead of spiralling
+	if (numSteps == MaxStepsPerTick)
+	{
+		unsimulatedSeconds = FMath::Min(unsimulatedSeconds, secondsPerStep);
+	}
+
+	if (numSteps > 0)
+	{
+		SyncPlayersFromSimulation();
+	}
+
+	//Every frame rather than every step, so the camera eases smoothly at any frame rate
+	if (fightCamera)
+	{
+		fightCamera->UpdateCamera(DeltaSeconds, matchState);
+	}
+
+	UpdateSpectatorView(DeltaSeconds);
+
+	if (inputLatency.IsValid())
+	{
+		inputLatency->Tick(GetWorld());
+
+		if (inputLatency->IsSyntheticInputFinished())
+		{
+			const int32 numMeasured = inputLatency->GetStats(0).stages[(int32)EFighterLatencyStage::Total].Num() + inputLatency->GetStats(1).stages[(int32)EFighterLatencyStage::Total].Num();
+			const bool shouldExit = shouldExitAfterLatencyTest;
+			StopInputLatencyCapture(TEXT("SyntheticInputLatency"));
+
+			if (shouldExit)
+			{
+				FPlatformMisc::RequestExitWithStatus(false, numMeasured > 0 ? 0 : 1);
+			}
+		}
+	}
+}
+
+void AFighterGamePluginGameMode::StepMatch()
+{
+	FIGHTER_SCOPE_CYCLE_COUNTER(StepMatch);
+
+	//The CPU presses its inputs the same way a player would, before they are gathered
+	if (cpuOpponent.IsValid())
+	{
+		cpuOpponent->Tick(matchState);
+	}
+
+	FFighterInput player1Input;
+	FFighterInput player2Input;
+	matchManager.GatherInputs(player1Input, player2Input);
+
+	//Players the sampler reads take its input for exactly this frame's window instead. The CPU presses player 2's bindings, so keeps them.
+	if (inputSampler.IsValid())
+	{
+		if (inputSampler->HasDevices(0))
+		{
+			player1Input = inputSampler->ConsumeFrame(0, stepEndCycles);
+		}
+		if (inputSampler->HasDevices(1) && !cpuOpponent.IsValid())
+		{
+			player2Input = inputSampler->ConsumeFrame(1, stepEndCycles);
+		}
+	}
+
+	//While a replay plays, its inputs replace the players'
+	if (replayReader.IsValid())
+	{
+		if (!replayReader->GetInputs(matchState.frame + 1, player1Input, player2Input))
+		{
+			StopReplay();
+		}
+	}
+
+	FIGHTER_ADD_COUNTER(SimulationSteps, 1);
+
+	if (inputLatency.IsValid())
+	{
+		inputLatency->BeginStep(matchState);
+	}
+
+	const int32 previousFrame = matchState.frame;
+
+	if (rollbackLoopback.IsValid())
+	{
+		FIGHTER_SCOPE_CYCLE_COUNTER(SimulationStep);
+		rollbackLoopback->Tick(GetWorld()->GetTimeSeconds(), player1Input, player2Input);
+		matchState = rollbackLoopback->GetSession(0).GetState();
+
+		RecordRollbackFrames(rollbackLoopback->GetSession(0).GetVerifiedFrame());
+	}
+	else
+	{
+		int32 numHits = 0;
+		{
+			FIGHTER_SCOPE_CYCLE_COUNTER(SimulationStep);
+			numHits = FighterSim::Step(matchState, player1Input, player2Input);
+		}
+		FIGHTER_ADD_COUNTER(HitsResolved, numHits);
+
+		if (replayWriter.IsValid())
+		{
+			replayWriter->RecordFrame(player1Input, player2Input, matchState);
+			lastRecordedFrame = matchState.frame;
+		}
+	}
+
+	if (inputLatency.IsValid())
+	{
+		inputLatency->EndStep(player1Input, player2Input, matchState);
+	}
+
+	//A stalled rollback session does not advance, and its frame's input was already recorded
+	if (matchState.frame > previousFrame)
+	{
+		matchManager.RecordInputs(matchState.frame, player1Input, player2Input);
+	}
+
+	if (spectatorServer.IsValid())
+	{
+		spectatorServer->Broadcast(matchState, GetWorld()->GetTimeSeconds());
+	}
+}
+
+void AFighterGamePluginGameMode::RegisterMoveSets(uint8& _outPlayer1MoveSetId, uint8& _outPlayer2MoveSetId)
+{
+	uint8* moveSetIds[2] = { &_outPlayer1MoveSetId, &_outPlayer2MoveSetId };
+	AFighterGamePluginCharacter* players[2] = { player1, player2 };
+
+	//Each player gets their own move set slot, so a mirror match can still use two different assets and movements. Players without an asset use the default moves.
+	for (int32 playerIndex = 0; playerIndex < 2; ++playerIndex)
+	{
+		FFighterMoveTable moveTable;
+		if (const UFighterMoveSetAsset* moveSet = players[playerIndex]->moveSet)
+		{
+			moveSet->BuildMoveTable(moveTable);
+		}
+		else
+		{
+			FighterMoves::BuildDefaultMoveSet(moveTable);
+		}
+
+		if (const UFighterMovementComponent* fighterMovement = players[playerIndex]->fighterMovement)
+		{
+			moveTable.movement = fighterMovement->BuildMovementParams();
+		}
+
+		const uint8 moveSetId = (uint8)(playerIndex + 1);
+		FighterMoves::RegisterMoveSet(moveSetId, moveTable);
+		*moveSetIds[playerIndex] = moveSetId;
+	}
+}
+
+int32 AFighterGamePluginGameMode::GetPlayerIndex(const AFighterGamePluginCharacter* _character) const
+{
+	if (_character && _character == player1)
+	{
+		return 0;
+	}
+	if (_character && _character == player2)
+	{
+		return 1;
+	}
+	return INDEX_NONE;
+}
+
+void AFighterGamePluginGameMode::SyncPlayersFromSimulation()
+{
+	FIGHTER_SCOPE_CYCLE_COUNTER(SyncPlayersFromSimulation);
+
+	matchManager.Update(matchState);
+	UpdateHitboxActors();
+	UpdateHitboxDisplay();
+}
+
+void AFighterGamePluginGameMode::UpdateHitboxActors()
+{
+	if (!hitboxPool)
+	{
+		return;
+	}
+
+	FFighterHitboxTable table;
+	FighterSim::BuildHitboxTable(matchState, table);
+
+	hitboxPool->ShowFighterBoxes(player1, 0, table, player1->GetSimulationOrigin());
+	hitboxPool->ShowFighterBoxes(player2, 1, table, player2->GetSimulationOrigin());
+}
+
+void AFighterGamePluginGameMode::UpdateHitboxDisplay()
+{
+	//With the display off this is the only cost: nothing is built or drawn
+	if (!UHitboxDisplayComponent::IsDisplayEnabled())
+	{
+		if (hitboxDisplay)
+		{
+			hitboxDisplay->DestroyComponent();
+			hitboxDisplay = nullptr;
+		}
+		return;
+	}
+
+	//The game mode is a hidden actor, so the display is registered with the world on its own, like the world's line batcher
+	if (!hitboxDisplay)
+	{
+		hitboxDisplay = NewObject<UHitboxDisplayComponent>(this);
+		hitboxDisplay->RegisterComponentWithWorld(GetWorld());
+	}
+
+	hitboxDisplay->UpdateFromMatch(matchState, player1->GetSimulationOrigin(), player2->GetSimulationOrigin());
+}
+
+void AFighterGamePluginGameMode::UpdateSpectatorView(float _deltaSeconds)
+{
+	if (!spectatorView)
+	{
+		return;
+	}
+
+	FFighterSpectatorViewer& viewer = spectatorView->GetViewer();
+	viewer.Advance(_deltaSeconds);
+
+	FFighterSpectatorView view;
+	if (!FFighterSpectatorViewer::IsDisplayEnabled() || !viewer.GetView(view))
+	{
+		return;
+	}
+
+	//Each frame's messages replace the last frame's
+	constexpr int32 OnScreenMessageKey = 0x46535000;
+
+	AFighterGamePluginCharacter* players[2] = { player1, player2 };
+	for (int32 playerIndex = 0; playerIndex < 2; ++playerIndex)
+	{
+		const FFighterSpectatorFighterView& fighter = view.fighters[playerIndex];
+		const FVector& origin = players[playerIndex]->GetSimulationOrigin();
+		const UCapsuleComponent* capsule = players[playerIndex]->GetCapsuleComponent();
+
+		//Placed the way SyncFromSimulation places the character, so it sits over them, trailing by the interpolation delay
+		DrawDebugCapsule(GetWorld(), FVector(origin.X, fighter.positionX, origin.Z + fighter.positionZ), capsule->GetScaledCapsuleHalfHeight(), capsule->GetScaledCapsuleRadius(),
+			FQuat::Identity, FColor::Cyan);
+
+		if (GEngine)
+		{
+			GEngine->AddOnScreenDebugMessage(OnScreenMessageKey + playerIndex, 0.0f, FColor::Cyan,
+				FString::Printf(TEXT("Spectator P%d: frame %.1f, health %.2f, meter %.2f, state %d, move %d frame %d"),
+					playerIndex + 1, view.frame, fighter.health, fighter.superMeter, (int32)fighter.characterState, (int32)fighter.move, fighter.moveFrame));
+		}
+	}
+
+	if (GEngine)
+	{
+		float maxBytesPerSecond = 0.0f;
+		for (int32 spectatorIndex = 0; spectatorIndex < spectatorServer->NumSpectators(); ++spectatorIndex)
+		{
+			maxBytesPerSecond = FMath::Max(maxBytesPerSecond, spectatorServer->GetStats(spectatorIndex).GetBytesPerSecond());
+		}
+
+		GEngine->AddOnScreenDebugMessage(OnScreenMessageKey + 2, 0.0f, FColor::Cyan,
+			FString::Printf(TEXT("Spectator stream: %d spectators, at most %.0f of %d bytes/s"),
+				spectatorServer->NumSpectators(), maxBytesPerSecond, FighterSpectator::BudgetBytesPerSecond));
+	}
+}
+
+void AFighterGamePluginGameMode::SetHitboxDisplayEnabled(bool _isEnabled)
+{
+	UHitboxDisplayComponent::SetDisplayEnabled(_isEnabled);
+
+	if (isMatchStarted)
+	{
+		UpdateHitboxDisplay();
+	}
+}
+
+void AFighterGamePluginGameMode::StartLoopbackRollback(float _latencyMilliseconds, float _jitterMilliseconds, float _packetLossPercent)
+{
+	if (!isMatchStarted)
+	{
+		return;
+	}
+
+	//Finishes recording the previous session's frames before it is replaced
+	StopLoopbackRollback();
+
+	FRollbackLoopbackSettings settings;
+	settings.latencyMilliseconds = _latencyMilliseconds;
+	settings.jitterMilliseconds = _jitterMilliseconds;
+	settings.packetLossPercent = _packetLossPercent;
+	settings.seed = FMath::Rand();
+
+	rollbackLoopback = MakeUnique<FRollbackLoopback>(matchState, settings);
+}
+
+void AFighterGamePluginGameMode::StartFightCamera()
+{
+	UWorld* world = GetWorld();
+
+	for (TActorIterator<AFighterCamera> cameraIterator(world); cameraIterator; ++cameraIterator)
+	{
+		fightCamera = *cameraIterator;
+		break;
+	}
+
+	if (!fightCamera)
+	{
+		FActorSpawnParameters spawnParameters;
+		spawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		fightCamera = world->SpawnActor<AFighterCamera>(fightCameraClass ? *fightCameraClass : AFighterCamera::StaticClass(), FTransform::Identity, spawnParameters);
+	}
+
+	fightCamera->StartMatch(player1, player2, matchState);
+
+	for (FConstPlayerControllerIterator controllerIterator = world->GetPlayerControllerIterator(); controllerIterator; ++controllerIterator)
+	{
+		if (APlayerController* playerController = controllerIterator->Get())
+		{
+			playerController->SetViewTarget(fightCamera);
+		}
+	}
+}
+
+void AFighterGamePluginGameMode::StartInputHistoryWidgets()
+{
+	//Nothing to show it on without a viewport, as on servers and in automation worlds
+	if (!inputHistoryWidgetClass || !GetWorld()->GetGameViewport())
+	{
+		return;
+	}
+
+	AFighterGamePluginCharacter* players[2] = { player1, player2 };
+	for (int32 playerIndex = 0; playerIndex < 2; ++playerIndex)
+	{
+		UFighterInputHistoryWidget* widget = CreateWidget<UFighterInputHistoryWidget>(GetWorld(), inputHistoryWidgetClass);
+		if (!widget)
+		{
+			continue;
+		}
+
+		widget->AddToViewport();
+		widget->SetAnchorsInViewport(FAnchors((float)playerIndex, 0.0f));
+		widget->SetAlignmentInViewport(FVector2D((float)playerIndex, 0.0f));
+		widget->SetCharacter(players[playerIndex]);
+		inputHistoryWidgets.Add(widget);
+	}
+}
+
+void AFighterGamePluginGameMode::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	//The characters may already be on their way out, so the CPU is cancelled without letting go of its inputs
+	cpuOpponent.Reset();
+	inputLatency.Reset();
+	inputSampler.Reset();
+	StopSpectatorStream();
+
+	//Not attached to any actor, so nothing else would unregister it from the world
+	if (hitboxDisplay)
+	{
+		hitboxDisplay->DestroyComponent();
+		hitboxDisplay = nullptr;
+	}
+
+	//The characters may outlive the game mode, so each widget lets go of theirs
+	for (UFighterInputHistoryWidget* widget : inputHistoryWidgets)
+	{
+		if (widget)
+		{
+			widget->SetCharacter(nullptr);
+			widget->RemoveFromParent();
+		}
+	}
+	inputHistoryWidgets.Reset();
+
+	//Flushes the rollback frames not yet verified into the replay before it is closed
+	StopLoopbackRollback();
+	StopReplayRecording();
+	StopReplay();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+bool AFighterGamePluginGameMode::StartSpectatorStream(const FString& _fileName, int32 _numLocalViewers, float _latencyMilliseconds, float _jitterMilliseconds, float _packetLossPercent)
+{
+	if (!isMatchStarted)
+	{
+		return false;
+	}
+
+	StopSpectatorStream();
+
+	TUniquePtr<FFighterSpectatorServer> server = MakeUnique<FFighterSpectatorServer>(FFighterSpectatorSettings());
+
+	if (!_fileName.IsEmpty())
+	{
+		TUniquePtr<FFighterSpectatorFileConnection> file = MakeUnique<FFighterSpectatorFileConnection>();
+		if (!file->Open(FighterSpectator::GetStreamPath(_fileName)))
+		{
+			return false;
+		}
+		server->AddSpectator(MoveTemp(file));
+	}
+
+	FRollbackLoopbackSettings networkSettings;
+	networkSettings.latencyMilliseconds = _latencyMilliseconds;
+	networkSettings.jitterMilliseconds = _jitterMilliseconds;
+	networkSettings.packetLossPercent = _packetLossPercent;
+
+	for (int32 viewerIndex = 0; viewerIndex < _numLocalViewers; ++viewerIndex)
+	{
+		networkSettings.seed = FMath::Rand();
+		FFighterSpectatorLoopback* loopback = static_cast<FFighterSpectatorLoopback*>(server->AddSpectator(MakeUnique<FFighterSpectatorLoopback>(networkSettings)));
+
+		if (!spectatorView)
+		{
+			spectatorView = loopback;
+		}
+	}
+
+	spectatorServer = MoveTemp(server);
+	return true;
+}
+
+void AFighterGamePluginGameMode::StopSpectatorStream()
+{
+	if (!spectatorServer.IsValid())
+	{
+		return;
+	}
+
+	spectatorServer->LogStats();
+	spectatorView = nullptr;
+	spectatorServer.Reset();
+}
+
+bool AFighterGamePluginGameMode::StartReplayRecording(const FString& _fileName)
+{
+	if (!isMatchStarted)
+	{
+		return false;
+	}
+
+	//Under rollback the shown frame may still be corrected, so start from the newest one that will not be
+	const FSimMatchState* startState = &matchState;
+	if (rollbackLoopback.IsValid())
+	{
+		const FFighterRollbackSession& session = rollbackLoopback->GetSession(0);
+		FFighterInput player1Input;
+		FFighterInput player2Input;
+		startState = session.GetSimulatedFrame(session.GetVerifiedFrame(), player1Input, player2Input);
+		if (startState == nullptr)
+		{
+			UE_LOG(LogFighter, Warning, TEXT("Replay recording: frame %d left the rollback history before it was verified"), session.GetVerifiedFrame());
+			return false;
+		}
+	}
+
+	replayWriter = MakeUnique<FFighterReplayWriter>();
+	if (!replayWriter->Begin(FighterReplay::GetReplayPath(_fileName), *startState))
+	{
+		replayWriter.Reset();
+		return false;
+	}
+	lastRecordedFrame = startState->frame;
+	return true;
+}
+
+void AFighterGamePluginGameMode::StopReplayRecording()
+{
+	if (replayWriter.IsValid())
+	{
+		replayWriter->End();
+		replayWriter.Reset();
+	}
+}
+
+bool AFighterGamePluginGameMode::PlayReplay(const FString& _fileName, int32 _startFrame)
+{
+	if (!isMatchStarted)
+	{
+		return false;
+	}
+
+	StopReplayRecording();
+
+	replayReader = MakeUnique<FFighterReplayReader>();
+	if (!replayReader->Open(FighterReplay::GetReplayPath(_fileName)) || !SeekReplay(_startFrame))
+	{
+		replayReader.Reset();
+		return false;
+	}
+	return true;
+}
+
+bool AFighterGamePluginGameMode::SeekReplay(int32 _frame)
+{
+	if (!replayReader.IsValid())
+	{
+		return false;
+	}
+
+	const int32 frame = FMath::Clamp(_frame, replayReader->GetFirstFrame(), replayReader->GetLastFrame());
+	if (!replayReader->Seek(frame, matchState))
+	{
+		return false;
+	}
+
+	//The buffers only take frames in order, and the inputs they hold belong to where the match was before
+	matchManager.ResetInputHistories();
+	SyncPlayersFromSimulation();
+	return true;
+}
+
+void AFighterGamePluginGameMode::StopReplay()
+{
+	replayReader.Reset();
+}
+
+bool AFighterGamePluginGameMode::StartCpuOpponent(float _budgetMilliseconds, int32 _maxDepth)
+{
+	if (!isMatchStarted)
+	{
+		return false;
+	}
+
+	StopCpuOpponent();
+
+	FFighterAISettings settings;
+	settings.maxDepth = FMath::Clamp(_maxDepth, 1, FighterAI::MaxDepth);
+
+	cpuOpponent = MakeUnique<FFighterCpuOpponent>(player2, 1, settings, _budgetMilliseconds);
+	return true;
+}
+
+void AFighterGamePluginGameMode::StopCpuOpponent()
+{
+	if (!cpuOpponent.IsValid())
+	{
+		return;
+	}
+
+	const FFighterCpuOpponentStats& stats = cpuOpponent->GetStats();
+	const int32 numSearches = FMath::Max(stats.numSearches, 1);
+	UE_LOG(LogFighter, Log, TEXT("CPU opponent: %d searches, %.2f average depth, %lld average nodes, %.3f ms max search, %d frames waiting"),
+		stats.numSearches, (float)stats.totalDepth / numSearches, stats.totalNodes / numSearches, stats.maxSearchSeconds * 1000.0, stats.waitingFrames);
+
+	cpuOpponent->ReleaseInputs();
+	cpuOpponent.Reset();
+}
+
+void AFighterGamePluginGameMode::StopLoopbackRollback()
+{
+	if (!rollbackLoopback.IsValid())
+	{
+		return;
+	}
+
+	for (int32 playerIndex = 0; playerIndex < 2; ++playerIndex)
+	{
+		const FRollbackStats& stats = rollbackLoopback->GetSession(playerIndex).GetStats();
+		UE_LOG(LogFighter, Log, TEXT("Rollback P%d: %d frames, %d rollbacks, %d frames resimulated (max %d), %d stalls, %.3f ms max resimulation"),
+			playerIndex + 1, stats.totalFrames, stats.totalRollbacks, stats.totalFramesResimulated, stats.maxRollbackFrames, stats.stalledFrames, stats.maxResimulationSeconds * 1000.0);
+	}
+
+	//The match goes on from the shown frame, so the replay takes the frames not yet verified as they were last simulated
+	RecordRollbackFrames(rollbackLoopback->GetSession(0).GetState().frame);
+
+	rollbackLoopback.Reset();
+}
+
+void AFighterGamePluginGameMode::RecordRollbackFrames(int32 _lastFrame)
+{
+	if (!replayWriter.IsValid())
+	{
+		return;
+	}
+
+	const FFighterRollbackSession& session = rollbackLoopback->GetSession(0);
+
+	for (int32 frame = lastRecordedFrame + 1; frame <= _lastFrame; ++frame)
+	{
+		FFighterInput player1Input;
+		FFighterInput player2Input;
+		const FSimMatchState* frameState = session.GetSimulatedFrame(frame, player1Input, player2Input);
+		if (frameState == nullptr)
+		{
+			UE_LOG(LogFighter, Warning, TEXT("Replay recording stopped: frame %d left the rollback history before it was recorded"), frame);
+			StopReplayRecording();
+			return;
+		}
+
+		replayWriter->RecordFrame(player1Input, player2Input, *frameState);
+		lastRecordedFrame = frame;
+	}
+}
+
+bool AFighterGamePluginGameMode::StartInputSampler(float _pollHz)
+{
+	StopInputSampler();
+
+	if (!FFighterInputSampler::IsSupported())
+	{
+		UE_LOG(LogFighter, Log, TEXT("Input sampler: no device backend on this platform, using the input bindings"));
+		return false;
+	}
+
+	const UBaseGameInstance* baseGameInstance = Cast<UBaseGameInstance>(GetGameInstance());
+	const bool isDeviceForMultiplePlayers = baseGameInstance && baseGameInstance->isDeviceForMultiplePlayers;
+
+	FFighterInputSamplerSettings settings;
+	settings.pollHz = _pollHz;
+	settings.devices[0].keyboardLayout = 1;
+	settings.devices[0].gamepadIndex = isDeviceForMultiplePlayers ? INDEX_NONE : 0;
+	settings.devices[1].keyboardLayout = isDeviceForMultiplePlayers ? 2 : 0;
+	settings.devices[1].gamepadIndex = isDeviceForMultiplePlayers ? INDEX_NONE : 1;
+
+	inputSampler = MakeUnique<FFighterInputSampler>(settings);
+	stepEndCycles = FPlatformTime::Cycles64();
+	return true;
+}
+
+void AFighterGamePluginGameMode::StopInputSampler()
+{
+	if (!inputSampler.IsValid())
+	{
+		return;
+	}
+
+	const FFighterInputSamplerStats stats = inputSampler->GetStats();
+	UE_LOG(LogFighter, Log, TEXT("Input sampler: %d polls, %d input changes, %d changes delayed by a full queue"),
+		stats.numPolls, stats.numChanges, stats.numDropped);
+
+	inputSampler.Reset();
+}
+
+void AFighterGamePluginGameMode::StartInputLatencyCapture()
+{
+	inputLatency = MakeUnique<FFighterInputLatencyTracker>();
+	shouldExitAfterLatencyTest = false;
+}
+
+void AFighterGamePluginGameMode::StopInputLatencyCapture(const FString& _reportName)
+{
+	if (!inputLatency.IsValid())
 	{
-		DefaultPawnClass = PlayerPawnBPClass.Class;
+		return;
 	}
+
+	inputLatency->LogStats();
+
+	if (!_reportName.IsEmpty())
+	{
+		const FString path = FighterInputLatency::GetReportPath(_reportName);
+		if (inputLatency->WriteReport(path))
+		{
+			UE_LOG(LogFighter, Log, TEXT("Input latency report written to %s"), *path);
+		}
+		else
+		{
+			UE_LOG(LogFighter, Warning, TEXT("Could not write the input latency report to %s"), *path);
+		}
+	}
+
+	inputLatency.Reset();
+	shouldExitAfterLatencyTest = false;
+}
+
+void AFighterGamePluginGameMode::StartSyntheticInputLatencyTest(const TArray<FKey>& _keys, int32 _numPresses, bool _shouldExitWhenDone)
+{
+	StartInputLatencyCapture();
+	inputLatency->StartSyntheticInput(_keys, _numPresses);
+	shouldExitAfterLatencyTest = _shouldExitWhenDone;
+}
+
+namespace
+{
+	AFighterGamePluginGameMode* GetFighterGameMode(UWorld* _world)
+	{
+		return _world ? Cast<AFighterGamePluginGameMode>(_world->GetAuthGameMode()) : nullptr;
+	}
+
+	FAutoConsoleCommandWithWorld StartInputLatencyCommand(
+		TEXT("Fighter.InputLatency.Start"),
+		TEXT("Starts timing every press from the platform event to the frame that shows it"),
+		FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* _world)
+		{
+			if (AFighterGamePluginGameMode* gamemode = GetFighterGameMode(_world))
+			{
+				gamemode->StartInputLatencyCapture();
+			}
+		}));
+
+	FAutoConsoleCommandWithWorldAndArgs StopInputLatencyCommand(
+		TEXT("Fighter.InputLatency.Stop"),
+		TEXT("Logs the input latencies and writes them to Saved/Profiling/InputLatency. Arguments: [ReportName=InputLatency]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& _args, UWorld* _world)
+		{
+			if (AFighterGamePluginGameMode* gamemode = GetFighterGameMode(_world))
+			{
+				gamemode->StopInputLatencyCapture(_args.Num() > 0 ? _args[0] : FString(TEXT("InputLatency")));
+			}
+		}));
+
+	//For CI, on a map with both fighters: -game -nullrhi -ExecCmds="Fighter.InputLatency.Synthetic Presses=300 Exit"
+	FAutoConsoleCommandWithWorldAndArgs SyntheticInputLatencyCommand(
+		TEXT("Fighter.InputLatency.Synthetic"),
+		TEXT("Measures input latency with synthetic key presses, then writes the SyntheticInputLatency report. Arguments: [Presses=200] [Keys=W,Q,Z,O,I,K] [Exit]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& _args, UWorld* _world)
+		{
+			AFighterGamePluginGameMode* gamemode = GetFighterGameMode(_world);
+			if (!gamemode)
+			{
+				return;
+			}
+
+			const FString params = FString::Join(_args, TEXT(" "));
+			int32 numPresses = 200;
+			FString keyNames = TEXT("W,Q,Z,O,I,K");
+			FParse::Value(*params, TEXT("Presses="), numPresses);
+			FParse::Value(*params, TEXT("Keys="), keyNames, false);
+
+			TArray<FString> keyNameList;
+			keyNames.ParseIntoArray(keyNameList, TEXT(","));
+
+			TArray<FKey> keys;
+			for (const FString& keyName : keyNameList)
+			{
+				const FKey key(*keyName.TrimStartAndEnd());
+				if (key.IsValid())
+				{
+					keys.Add(key);
+				}
+				else
+				{
+					UE_LOG(LogFighter, Warning, TEXT("Fighter.InputLatency.Synthetic: unknown key %s"), *keyName);
+				}
+			}
+
+			gamemode->StartSyntheticInputLatencyTest(keys, numPresses, _args.Contains(TEXT("Exit")));
+		}));
 }
@@ -5,8 +5,21 @@
 #include "CoreMinimal.h"
 #include "GameFramework/GameModeBase.h"
 #include "FighterGamePluginCharacter.h"
+#include "FighterSimulation.h"
+#include "FighterRollback.h"
+#include "FighterReplay.h"
+#include "FighterMatchManager.h"
+#include "FighterCpuOpponent.h"
+#include "FighterInputLatency.h"
+#include "FighterInputSampler.h"
+#include "FighterSpectatorStream.h"
+#include "FighterCamera.h"
 #include "FighterGamePluginGameMode.generated.h"
 
+class UHitboxDisplayComponent;
+class UHitboxPoolSubsystem;
+class UFighterInputHistoryWidget;
+
 UCLASS(minimalapi)
 class AFighterGamePluginGameMode : public AGameModeBase
 {
@@ -15,11 +28,203 @@ class AFighterGamePluginGameMode : public AGameModeBase
 public:
 	AFighterGamePluginGameMode();
 
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	//The most simulation frames run in one engine tick when catching up after a slow frame
+	static constexpr int32 MaxStepsPerTick = 4;
+
+	//Returns 0 for player 1, 1 for player 2 and INDEX_NONE for anything else
+	int32 GetPlayerIndex(const AFighterGamePluginCharacter* _character) const;
+
+	//Copy the match state onto both player characters, through the match manager
+	void SyncPlayersFromSimulation();
+
+	//Draw every hitbox and hurtbox over the fight, for training mode. The same as the Fighter.ShowHitboxes console variable.
+	UFUNCTION(BlueprintCallable, Category = "Hitbox")
+		void SetHitboxDisplayEnabled(bool _isEnabled);
+
+	//Play the match through two rollback peers joined by a simulated network, to try out netcode locally
+	UFUNCTION(BlueprintCallable, Category = "Netcode")
+		void StartLoopbackRollback(float _latencyMilliseconds, float _jitterMilliseconds, float _packetLossPercent);
+
+	//Go back to stepping the match directly, and log the rollback statistics
+	UFUNCTION(BlueprintCallable, Category = "Netcode")
+		void StopLoopbackRollback();
+
+	/**
+	 * Let the CPU play player 2, through the P2Keyboard inputs, so it needs the keyboard-only mode those are bound in.
+	 * Each decision searches _maxDepth actions ahead on worker threads for at most _budgetMilliseconds, never blocking the game.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "CPU Opponent")
+		bool StartCpuOpponent(float _budgetMilliseconds = 4.0f, int32 _maxDepth = 3);
+
+	//Give player 2 back to the keyboard, and log how the searches went
+	UFUNCTION(BlueprintCallable, Category = "CPU Opponent")
+		void StopCpuOpponent();
+
+	/**
+	 * Read the players' keyboard keys and pads on a thread polling _pollHz times a second, so every press lands on the simulation frame
+	 * it was made in. Keyboard-only mode reads both players' keys, otherwise player 1 has their keys and the first pad and player 2 the second pad.
+	 * Returns false where the platform has no device backend, and the input bindings are used as before.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Input")
+		bool StartInputSampler(float _pollHz = 1000.0f);
+
+	//Go back to the input bindings for every player, and log how the sampler did
+	UFUNCTION(BlueprintCallable, Category = "Input")
+		void StopInputSampler();
+
+	//Time every press from the platform event to the end of the frame that shows it, per player. Fighter.ShowInputLatency puts it on screen.
+	UFUNCTION(BlueprintCallable, Category = "Input Latency")
+		void StartInputLatencyCapture();
+
+	//Log the latencies, and write them to Saved/Profiling/InputLatency/<_reportName>.csv unless _reportName is empty
+	UFUNCTION(BlueprintCallable, Category = "Input Latency")
+		void StopInputLatencyCapture(const FString& _reportName);
+
+	/**
+	 * Capture while pressing _keys on the first player controller _numPresses times, for runs with no one at the keyboard such as -nullrhi in CI.
+	 * When done, writes the SyntheticInputLatency report and, if _shouldExitWhenDone, quits with exit code 1 if no press was measured.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Input Latency")
+		void StartSyntheticInputLatencyTest(const TArray<FKey>& _keys, int32 _numPresses, bool _shouldExitWhenDone);
+
+	/**
+	 * Stream the match to spectators: into Saved/Spectator/<_fileName>.fgspec unless _fileName is empty, where any number of readers can follow it,
+	 * and to _numLocalViewers viewers in this process behind a simulated network. Fighter.ShowSpectatorView draws what the first of them sees.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Spectator")
+		bool StartSpectatorStream(const FString& _fileName, int32 _numLocalViewers = 1, float _latencyMilliseconds = 100.0f, float _jitterMilliseconds = 20.0f, float _packetLossPercent = 2.0f);
+
+	//Stop streaming, and log each spectator's bandwidth
+	UFUNCTION(BlueprintCallable, Category = "Spectator")
+		void StopSpectatorStream();
+
+	//Record the match from this frame on into Saved/Replays/<_fileName>.fgreplay
+	UFUNCTION(BlueprintCallable, Category = "Replay")
+		bool StartReplayRecording(const FString& _fileName);
+
+	UFUNCTION(BlueprintCallable, Category = "Replay")
+		void StopReplayRecording();
+
+	//Play back Saved/Replays/<_fileName>.fgreplay from _startFrame. The players' input is ignored until it ends.
+	UFUNCTION(BlueprintCallable, Category = "Replay")
+		bool PlayReplay(const FString& _fileName, int32 _startFrame);
+
+	//Jump the replay being played to _frame
+	UFUNCTION(BlueprintCallable, Category = "Replay")
+		bool SeekReplay(int32 _frame);
+
+	UFUNCTION(BlueprintCallable, Category = "Replay")
+		void StopReplay();
+
+	//Spawned when the menus chose no character, unless a blueprint sets the default pawn class. Soft, so creating the game mode does not load it.
+	UPROPERTY(EditDefaultsOnly, Category = "Classes")
+		TSoftClassPtr<APawn> defaultPawnSoftClass;
+
+	//Spawned when the match starts if the level has no fight camera placed in it
+	UPROPERTY(EditDefaultsOnly, Category = "Classes")
+		TSubclassOf<AFighterCamera> fightCameraClass;
+
+	//Shows each player's input stack when the match starts. Without one, the characters' AddInputIconToScreen events are called instead.
+	UPROPERTY(EditDefaultsOnly, Category = "Classes")
+		TSubclassOf<UFighterInputHistoryWidget> inputHistoryWidgetClass;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Player References")
 	AFighterGamePluginCharacter* player1;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Player References")
 	AFighterGamePluginCharacter* player2;
+
+	//The gameplay state of the match. The player characters are views over it.
+	FSimMatchState matchState;
+
+	//Has the match state been set up from the players' starting positions
+	bool isMatchStarted;
+
+	//Updates both player characters in order once the match has started
+	FFighterMatchManager matchManager;
+
+	//Engine time not yet simulated, always less than one frame apart from after a hitch
+	double unsimulatedSeconds;
+
+	//Set while the match is played through the rollback loopback. The match state shows player 1's peer.
+	TUniquePtr<FRollbackLoopback> rollbackLoopback;
+
+	//Set while the match is being recorded
+	TUniquePtr<FFighterReplayWriter> replayWriter;
+
+	//The newest frame written to the replay. Under rollback, frames are only written once they are verified.
+	int32 lastRecordedFrame;
+
+	//Set while a replay is playing
+	TUniquePtr<FFighterReplayReader> replayReader;
+
+	//Set while the CPU plays player 2
+	TUniquePtr<FFighterCpuOpponent> cpuOpponent;
+
+	//Set while input latency is being captured
+	TUniquePtr<FFighterInputLatencyTracker> inputLatency;
+
+	//Quit once the synthetic input latency test is done
+	bool shouldExitAfterLatencyTest;
+
+	//Set while the players' devices are read on the sampler thread
+	TUniquePtr<FFighterInputSampler> inputSampler;
+
+	//Where the frame being stepped ends on the platform clock (FPlatformTime::Cycles64), to drain the sampled input up to
+	uint64 stepEndCycles;
+
+	//Set while the match is streamed to spectators
+	TUniquePtr<FFighterSpectatorServer> spectatorServer;
+
+	//The local spectator Fighter.ShowSpectatorView draws, owned by spectatorServer
+	FFighterSpectatorLoopback* spectatorView;
+
+	//Every player's view of the fight, from when the match starts
+	UPROPERTY(Transient)
+		AFighterCamera* fightCamera;
+
+	//Player 1's input stack on the left and player 2's on the right, while the match runs
+	UPROPERTY(Transient)
+		TArray<UFighterInputHistoryWidget*> inputHistoryWidgets;
+
+	//Only exists while the hitbox display is on
+	UPROPERTY(Transient)
+		UHitboxDisplayComponent* hitboxDisplay;
+
+	//Shows the simulation's boxes on each fighter's pooled hitbox actors, from when the match starts
+	UPROPERTY(Transient)
+		UHitboxPoolSubsystem* hitboxPool;
+
+protected:
+	//Runs one simulation frame with both players' input
+	void StepMatch();
+
+	//Creates, feeds or removes the hitbox display to match Fighter.ShowHitboxes
+	void UpdateHitboxDisplay();
+
+	//Moves, shows and hides the pooled hitbox actors to match this frame's boxes
+	void UpdateHitboxActors();
+
+	//Writes the rollback session's frames after lastRecordedFrame up to _lastFrame to the replay
+	void RecordRollbackFrames(int32 _lastFrame);
+
+	//Finds the fight camera placed in the level or spawns one, and makes it every player's view
+	void StartFightCamera();
+
+	//Puts an inputHistoryWidgetClass on screen for each player and binds it to their character
+	void StartInputHistoryWidgets();
+
+	//Plays the local spectator on, and draws it if Fighter.ShowSpectatorView is on
+	void UpdateSpectatorView(float _deltaSeconds);
+
+	//Builds each player's move set from their character's asset and movement component and returns the move set ids to use
+	void RegisterMoveSets(uint8& _outPlayer1MoveSetId, uint8& _outPlayer2MoveSetId);
 };
 
 
@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FighterSimulation.h"
+
+/**
+ * Fixed-capacity history of one player's input, one FFighterInput word per simulation frame.
+ * Adding a frame overwrites the oldest one once the buffer is full, so it never allocates and never grows.
+ */
+template<int32 Capacity>
+struct TFighterInputBuffer
+{
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+	//The input of each frame, indexed by frame number modulo Capacity
+	FFighterInput inputs[Capacity];
+
+	//The frame number of the newest input
+	int32 newestFrame;
+
+	//How many frames are stored, up to Capacity
+	int32 count;
+
+	void Reset()
+	{
+		newestFrame = 0;
+		count = 0;
+	}
+
+	//Stores the input of _frame. Frames must be added in order; skipped frames repeat the last input.
+	void Add(int32 _frame, FFighterInput _input)
+	{
+		checkSlow(count == 0 || _frame > newestFrame);
+
+		if (count > 0)
+		{
+			//Every skipped slot is written even when the buffer is full, or it would still hold the input from Capacity frames ago
+			const FFighterInput lastInput = inputs[newestFrame & (Capacity - 1)];
+			const int32 numSkipped = FMath::Min(_frame - newestFrame - 1, Capacity);
+			for (int32 skippedFrame = _frame - numSkipped; skippedFrame < _frame; ++skippedFrame)
+			{
+				inputs[skippedFrame & (Capacity - 1)] = lastInput;
+			}
+			count = FMath::Min(count + numSkipped, Capacity);
+		}
+
+		inputs[_frame & (Capacity - 1)] = _input;
+		newestFrame = _frame;
+		count = FMath::Min(count + 1, Capacity);
+	}
+
+	int32 Num() const
+	{
+		return count;
+	}
+
+	//The input _age frames ago, where 0 is the newest frame
+	FFighterInput GetByAge(int32 _age) const
+	{
+		checkSlow(_age >= 0 && _age < count);
+		return inputs[(newestFrame - _age) & (Capacity - 1)];
+	}
+
+	//The frame number of the input _age frames ago
+	int32 GetFrameByAge(int32 _age) const
+	{
+		return newestFrame - _age;
+	}
+
+	//The inputs that went down on the frame _age frames ago
+	FFighterInput GetPressedByAge(int32 _age) const
+	{
+		const FFighterInput previousInput = _age + 1 < count ? GetByAge(_age + 1) : EFighterInput::None;
+		return GetByAge(_age) & ~previousInput;
+	}
+};
+
+//About seventeen seconds of input at the simulation rate
+typedef TFighterInputBuffer<1024> FFighterInputBuffer;
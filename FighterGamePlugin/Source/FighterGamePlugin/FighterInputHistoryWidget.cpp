@@ -0,0 +1,179 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FighterInputHistoryWidget.h"
+#include "Blueprint/WidgetTree.h"
+#include "Components/HorizontalBox.h"
+#include "Components/Image.h"
+#include "Components/TextBlock.h"
+#include "Components/VerticalBox.h"
+#include "FighterGamePluginCharacter.h"
+#include "FighterGamePlugin.h"
+
+DECLARE_CYCLE_STAT(TEXT("Input History Update"), STAT_FighterInputHistoryUpdate, STATGROUP_Fighter);
+
+namespace
+{
+	//The input bit each icon stands for, in iconBrushes order
+	const FFighterInput IconInputs[] =
+	{
+		EFighterInput::Up,
+		EFighterInput::Right,
+		EFighterInput::Down,
+		EFighterInput::Left,
+		EFighterInput::Attack1,
+		EFighterInput::Attack2,
+		EFighterInput::Attack3,
+		EFighterInput::Attack4,
+		EFighterInput::Block,
+		EFighterInput::Exceptional
+	};
+
+	constexpr int32 MaxFrameCount = 99;
+}
+
+UFighterInputHistoryWidget::UFighterInputHistoryWidget(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	numRows = 12;
+	iconsPerRow = 4;
+	iconSize = FVector2D(32.0f, 32.0f);
+	newestEntry = 0;
+	numEntries = 0;
+}
+
+TSharedRef<SWidget> UFighterInputHistoryWidget::RebuildWidget()
+{
+	//The only place widgets are made. The tree survives being removed and added back, so this runs once.
+	if (WidgetTree && !WidgetTree->RootWidget)
+	{
+		UVerticalBox* root = WidgetTree->ConstructWidget<UVerticalBox>(UVerticalBox::StaticClass(), TEXT("InputHistory"));
+		WidgetTree->RootWidget = root;
+
+		rows.Reset(numRows);
+		rowFrameCounts.Reset(numRows);
+		rowIcons.Reset(numRows * iconsPerRow);
+
+		for (int32 row = 0; row < numRows; ++row)
+		{
+			UHorizontalBox* rowBox = WidgetTree->ConstructWidget<UHorizontalBox>();
+			root->AddChildToVerticalBox(rowBox);
+			rows.Add(rowBox);
+
+			UTextBlock* frameCount = WidgetTree->ConstructWidget<UTextBlock>();
+			rowBox->AddChildToHorizontalBox(frameCount);
+			rowFrameCounts.Add(frameCount);
+
+			for (int32 icon = 0; icon < iconsPerRow; ++icon)
+			{
+				UImage* image = WidgetTree->ConstructWidget<UImage>();
+				image->SetBrushSize(iconSize);
+				rowBox->AddChildToHorizontalBox(image);
+				rowIcons.Add(image);
+			}
+
+			rowBox->SetVisibility(ESlateVisibility::Collapsed);
+		}
+
+		entries.SetNumZeroed(numRows);
+
+		frameCountTexts.Reset(MaxFrameCount);
+		for (int32 frames = 1; frames <= MaxFrameCount; ++frames)
+		{
+			frameCountTexts.Add(FText::AsNumber(frames));
+		}
+	}
+
+	return Super::RebuildWidget();
+}
+
+void UFighterInputHistoryWidget::NativeDestruct()
+{
+	SetCharacter(nullptr);
+
+	Super::NativeDestruct();
+}
+
+void UFighterInputHistoryWidget::SetCharacter(AFighterGamePluginCharacter* _character)
+{
+	if (AFighterGamePluginCharacter* oldCharacter = character.Get())
+	{
+		oldCharacter->onInputRecorded.Remove(inputRecordedHandle);
+	}
+	inputRecordedHandle.Reset();
+	character = _character;
+
+	numEntries = 0;
+	for (int32 row = 0; row < rows.Num(); ++row)
+	{
+		ShowRow(row, row);
+	}
+
+	if (_character)
+	{
+		inputRecordedHandle = _character->onInputRecorded.AddUObject(this, &UFighterInputHistoryWidget::OnInputRecorded);
+	}
+}
+
+void UFighterInputHistoryWidget::OnInputRecorded(int32 _frame, FFighterInput _input)
+{
+	FIGHTER_SCOPE_CYCLE_COUNTER(InputHistoryUpdate);
+
+	if (entries.Num() == 0)
+	{
+		return;
+	}
+
+	//Still holding the same thing: only the newest row's count changes
+	if (numEntries > 0 && entries[newestEntry].input == _input)
+	{
+		FHistoryEntry& entry = entries[newestEntry];
+		++entry.frames;
+		if (entry.frames <= MaxFrameCount)
+		{
+			rowFrameCounts[0]->SetText(frameCountTexts[entry.frames - 1]);
+		}
+		return;
+	}
+
+	//A change takes over the oldest entry and every row moves down by one
+	newestEntry = (newestEntry + 1) % entries.Num();
+	numEntries = FMath::Min(numEntries + 1, entries.Num());
+	entries[newestEntry].input = _input;
+	entries[newestEntry].frames = 1;
+
+	for (int32 row = 0; row < rows.Num(); ++row)
+	{
+		ShowRow(row, row);
+	}
+}
+
+void UFighterInputHistoryWidget::ShowRow(int32 _row, int32 _age)
+{
+	if (_age >= numEntries)
+	{
+		rows[_row]->SetVisibility(ESlateVisibility::Collapsed);
+		return;
+	}
+
+	const FHistoryEntry& entry = entries[(newestEntry - _age + entries.Num()) % entries.Num()];
+
+	rows[_row]->SetVisibility(ESlateVisibility::HitTestInvisible);
+	rowFrameCounts[_row]->SetText(frameCountTexts[FMath::Min(entry.frames, MaxFrameCount) - 1]);
+
+	//Fill the row's icons from the left, one per input bit with a brush, and hide the rest
+	int32 icon = 0;
+	for (int32 iconIndex = 0; iconIndex < UE_ARRAY_COUNT(IconInputs) && icon < iconsPerRow; ++iconIndex)
+	{
+		if ((entry.input & IconInputs[iconIndex]) && iconBrushes.IsValidIndex(iconIndex))
+		{
+			UImage* image = rowIcons[_row * iconsPerRow + icon++];
+			image->SetBrush(iconBrushes[iconIndex]);
+			image->SetVisibility(ESlateVisibility::HitTestInvisible);
+		}
+	}
+	for (; icon < iconsPerRow; ++icon)
+	{
+		rowIcons[_row * iconsPerRow + icon]->SetVisibility(ESlateVisibility::Collapsed);
+	}
+}
@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/UserWidget.h"
+#include "Styling/SlateBrush.h"
+#include "FighterSimulation.h"
+#include "FighterInputHistoryWidget.generated.h"
+
+class AFighterGamePluginCharacter;
+class UImage;
+class UTextBlock;
+
+/**
+ * The input stack: one row for every change in a character's held input, newest on top, with how many frames it was held.
+ *
+ * All the rows are made once when the widget is built and then only have their icons and text changed. The widget listens
+ * to the character's recorded input, so it updates once per simulation frame and never ticks. Holding a direction only
+ * changes the newest row's frame count. Leave the designer tree of blueprint subclasses empty, as the rows are made in code.
+ */
+UCLASS(meta = (DisableNativeTick))
+class FIGHTERGAMEPLUGIN_API UFighterInputHistoryWidget : public UUserWidget
+{
+	GENERATED_BODY()
+
+public:
+	UFighterInputHistoryWidget(const FObjectInitializer& ObjectInitializer);
+
+	//Show _character's input from now on. Pass null to stop.
+	UFUNCTION(BlueprintCallable, Category = "Input Stack")
+		void SetCharacter(AFighterGamePluginCharacter* _character);
+
+	//How many rows are shown
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Input Stack", meta = (ClampMin = "1", ClampMax = "64"))
+		int32 numRows;
+
+	//The most icons in one row. Inputs past it are left out.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Input Stack", meta = (ClampMin = "1", ClampMax = "10"))
+		int32 iconsPerRow;
+
+	//Numbered as AddInputIconToScreen was: 0 up, 1 right, 2 down, 3 left, 4 to 7 attacks 1 to 4, then 8 block and 9 exceptional
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Input Stack")
+		TArray<FSlateBrush> iconBrushes;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Input Stack")
+		FVector2D iconSize;
+
+protected:
+	virtual TSharedRef<SWidget> RebuildWidget() override;
+	virtual void NativeDestruct() override;
+
+	void OnInputRecorded(int32 _frame, FFighterInput _input);
+
+	//Shows the history entry _age changes old in row _row, or hides the row if there is no such entry
+	void ShowRow(int32 _row, int32 _age);
+
+	struct FHistoryEntry
+	{
+		FFighterInput input;
+		int32 frames;
+	};
+
+	//One icon per input bit, iconsPerRow for each row
+	UPROPERTY(Transient)
+		TArray<UImage*> rowIcons;
+
+	UPROPERTY(Transient)
+		TArray<UTextBlock*> rowFrameCounts;
+
+	UPROPERTY(Transient)
+		TArray<UWidget*> rows;
+
+	TWeakObjectPtr<AFighterGamePluginCharacter> character;
+	FDelegateHandle inputRecordedHandle;
+
+	//Ring of the last numRows changes in held input
+	TArray<FHistoryEntry> entries;
+	int32 newestEntry;
+	int32 numEntries;
+
+	//"1" to "99", made once so counting frames never builds text
+	TArray<FText> frameCountTexts;
+};
@@ -0,0 +1,504 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FighterInputLatency.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Framework/Application/IInputProcessor.h"
+#include "Framework/Application/SlateApplication.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "RenderingThread.h"
+#include "FighterGamePlugin.h"
+
+namespace
+{
+	int32 ShowInputLatency = 1;
+
+	FAutoConsoleVariableRef ShowInputLatencyVariable(
+		TEXT("Fighter.ShowInputLatency"),
+		ShowInputLatency,
+		TEXT("Shows each player's input latency percentiles on screen while they are being captured. 0 is off."));
+
+	const TCHAR* StageNames[] =
+	{
+		TEXT("InputToHandler"),
+		TEXT("HandlerToSimulation"),
+		TEXT("SimulationToPresent"),
+		TEXT("Total")
+	};
+	static_assert(UE_ARRAY_COUNT(StageNames) == (int32)EFighterLatencyStage::Count, "Every latency stage needs a name");
+
+	//Platform events no handler has taken by then were for keys the fight does not use
+	constexpr double MaxArrivalMilliseconds = 250.0;
+
+	//A handled press the match has not stepped by then is dropped, for when the match is paused or not started
+	constexpr double MaxHandledMilliseconds = 1000.0;
+
+	//The same dead zone the characters' MoveRight uses
+	constexpr float StickDeadZone = 0.20f;
+
+	//Synthetic keys are held for a few simulation frames, then released for a random time long enough for the press to finish
+	constexpr double SyntheticHoldSeconds = 0.1;
+	constexpr double SyntheticMinGapSeconds = 0.3;
+	constexpr double SyntheticMaxGapSeconds = 0.6;
+
+	constexpr int32 OnScreenMessageKey = 0x46494c00;
+
+	//The cycles each engine frame's rendering ended at, by GFrameCounter, written only by the render thread.
+	//LastPresentedFrame is published after the cycles, so any frame at or before it can be read from the game thread.
+	constexpr int32 NumPresentedFrames = 64;
+	uint64 PresentedCycles[NumPresentedFrames];
+	volatile int64 LastPresentedFrame = -1;
+	bool isPresentHookRegistered = false;
+
+	void OnEndFrameRenderThread()
+	{
+		const uint64 frame = GFrameCounterRenderThread;
+		PresentedCycles[frame % NumPresentedFrames] = FPlatformTime::Cycles64();
+		FPlatformAtomics::InterlockedExchange(&LastPresentedFrame, (int64)frame);
+	}
+
+	void RegisterPresentHook()
+	{
+		if (isPresentHookRegistered)
+		{
+			return;
+		}
+		isPresentHookRegistered = true;
+
+		//Added on the render thread, the only thread that broadcasts it, so it is never changed mid-broadcast
+		ENQUEUE_RENDER_COMMAND(RegisterFighterInputLatencyPresentHook)([](FRHICommandListImmediate& RHICmdList)
+		{
+			FCoreDelegates::OnEndFrameRT.AddStatic(&OnEndFrameRenderThread);
+		});
+	}
+
+	//Stamps platform input events as soon as Slate gets them, before any widget or player controller
+	class FInputLatencyProcessor : public IInputProcessor
+	{
+	public:
+		FInputLatencyProcessor(FFighterInputLatencyTracker* _tracker)
+			: tracker(_tracker)
+			, leftStickX(0.0f)
+		{
+		}
+
+		virtual void Tick(const float DeltaTime, FSlateApplication& SlateApp, TSharedRef<ICursor> Cursor) override
+		{
+		}
+
+		virtual bool HandleKeyDownEvent(FSlateApplication& SlateApp, const FKeyEvent& InKeyEvent) override
+		{
+			if (!InKeyEvent.IsRepeat())
+			{
+				tracker->OnInputArrived(FPlatformTime::Cycles64());
+			}
+			return false;
+		}
+
+		//The stick sends a value every frame, so only the one that leaves the dead zone is a press
+		virtual bool HandleAnalogInputEvent(FSlateApplication& SlateApp, const FAnalogInputEvent& InAnalogInputEvent) override
+		{
+			if (InAnalogInputEvent.GetKey() == EKeys::Gamepad_LeftX)
+			{
+				const float value = InAnalogInputEvent.GetAnalogValue();
+				if (FMath::Abs(value) > StickDeadZone && (FMath::Abs(leftStickX) <= StickDeadZone || FMath::Sign(value) != FMath::Sign(leftStickX)))
+				{
+					tracker->OnInputArrived(FPlatformTime::Cycles64());
+				}
+				leftStickX = value;
+			}
+			return false;
+		}
+
+	private:
+		FFighterInputLatencyTracker* tracker;
+		float leftStickX;
+	};
+}
+
+FFighterLatencyHistogram::FFighterLatencyHistogram()
+{
+	Reset();
+}
+
+void FFighterLatencyHistogram::Reset()
+{
+	FMemory::Memzero(buckets, sizeof(buckets));
+	numOverflow = 0;
+	numSamples = 0;
+	totalMilliseconds = 0.0;
+	maxMilliseconds = 0.0;
+}
+
+void FFighterLatencyHistogram::Add(double _milliseconds)
+{
+	const int32 bucket = (int32)(FMath::Max(_milliseconds, 0.0) / BucketMilliseconds);
+	if (bucket < NumBuckets)
+	{
+		++buckets[bucket];
+	}
+	else
+	{
+		++numOverflow;
+	}
+
+	++numSamples;
+	totalMilliseconds += _milliseconds;
+	maxMilliseconds = FMath::Max(maxMilliseconds, _milliseconds);
+}
+
+double FFighterLatencyHistogram::GetMean() const
+{
+	return numSamples > 0 ? totalMilliseconds / numSamples : 0.0;
+}
+
+double FFighterLatencyHistogram::GetPercentile(double _percentile) const
+{
+	if (numSamples == 0)
+	{
+		return 0.0;
+	}
+
+	//The rank of the sample wanted, counting from 1
+	const int32 rank = FMath::Clamp(FMath::CeilToInt(_percentile / 100.0 * numSamples), 1, numSamples);
+
+	int32 count = 0;
+	for (int32 bucket = 0; bucket < NumBuckets; ++bucket)
+	{
+		count += buckets[bucket];
+		if (count >= rank)
+		{
+			return (bucket + 1) * BucketMilliseconds;
+		}
+	}
+	return maxMilliseconds;
+}
+
+FFighterInputLatencyTracker::FFighterInputLatencyTracker()
+{
+	FMemory::Memzero(presses, sizeof(presses));
+	for (FFighterInputLatencyStats& playerStats : stats)
+	{
+		playerStats.numWithoutEffect = 0;
+		playerStats.numWithoutArrival = 0;
+	}
+	FMemory::Memzero(arrivals, sizeof(arrivals));
+	firstArrival = 0;
+	numArrivals = 0;
+	FMemory::Memzero(fightersBeforeStep, sizeof(fightersBeforeStep));
+
+	syntheticPressesLeft = 0;
+	syntheticKeyIndex = 0;
+	syntheticNextEventSeconds = 0.0;
+	isSyntheticKeyDown = false;
+	syntheticRandom.Initialize(0);
+
+	RegisterPresentHook();
+
+	if (FSlateApplication::IsInitialized())
+	{
+		inputProcessor = MakeShared<FInputLatencyProcessor>(this);
+		FSlateApplication::Get().RegisterInputPreProcessor(inputProcessor);
+	}
+}
+
+FFighterInputLatencyTracker::~FFighterInputLatencyTracker()
+{
+	if (inputProcessor.IsValid() && FSlateApplication::IsInitialized())
+	{
+		FSlateApplication::Get().UnregisterInputPreProcessor(inputProcessor);
+	}
+}
+
+void FFighterInputLatencyTracker::OnInputArrived(uint64 _cycles)
+{
+	//When full, the oldest event is the one least likely to still be claimed
+	if (numArrivals == MaxArrivals)
+	{
+		firstArrival = (firstArrival + 1) % MaxArrivals;
+		--numArrivals;
+	}
+
+	arrivals[(firstArrival + numArrivals) % MaxArrivals] = _cycles;
+	++numArrivals;
+}
+
+void FFighterInputLatencyTracker::OnInputHandled(int32 _playerIndex, FFighterInput _input)
+{
+	const uint64 nowCycles = FPlatformTime::Cycles64();
+
+	for (int32 bit = 0; bit < NumInputBits; ++bit)
+	{
+		FPress& press = presses[_playerIndex][bit];
+		if (!(_input & (1 << bit)) || press.stage != EPressStage::None)
+		{
+			continue;
+		}
+
+		if (numArrivals > 0)
+		{
+			press.arrivalCycles = arrivals[firstArrival];
+			firstArrival = (firstArrival + 1) % MaxArrivals;
+			--numArrivals;
+		}
+		else
+		{
+			press.arrivalCycles = nowCycles;
+			++stats[_playerIndex].numWithoutArrival;
+		}
+
+		press.handledCycles = nowCycles;
+		press.framesWaiting = 0;
+		press.stage = EPressStage::Handled;
+	}
+}
+
+void FFighterInputLatencyTracker::BeginStep(const FSimMatchState& _state)
+{
+	fightersBeforeStep[0] = _state.fighters[0];
+	fightersBeforeStep[1] = _state.fighters[1];
+}
+
+void FFighterInputLatencyTracker::EndStep(FFighterInput _player1Input, FFighterInput _player2Input, const FSimMatchState& _state)
+{
+	const FFighterInput inputs[2] = { _player1Input, _player2Input };
+	const uint64 nowCycles = FPlatformTime::Cycles64();
+
+	for (int32 playerIndex = 0; playerIndex < 2; ++playerIndex)
+	{
+		const FSimFighterState& before = fightersBeforeStep[playerIndex];
+		const FSimFighterState& after = _state.fighters[playerIndex];
+
+		//A new state or move, or the same move started over
+		const bool hasChangedState = before.characterState != after.characterState || before.move != after.move || after.moveFrame < before.moveFrame;
+
+		for (int32 bit = 0; bit < NumInputBits; ++bit)
+		{
+			FPress& press = presses[playerIndex][bit];
+			if (press.stage != EPressStage::Handled || !(inputs[playerIndex] & (1 << bit)))
+			{
+				continue;
+			}
+
+			if (hasChangedState)
+			{
+				press.simulatedCycles = nowCycles;
+				press.simulatedEngineFrame = GFrameCounter;
+				press.stage = EPressStage::Simulated;
+			}
+			else if (++press.framesWaiting > MaxFramesWithoutEffect)
+			{
+				press.stage = EPressStage::None;
+				++stats[playerIndex].numWithoutEffect;
+			}
+		}
+	}
+}
+
+void FFighterInputLatencyTracker::Tick(UWorld* _world)
+{
+	const int64 lastPresentedFrame = FPlatformAtomics::AtomicRead(&LastPresentedFrame);
+	const uint64 nowCycles = FPlatformTime::Cycles64();
+
+	for (int32 playerIndex = 0; playerIndex < 2; ++playerIndex)
+	{
+		for (FPress& press : presses[playerIndex])
+		{
+			if (press.stage == EPressStage::Simulated && lastPresentedFrame >= 0 && press.simulatedEngineFrame <= (uint64)lastPresentedFrame)
+			{
+				//Frames too old for the ring only happen after a long stall, so now is as good a present time as any
+				const bool isInRing = (uint64)lastPresentedFrame - press.simulatedEngineFrame < NumPresentedFrames - 1;
+				CompletePress(playerIndex, press, isInRing ? PresentedCycles[press.simulatedEngineFrame % NumPresentedFrames] : nowCycles);
+			}
+			else if (press.stage == EPressStage::Handled && FPlatformTime::ToMilliseconds64(nowCycles - press.handledCycles) > MaxHandledMilliseconds)
+			{
+				press.stage = EPressStage::None;
+				++stats[playerIndex].numWithoutEffect;
+			}
+		}
+	}
+
+	while (numArrivals > 0 && FPlatformTime::ToMilliseconds64(nowCycles - arrivals[firstArrival]) > MaxArrivalMilliseconds)
+	{
+		firstArrival = (firstArrival + 1) % MaxArrivals;
+		--numArrivals;
+	}
+
+	TickSyntheticInput(_world);
+
+	if (IsDisplayEnabled())
+	{
+		DrawOnScreen();
+	}
+}
+
+void FFighterInputLatencyTracker::CompletePress(int32 _playerIndex, FPress& _press, uint64 _presentCycles)
+{
+	FFighterLatencyHistogram* stages = stats[_playerIndex].stages;
+	stages[(int32)EFighterLatencyStage::InputToHandler].Add(FPlatformTime::ToMilliseconds64(_press.handledCycles - _press.arrivalCycles));
+	stages[(int32)EFighterLatencyStage::HandlerToSimulation].Add(FPlatformTime::ToMilliseconds64(_press.simulatedCycles - _press.handledCycles));
+	stages[(int32)EFighterLatencyStage::SimulationToPresent].Add(FPlatformTime::ToMilliseconds64(_presentCycles - _press.simulatedCycles));
+	stages[(int32)EFighterLatencyStage::Total].Add(FPlatformTime::ToMilliseconds64(_presentCycles - _press.arrivalCycles));
+
+	_press.stage = EPressStage::None;
+}
+
+void FFighterInputLatencyTracker::StartSyntheticInput(const TArray<FKey>& _keys, int32 _numPresses)
+{
+	syntheticKeys = _keys;
+	syntheticPressesLeft = _keys.Num() > 0 ? FMath::Max(_numPresses, 0) : 0;
+	syntheticKeyIndex = 0;
+	syntheticNextEventSeconds = 0.0;
+	isSyntheticKeyDown = false;
+}
+
+void FFighterInputLatencyTracker::TickSyntheticInput(UWorld* _world)
+{
+	if (syntheticPressesLeft == 0 && !isSyntheticKeyDown)
+	{
+		return;
+	}
+
+	const double nowSeconds = FPlatformTime::Seconds();
+	if (nowSeconds < syntheticNextEventSeconds)
+	{
+		return;
+	}
+
+	APlayerController* controller = _world ? _world->GetFirstPlayerController() : nullptr;
+	if (!controller)
+	{
+		return;
+	}
+
+	const FKey& key = syntheticKeys[syntheticKeyIndex];
+	if (isSyntheticKeyDown)
+	{
+		controller->InputKey(key, IE_Released, 0.0f, key.IsGamepadKey());
+		isSyntheticKeyDown = false;
+		syntheticKeyIndex = (syntheticKeyIndex + 1) % syntheticKeys.Num();
+
+		//Random, so the presses land at every point of a simulation frame
+		syntheticNextEventSeconds = nowSeconds + syntheticRandom.FRandRange(SyntheticMinGapSeconds, SyntheticMaxGapSeconds);
+	}
+	else
+	{
+		//Stamped where Slate would stamp a real key, just before the player controller gets it
+		OnInputArrived(FPlatformTime::Cycles64());
+		controller->InputKey(key, IE_Pressed, 1.0f, key.IsGamepadKey());
+		isSyntheticKeyDown = true;
+		--syntheticPressesLeft;
+		syntheticNextEventSeconds = nowSeconds + SyntheticHoldSeconds;
+	}
+}
+
+bool FFighterInputLatencyTracker::IsSyntheticInputFinished() const
+{
+	if (syntheticKeys.Num() == 0 || syntheticPressesLeft > 0 || isSyntheticKeyDown)
+	{
+		return false;
+	}
+
+	for (int32 playerIndex = 0; playerIndex < 2; ++playerIndex)
+	{
+		for (const FPress& press : presses[playerIndex])
+		{
+			if (press.stage != EPressStage::None)
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+bool FFighterInputLatencyTracker::IsDisplayEnabled()
+{
+	return ShowInputLatency != 0;
+}
+
+void FFighterInputLatencyTracker::DrawOnScreen() const
+{
+	if (!GEngine)
+	{
+		return;
+	}
+
+	for (int32 playerIndex = 0; playerIndex < 2; ++playerIndex)
+	{
+		const FFighterLatencyHistogram* stages = stats[playerIndex].stages;
+		const FFighterLatencyHistogram& total = stages[(int32)EFighterLatencyStage::Total];
+
+		GEngine->AddOnScreenDebugMessage(OnScreenMessageKey + playerIndex, 0.0f, FColor::Cyan,
+			FString::Printf(TEXT("P%d input latency: %.1f ms p50, %.1f ms p99 over %d presses (handler %.1f / %.1f, simulation %.1f / %.1f, present %.1f / %.1f)"),
+				playerIndex + 1, total.GetPercentile(50.0), total.GetPercentile(99.0), total.Num(),
+				stages[(int32)EFighterLatencyStage::InputToHandler].GetPercentile(50.0), stages[(int32)EFighterLatencyStage::InputToHandler].GetPercentile(99.0),
+				stages[(int32)EFighterLatencyStage::HandlerToSimulation].GetPercentile(50.0), stages[(int32)EFighterLatencyStage::HandlerToSimulation].GetPercentile(99.0),
+				stages[(int32)EFighterLatencyStage::SimulationToPresent].GetPercentile(50.0), stages[(int32)EFighterLatencyStage::SimulationToPresent].GetPercentile(99.0)));
+	}
+}
+
+void FFighterInputLatencyTracker::LogStats() const
+{
+	for (int32 playerIndex = 0; playerIndex < 2; ++playerIndex)
+	{
+		const FFighterInputLatencyStats& playerStats = stats[playerIndex];
+		UE_LOG(LogFighter, Log, TEXT("Input latency P%d: %d presses, %d without effect, %d without a platform event"),
+			playerIndex + 1, playerStats.stages[(int32)EFighterLatencyStage::Total].Num(), playerStats.numWithoutEffect, playerStats.numWithoutArrival);
+
+		for (int32 stage = 0; stage < (int32)EFighterLatencyStage::Count; ++stage)
+		{
+			const FFighterLatencyHistogram& histogram = playerStats.stages[stage];
+			UE_LOG(LogFighter, Log, TEXT("  %s: %.2f ms mean, %.2f ms p50, %.2f ms p99, %.2f ms max"),
+				StageNames[stage], histogram.GetMean(), histogram.GetPercentile(50.0), histogram.GetPercentile(99.0), histogram.GetMax());
+		}
+	}
+}
+
+bool FFighterInputLatencyTracker::WriteReport(const FString& _path) const
+{
+	FString csv = TEXT("Player,Stage,Samples,MeanMs,P50Ms,P90Ms,P99Ms,MaxMs,WithoutEffect,WithoutPlatformEvent\n");
+	for (int32 playerIndex = 0; playerIndex < 2; ++playerIndex)
+	{
+		for (int32 stage = 0; stage < (int32)EFighterLatencyStage::Count; ++stage)
+		{
+			const FFighterLatencyHistogram& histogram = stats[playerIndex].stages[stage];
+			csv += FString::Printf(TEXT("%d,%s,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%d,%d\n"),
+				playerIndex + 1, StageNames[stage], histogram.Num(), histogram.GetMean(), histogram.GetPercentile(50.0), histogram.GetPercentile(90.0),
+				histogram.GetPercentile(99.0), histogram.GetMax(), stats[playerIndex].numWithoutEffect, stats[playerIndex].numWithoutArrival);
+		}
+	}
+
+	//Every non-empty bucket by its lower edge, and the samples past the last one at MaxMilliseconds
+	csv += TEXT("\nPlayer,Stage,BucketMs,Count\n");
+	for (int32 playerIndex = 0; playerIndex < 2; ++playerIndex)
+	{
+		for (int32 stage = 0; stage < (int32)EFighterLatencyStage::Count; ++stage)
+		{
+			const FFighterLatencyHistogram& histogram = stats[playerIndex].stages[stage];
+			for (int32 bucket = 0; bucket < FFighterLatencyHistogram::NumBuckets; ++bucket)
+			{
+				if (histogram.GetBucketCount(bucket) > 0)
+				{
+					csv += FString::Printf(TEXT("%d,%s,%.1f,%d\n"), playerIndex + 1, StageNames[stage], bucket * FFighterLatencyHistogram::BucketMilliseconds, histogram.GetBucketCount(bucket));
+				}
+			}
+			if (histogram.GetOverflowCount() > 0)
+			{
+				csv += FString::Printf(TEXT("%d,%s,%.1f,%d\n"), playerIndex + 1, StageNames[stage], FFighterLatencyHistogram::MaxMilliseconds, histogram.GetOverflowCount());
+			}
+		}
+	}
+
+	return FFileHelper::SaveStringToFile(csv, *_path);
+}
+
+FString FighterInputLatency::GetReportPath(const FString& _fileName)
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Profiling"), TEXT("InputLatency"), _fileName + TEXT(".csv"));
+}
@@ -0,0 +1,175 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "InputCoreTypes.h"
+#include "FighterSimulation.h"
+
+class IInputProcessor;
+class UWorld;
+
+//The parts of a press's trip from the keyboard or pad to the screen
+enum class EFighterLatencyStage : uint8
+{
+	//The platform event reaching Slate, to the character's input handler
+	InputToHandler,
+	//The handler, to the simulation frame where the press changed the fighter's state or move
+	HandlerToSimulation,
+	//That frame, to the render thread finishing the engine frame it was drawn in
+	SimulationToPresent,
+	//From the platform event to the end of the engine frame it was drawn in
+	Total,
+
+	Count
+};
+
+/**
+ * Latencies in fixed 0.1 ms buckets up to MaxMilliseconds, so adding a sample never allocates and any percentile
+ * is one walk over the buckets. Samples above the range only count towards the maximum and the percentiles past it.
+ */
+class FIGHTERGAMEPLUGIN_API FFighterLatencyHistogram
+{
+public:
+	static constexpr int32 NumBuckets = 2000;
+	static constexpr double BucketMilliseconds = 0.1;
+	static constexpr double MaxMilliseconds = NumBuckets * BucketMilliseconds;
+
+	FFighterLatencyHistogram();
+
+	void Add(double _milliseconds);
+
+	void Reset();
+
+	int32 Num() const { return numSamples; }
+	double GetMean() const;
+	double GetMax() const { return maxMilliseconds; }
+
+	//The upper edge of the bucket holding the _percentile-th percentile sample, 0 with no samples
+	double GetPercentile(double _percentile) const;
+
+	int32 GetBucketCount(int32 _bucket) const { return buckets[_bucket]; }
+	int32 GetOverflowCount() const { return numOverflow; }
+
+private:
+	int32 buckets[NumBuckets];
+	int32 numOverflow;
+	int32 numSamples;
+	double totalMilliseconds;
+	double maxMilliseconds;
+};
+
+struct FFighterInputLatencyStats
+{
+	FFighterLatencyHistogram stages[(int32)EFighterLatencyStage::Count];
+
+	//Presses that reached a handler but never changed the fighter's state, like attacking during another attack
+	int32 numWithoutEffect;
+
+	//Presses that reached a handler without a platform event to match, like the CPU opponent's. Their InputToHandler is 0.
+	int32 numWithoutArrival;
+};
+
+/**
+ * Measures every press end to end for both players, by stamping it at each point of the pipeline:
+ * when the platform event reaches Slate, when the character's MoveRight, StartAttack* or Press handler sees a new input,
+ * when the simulation frame that used it changed the fighter's state or move, and when the render thread finished the
+ * engine frame that drew that. Presses are matched to platform events in arrival order, so keys that no handler uses
+ * only cost a stale event that ages out.
+ *
+ * For runs without a keyboard (-nullrhi, CI), StartSyntheticInput presses keys on the first player controller itself,
+ * through APlayerController::InputKey, so the synthetic presses take the same path as real ones after the platform layer.
+ */
+class FIGHTERGAMEPLUGIN_API FFighterInputLatencyTracker
+{
+public:
+	//The most presses waiting on a platform event, a handler or a present at once
+	static constexpr int32 MaxArrivals = 32;
+
+	//How many simulation frames a press may wait to change something, which covers buffered inputs
+	static constexpr int32 MaxFramesWithoutEffect = 8;
+
+	FFighterInputLatencyTracker();
+	~FFighterInputLatencyTracker();
+
+	//A platform input event arrived at _cycles (FPlatformTime::Cycles64)
+	void OnInputArrived(uint64 _cycles);
+
+	//_input has just been pressed in _playerIndex's character's input handler
+	void OnInputHandled(int32 _playerIndex, FFighterInput _input);
+
+	//Call around each simulation step, with the state before it and the state and inputs after it
+	void BeginStep(const FSimMatchState& _state);
+	void EndStep(FFighterInput _player1Input, FFighterInput _player2Input, const FSimMatchState& _state);
+
+	//Completes the presses whose frame has been presented, drives the synthetic input and draws the on-screen summary
+	void Tick(UWorld* _world);
+
+	//Presses each of _keys in turn on the first player controller, _numPresses times in all, a random time apart
+	void StartSyntheticInput(const TArray<FKey>& _keys, int32 _numPresses);
+
+	//Has the synthetic input pressed everything, and every press finished or aged out
+	bool IsSyntheticInputFinished() const;
+
+	const FFighterInputLatencyStats& GetStats(int32 _playerIndex) const { return stats[_playerIndex]; }
+
+	void LogStats() const;
+
+	//Writes each player's percentiles and every non-empty bucket as CSV
+	bool WriteReport(const FString& _path) const;
+
+	//Fighter.ShowInputLatency
+	static bool IsDisplayEnabled();
+
+private:
+	enum class EPressStage : uint8
+	{
+		None,
+		Handled,
+		Simulated
+	};
+
+	struct FPress
+	{
+		uint64 arrivalCycles;
+		uint64 handledCycles;
+		uint64 simulatedCycles;
+		//The engine frame (GFrameCounter) the simulation changed state on
+		uint64 simulatedEngineFrame;
+		int32 framesWaiting;
+		EPressStage stage;
+	};
+
+	//One press in flight per input bit and player
+	static constexpr int32 NumInputBits = 10;
+
+	void CompletePress(int32 _playerIndex, FPress& _press, uint64 _presentCycles);
+	void TickSyntheticInput(UWorld* _world);
+	void DrawOnScreen() const;
+
+	FPress presses[2][NumInputBits];
+	FFighterInputLatencyStats stats[2];
+
+	//Platform events not yet matched to a handler, oldest first
+	uint64 arrivals[MaxArrivals];
+	int32 firstArrival;
+	int32 numArrivals;
+
+	FSimFighterState fightersBeforeStep[2];
+
+	TSharedPtr<IInputProcessor> inputProcessor;
+
+	TArray<FKey> syntheticKeys;
+	int32 syntheticPressesLeft;
+	int32 syntheticKeyIndex;
+	//When the synthetic key is next pressed or released, in FPlatformTime::Seconds
+	double syntheticNextEventSeconds;
+	bool isSyntheticKeyDown;
+	FRandomStream syntheticRandom;
+};
+
+namespace FighterInputLatency
+{
+	//Profiling/InputLatency/<_fileName>.csv in the project's Saved directory
+	FIGHTERGAMEPLUGIN_API FString GetReportPath(const FString& _fileName);
+}
@@ -0,0 +1,248 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FighterInputSampler.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/PlatformProcess.h"
+#include "FighterGamePlugin.h"
+
+#if PLATFORM_WINDOWS
+#include "Windows/AllowWindowsPlatformTypes.h"
+#include <Xinput.h>
+#include "Windows/HideWindowsPlatformTypes.h"
+#endif
+
+namespace
+{
+#if PLATFORM_WINDOWS
+	//Virtual key codes for each EFighterInput bit in order: Left, Right, Up, Down, Attack1 to 4, Block and Exceptional
+	const uint8 KeyboardLayouts[2][10] =
+	{
+		{ 'A', 'D', 'W', 'S', 'Q', 'E', 'Z', 'X', '1', '3' },
+		{ VK_LEFT, VK_RIGHT, 'O', VK_DOWN, 'I', 'P', 'K', 'L', '2', '4' }
+	};
+
+	//The same dead zone the characters' MoveRight uses, in XInput's stick range
+	constexpr SHORT StickDeadZone = (SHORT)(0.20f * 32767);
+
+	//Only read the devices for this game, not while typing into another window
+	bool IsThisApplicationForeground()
+	{
+		DWORD foregroundProcessId = 0;
+		::GetWindowThreadProcessId(::GetForegroundWindow(), &foregroundProcessId);
+		return foregroundProcessId == ::GetCurrentProcessId();
+	}
+
+	FFighterInput ReadKeyboard(int32 _layout)
+	{
+		FFighterInput input = EFighterInput::None;
+		for (int32 bit = 0; bit < UE_ARRAY_COUNT(KeyboardLayouts[0]); ++bit)
+		{
+			if (::GetAsyncKeyState(KeyboardLayouts[_layout - 1][bit]) & 0x8000)
+			{
+				input |= 1 << bit;
+			}
+		}
+		return input;
+	}
+
+	//The buttons and stick directions mapped as in DefaultInput.ini. Returns false if the pad is not connected.
+	bool ReadPad(int32 _userIndex, FFighterInput& _outInput)
+	{
+		XINPUT_STATE state;
+		if (::XInputGetState((DWORD)_userIndex, &state) != ERROR_SUCCESS)
+		{
+			return false;
+		}
+
+		const XINPUT_GAMEPAD& pad = state.Gamepad;
+		FFighterInput input = EFighterInput::None;
+		input |= ((pad.wButtons & XINPUT_GAMEPAD_DPAD_LEFT) || pad.sThumbLX < -StickDeadZone) ? EFighterInput::Left : EFighterInput::None;
+		input |= ((pad.wButtons & XINPUT_GAMEPAD_DPAD_RIGHT) || pad.sThumbLX > StickDeadZone) ? EFighterInput::Right : EFighterInput::None;
+		input |= ((pad.wButtons & XINPUT_GAMEPAD_DPAD_UP) || pad.sThumbLY > StickDeadZone) ? EFighterInput::Up : EFighterInput::None;
+		input |= ((pad.wButtons & XINPUT_GAMEPAD_DPAD_DOWN) || pad.sThumbLY < -StickDeadZone) ? EFighterInput::Down : EFighterInput::None;
+		input |= (pad.wButtons & XINPUT_GAMEPAD_A) ? EFighterInput::Attack1 : EFighterInput::None;
+		input |= (pad.wButtons & XINPUT_GAMEPAD_X) ? EFighterInput::Attack2 : EFighterInput::None;
+		input |= (pad.wButtons & XINPUT_GAMEPAD_Y) ? EFighterInput::Attack3 : EFighterInput::None;
+		input |= (pad.wButtons & XINPUT_GAMEPAD_B) ? EFighterInput::Attack4 : EFighterInput::None;
+		input |= (pad.wButtons & XINPUT_GAMEPAD_LEFT_SHOULDER) ? EFighterInput::Block : EFighterInput::None;
+		input |= (pad.wButtons & XINPUT_GAMEPAD_RIGHT_SHOULDER) ? EFighterInput::Exceptional : EFighterInput::None;
+
+		_outInput |= input;
+		return true;
+	}
+#endif
+}
+
+FFighterInputSampler::FFighterInputSampler(const FFighterInputSamplerSettings& _settings)
+	: settings(_settings)
+	, numPolls(0)
+	, numChanges(0)
+	, numDropped(0)
+	, shouldStop(0)
+	, thread(nullptr)
+{
+	settings.pollHz = FMath::Clamp(settings.pollHz, (float)FighterSim::FramesPerSecond, 8000.0f);
+
+	for (int32 playerIndex = 0; playerIndex < 2; ++playerIndex)
+	{
+		sampledInputs[playerIndex] = EFighterInput::None;
+		drainedInputs[playerIndex] = EFighterInput::None;
+		pollsUntilPadCheck[playerIndex] = 0;
+	}
+
+	if (IsSupported())
+	{
+		thread = FRunnableThread::Create(this, TEXT("FighterInputSampler"), 0, TPri_Highest);
+	}
+}
+
+FFighterInputSampler::~FFighterInputSampler()
+{
+	if (thread)
+	{
+		thread->Kill(true);
+		delete thread;
+		thread = nullptr;
+	}
+}
+
+bool FFighterInputSampler::IsSupported()
+{
+	return PLATFORM_WINDOWS != 0 && FPlatformProcess::SupportsMultithreading();
+}
+
+bool FFighterInputSampler::HasDevices(int32 _playerIndex) const
+{
+	const FFighterInputSamplerDevices& devices = settings.devices[_playerIndex];
+	return thread && (devices.keyboardLayout == 1 || devices.keyboardLayout == 2 || devices.gamepadIndex != INDEX_NONE);
+}
+
+FFighterInput FFighterInputSampler::ConsumeFrame(int32 _playerIndex, uint64 _frameEndCycles)
+{
+	TFighterSpscQueue<FFighterSampledInput, QueueCapacity>& queue = queues[_playerIndex];
+	FFighterInput& drainedInput = drainedInputs[_playerIndex];
+	FFighterInput pressedInput = EFighterInput::None;
+
+	//Changes after the end of the frame stay queued for the next one
+	while (const FFighterSampledInput* sample = queue.Peek())
+	{
+		if (sample->cycles >= _frameEndCycles)
+		{
+			break;
+		}
+
+		pressedInput |= sample->input & ~drainedInput;
+		drainedInput = sample->input;
+		queue.Pop();
+	}
+
+	return drainedInput | pressedInput;
+}
+
+FFighterInputSamplerStats FFighterInputSampler::GetStats() const
+{
+	FFighterInputSamplerStats stats;
+	stats.numPolls = FPlatformAtomics::AtomicRead(&numPolls);
+	stats.numChanges = FPlatformAtomics::AtomicRead(&numChanges);
+	stats.numDropped = FPlatformAtomics::AtomicRead(&numDropped);
+	return stats;
+}
+
+uint32 FFighterInputSampler::Run()
+{
+	const double secondsPerPoll = 1.0 / settings.pollHz;
+	double nextPollSeconds = FPlatformTime::Seconds();
+
+	while (!FPlatformAtomics::AtomicRead(&shouldStop))
+	{
+		Poll();
+
+		nextPollSeconds += secondsPerPoll;
+		const double waitSeconds = nextPollSeconds - FPlatformTime::Seconds();
+		if (waitSeconds > 0.0)
+		{
+			FPlatformProcess::SleepNoStats((float)waitSeconds);
+		}
+		else
+		{
+			//Fell behind, so carry on from now instead of polling in a burst
+			nextPollSeconds = FPlatformTime::Seconds();
+		}
+	}
+	return 0;
+}
+
+void FFighterInputSampler::Stop()
+{
+	FPlatformAtomics::InterlockedExchange(&shouldStop, 1);
+}
+
+void FFighterInputSampler::Poll()
+{
+	//Stamped before reading, as the change happened at or before the read
+	const uint64 cycles = FPlatformTime::Cycles64();
+
+	FFighterInput inputs[2];
+	ReadDevices(inputs);
+	FPlatformAtomics::InterlockedIncrement(&numPolls);
+
+	for (int32 playerIndex = 0; playerIndex < 2; ++playerIndex)
+	{
+		if (inputs[playerIndex] == sampledInputs[playerIndex])
+		{
+			continue;
+		}
+
+		FFighterSampledInput sample;
+		sample.cycles = cycles;
+		sample.input = inputs[playerIndex];
+
+		//A change that does not fit is tried again on the next poll, so only its timing is lost
+		if (queues[playerIndex].Push(sample))
+		{
+			sampledInputs[playerIndex] = inputs[playerIndex];
+			FPlatformAtomics::InterlockedIncrement(&numChanges);
+		}
+		else
+		{
+			FPlatformAtomics::InterlockedIncrement(&numDropped);
+		}
+	}
+}
+
+void FFighterInputSampler::ReadDevices(FFighterInput _outInputs[2])
+{
+	_outInputs[0] = EFighterInput::None;
+	_outInputs[1] = EFighterInput::None;
+
+#if PLATFORM_WINDOWS
+	if (!IsThisApplicationForeground())
+	{
+		return;
+	}
+
+	for (int32 playerIndex = 0; playerIndex < 2; ++playerIndex)
+	{
+		const FFighterInputSamplerDevices& devices = settings.devices[playerIndex];
+
+		if (devices.keyboardLayout == 1 || devices.keyboardLayout == 2)
+		{
+			_outInputs[playerIndex] |= ReadKeyboard(devices.keyboardLayout);
+		}
+
+		if (devices.gamepadIndex != INDEX_NONE)
+		{
+			if (pollsUntilPadCheck[playerIndex] > 0)
+			{
+				--pollsUntilPadCheck[playerIndex];
+			}
+			else if (!ReadPad(devices.gamepadIndex, _outInputs[playerIndex]))
+			{
+				//Look for it again in about a second
+				pollsUntilPadCheck[playerIndex] = (int32)settings.pollHz;
+			}
+		}
+	}
+#endif
+}
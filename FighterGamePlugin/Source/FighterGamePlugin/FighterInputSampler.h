@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "FighterSimulation.h"
+#include "FighterSpscQueue.h"
+
+class FRunnableThread;
+
+//A player's held input whenever it changed, and when the sampler saw it change
+struct FFighterSampledInput
+{
+	//FPlatformTime::Cycles64
+	uint64 cycles;
+
+	FFighterInput input;
+};
+
+//Which devices the sampler reads for one player
+struct FFighterInputSamplerDevices
+{
+	//0 for none, 1 for player 1's keys (WASD side) and 2 for player 2's (arrow keys side), as in DefaultInput.ini
+	int32 keyboardLayout;
+
+	//The pad's XInput user index, or INDEX_NONE
+	int32 gamepadIndex;
+};
+
+struct FFighterInputSamplerSettings
+{
+	float pollHz;
+
+	FFighterInputSamplerDevices devices[2];
+};
+
+struct FFighterInputSamplerStats
+{
+	int32 numPolls;
+	int32 numChanges;
+
+	//Changes lost because the game thread had not drained a full queue
+	int32 numDropped;
+};
+
+/**
+ * Reads the keyboard and pads on its own thread, many times per engine frame, and queues every change of each player's
+ * held input with the time it was seen. The game thread drains each player's queue up to the end of the simulation
+ * frame it is about to step, so a press is assigned to the frame whose window it happened in, however late in the
+ * engine frame that was, and presses made together always land on the same frame.
+ *
+ * Only Windows has a device backend (GetAsyncKeyState and XInput). Elsewhere, and for any player without a device,
+ * the game mode keeps using the input from the character's SetupPlayerInputComponent bindings.
+ */
+class FIGHTERGAMEPLUGIN_API FFighterInputSampler : public FRunnable
+{
+public:
+	static constexpr int32 QueueCapacity = 256;
+
+	FFighterInputSampler(const FFighterInputSamplerSettings& _settings);
+
+	//Stops the thread and waits for it
+	virtual ~FFighterInputSampler();
+
+	//Can this platform read devices outside the engine's input
+	static bool IsSupported();
+
+	//Does the sampler read any device for _playerIndex
+	bool HasDevices(int32 _playerIndex) const;
+
+	/**
+	 * Game thread. Applies every change _playerIndex made before _frameEndCycles and returns the input for that frame:
+	 * what is held at its end plus anything pressed during it, so a tap shorter than a frame is not lost.
+	 */
+	FFighterInput ConsumeFrame(int32 _playerIndex, uint64 _frameEndCycles);
+
+	FFighterInputSamplerStats GetStats() const;
+
+	//FRunnable
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	//Reads every device once and queues the players whose input changed. Sampler thread only.
+	void Poll();
+
+	//What each player's devices hold right now, or nothing while another application has focus
+	void ReadDevices(FFighterInput _outInputs[2]);
+
+	FFighterInputSamplerSettings settings;
+
+	TFighterSpscQueue<FFighterSampledInput, QueueCapacity> queues[2];
+
+	//The last input queued for each player. Sampler thread only.
+	FFighterInput sampledInputs[2];
+
+	//The input held after the last change drained for each player. Game thread only.
+	FFighterInput drainedInputs[2];
+
+	//Pads that were not connected are only looked for again after this many polls, as asking for one is slow
+	int32 pollsUntilPadCheck[2];
+
+	volatile int32 numPolls;
+	volatile int32 numChanges;
+	volatile int32 numDropped;
+
+	volatile int32 shouldStop;
+
+	FRunnableThread* thread;
+};
@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FighterMatchManager.h"
+#include "FighterGamePluginCharacter.h"
+#include "FighterGamePlugin.h"
+
+DECLARE_CYCLE_STAT(TEXT("Match Manager Update"), STAT_FighterMatchManagerUpdate, STATGROUP_Fighter);
+
+FFighterMatchManager::FFighterMatchManager()
+{
+	players[0] = nullptr;
+	players[1] = nullptr;
+	FMemory::Memzero(&view, sizeof(view));
+}
+
+void FFighterMatchManager::Start(AFighterGamePluginCharacter* _player1, AFighterGamePluginCharacter* _player2, const FSimMatchState& _state)
+{
+	check(_player1 && _player2 && _player1 != _player2);
+
+	players[0] = _player1;
+	players[1] = _player2;
+
+	for (int32 playerIndex = 0; playerIndex < 2; ++playerIndex)
+	{
+		players[playerIndex]->InitializeSimulationView(players[1 - playerIndex]);
+	}
+
+	view.distanceApart = FFixed::Abs(_state.fighters[0].positionX - _state.fighters[1].positionX).ToFloat();
+	view.isPlayer1OnRight = _state.fighters[0].positionX > _state.fighters[1].positionX;
+	view.hasSwitchedSides = false;
+}
+
+void FFighterMatchManager::GatherInputs(FFighterInput& _outPlayer1Input, FFighterInput& _outPlayer2Input)
+{
+	_outPlayer1Input = players[0]->ConsumeSimulationInput();
+	_outPlayer2Input = players[1]->ConsumeSimulationInput();
+}
+
+void FFighterMatchManager::RecordInputs(int32 _frame, FFighterInput _player1Input, FFighterInput _player2Input)
+{
+	players[0]->RecordInput(_frame, _player1Input);
+	players[1]->RecordInput(_frame, _player2Input);
+}
+
+void FFighterMatchManager::ResetInputHistories()
+{
+	if (!IsStarted())
+	{
+		return;
+	}
+
+	players[0]->ResetInputHistory();
+	players[1]->ResetInputHistory();
+}
+
+void FFighterMatchManager::Update(const FSimMatchState& _state)
+{
+	FIGHTER_SCOPE_CYCLE_COUNTER(MatchManagerUpdate);
+
+	if (!IsStarted())
+	{
+		return;
+	}
+
+	const FSimFighterState& player1 = _state.fighters[0];
+	const FSimFighterState& player2 = _state.fighters[1];
+
+	//Players standing on the same spot have not switched sides yet
+	const bool isPlayer1OnRight = player1.positionX == player2.positionX ? view.isPlayer1OnRight : player1.positionX > player2.positionX;
+
+	view.distanceApart = FFixed::Abs(player1.positionX - player2.positionX).ToFloat();
+	view.hasSwitchedSides = isPlayer1OnRight != view.isPlayer1OnRight;
+	view.isPlayer1OnRight = isPlayer1OnRight;
+
+	players[0]->SyncFromSimulation(player1, _state.frame, view);
+	players[1]->SyncFromSimulation(player2, _state.frame, view);
+}
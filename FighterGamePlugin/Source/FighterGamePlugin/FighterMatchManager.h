@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FighterSimulation.h"
+
+class AFighterGamePluginCharacter;
+
+//What both fighters need to know about each other on one frame, worked out once by the match manager
+struct FFighterMatchView
+{
+	//Distance between the players along the stage, in world units
+	float distanceApart;
+
+	//Is player 1 on the right of player 2
+	bool isPlayer1OnRight;
+
+	//Did the players swap sides on this update
+	bool hasSwitchedSides;
+};
+
+/**
+ * Drives both player characters from the match state, owned by the game mode.
+ * Everything that used to happen per character is done here once per update, in a fixed order: player 1, then player 2.
+ * The characters do not tick, and look up the components they update once when the match starts.
+ */
+class FIGHTERGAMEPLUGIN_API FFighterMatchManager
+{
+public:
+	FFighterMatchManager();
+
+	//Takes over _player1 and _player2 for a match starting from _state. The game mode's references keep them alive.
+	void Start(AFighterGamePluginCharacter* _player1, AFighterGamePluginCharacter* _player2, const FSimMatchState& _state);
+
+	bool IsStarted() const { return players[0] != nullptr; }
+
+	//Takes each player's input for the next simulation frame
+	void GatherInputs(FFighterInput& _outPlayer1Input, FFighterInput& _outPlayer2Input);
+
+	//Stores the inputs that were simulated on _frame in each player's input buffer
+	void RecordInputs(int32 _frame, FFighterInput _player1Input, FFighterInput _player2Input);
+
+	//Empties each player's input buffer and command progress, after the match state is moved to another frame
+	void ResetInputHistories();
+
+	//Works out the match view from _state and copies everything onto the characters
+	void Update(const FSimMatchState& _state);
+
+	const FFighterMatchView& GetView() const { return view; }
+
+private:
+	AFighterGamePluginCharacter* players[2];
+
+	FFighterMatchView view;
+};
@@ -0,0 +1,247 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FighterMatchRunner.h"
+#include "FighterMoves.h"
+
+namespace
+{
+	//Enough for the search bot to finish two actions deep most of the time, at a cost the soak tests can afford
+	constexpr int32 SearchBotDepth = 2;
+	constexpr int32 SearchBotNodesPerAction = 256;
+
+	//One step of the scripted bot: hold _input for _frames, with directions relative to the opponent
+	struct FScriptStep
+	{
+		FFighterInput input;
+		int32 frames;
+		bool isTowardOpponent;
+		bool isAwayFromOpponent;
+	};
+
+	const FScriptStep Script[] =
+	{
+		{ EFighterInput::None,			90,	true,	false },	//Walk in, cut short once close
+		{ EFighterInput::Attack1,		1,	false,	false },
+		{ EFighterInput::None,			6,	false,	false },
+		{ EFighterInput::Attack2,		1,	false,	false },
+		{ EFighterInput::None,			10,	false,	false },
+		{ EFighterInput::Attack3,		1,	false,	false },
+		{ EFighterInput::Exceptional,	1,	false,	false },
+		{ EFighterInput::None,			8,	false,	false },
+		{ EFighterInput::Block,			20,	false,	false },
+		{ EFighterInput::Up,			1,	true,	false },
+		{ EFighterInput::None,			40,	true,	false },
+		{ EFighterInput::Attack4,		1,	false,	false },
+		{ EFighterInput::None,			30,	false,	true },
+	};
+
+	constexpr FFixed ScriptAttackRange = FFixed::FromInt(100);
+
+	FFighterInput TowardOpponent(const FSimMatchState& _state, int32 _playerIndex)
+	{
+		return _state.fighters[1 - _playerIndex].positionX > _state.fighters[_playerIndex].positionX ? EFighterInput::Right : EFighterInput::Left;
+	}
+
+	struct FScopedFunctionTimer
+	{
+		FScopedFunctionTimer(FFighterMatchResult& _result, EMatchRunnerFunction _function)
+			: result(_result)
+			, function((int32)_function)
+			, startCycles(FPlatformTime::Cycles64())
+		{
+		}
+
+		~FScopedFunctionTimer()
+		{
+			result.cycles[function] += FPlatformTime::Cycles64() - startCycles;
+			++result.calls[function];
+		}
+
+		FFighterMatchResult& result;
+		int32 function;
+		uint64 startCycles;
+	};
+}
+
+void FFighterBot::Initialize(EFighterBotType _type, int32 _seed)
+{
+	type = _type;
+	random.Initialize(_seed);
+	input = EFighterInput::None;
+	framesUntilChange = 0;
+	scriptStep = -1;
+	searchSettings = FFighterAISettings();
+	searchSettings.maxDepth = SearchBotDepth;
+	searchSettings.maxNodesPerAction = SearchBotNodesPerAction;
+	searchAction = EFighterAIAction::Wait;
+	searchToward = EFighterInput::None;
+}
+
+FFighterInput FFighterBot::NextInput(const FSimMatchState& _state, int32 _playerIndex)
+{
+	if (type == EFighterBotType::Random)
+	{
+		if (--framesUntilChange <= 0)
+		{
+			//Mostly movement, with the odd button
+			input = (FFighterInput)(random.RandRange(0, EFighterInput::All) & (random.RandRange(0, 1) ? EFighterInput::Directions : EFighterInput::All));
+			framesUntilChange = random.RandRange(1, 20);
+		}
+		return input;
+	}
+
+	//Decides on a new action when the last one is over, like the CPU opponent in game but without waiting for threads
+	if (type == EFighterBotType::Search)
+	{
+		if (--framesUntilChange < 0)
+		{
+			searchAction = FighterAI::Search(_state, _playerIndex, searchSettings, FFighterAISearchLimits());
+			searchToward = FighterAI::GetTowardOpponent(_state, _playerIndex);
+			framesUntilChange = searchSettings.actionFrames - 1;
+		}
+		return FighterAI::GetActionInput(searchAction, searchSettings.actionFrames - 1 - framesUntilChange, searchToward);
+	}
+
+	const FFixed distance = FFixed::Abs(_state.fighters[0].positionX - _state.fighters[1].positionX);
+	if (--framesUntilChange <= 0 || (scriptStep == 0 && distance < ScriptAttackRange))
+	{
+		scriptStep = (scriptStep + 1) % (int32)UE_ARRAY_COUNT(Script);
+		framesUntilChange = Script[scriptStep].frames;
+	}
+
+	const FScriptStep& step = Script[scriptStep];
+	FFighterInput stepInput = step.input;
+	if (step.isTowardOpponent)
+	{
+		stepInput |= TowardOpponent(_state, _playerIndex);
+	}
+	else if (step.isAwayFromOpponent)
+	{
+		stepInput |= TowardOpponent(_state, _playerIndex) ^ (EFighterInput::Left | EFighterInput::Right);
+	}
+	return stepInput;
+}
+
+const TCHAR* EFighterInvariant::GetName(int32 _bitIndex)
+{
+	static const TCHAR* names[Count] = { TEXT("HealthOutOfRange"), TEXT("MeterOutOfRange"), TEXT("BelowGround"), TEXT("TooFarApart"), TEXT("StuckWithoutTimer"), TEXT("TimerInPast"),
+		TEXT("OutsideStage"), TEXT("PushboxesOverlap") };
+	return _bitIndex >= 0 && _bitIndex < Count ? names[_bitIndex] : TEXT("Unknown");
+}
+
+const TCHAR* FighterMatchRunner::GetFunctionName(EMatchRunnerFunction _function)
+{
+	static const TCHAR* names[(int32)EMatchRunnerFunction::Count] = { TEXT("Bots"), TEXT("FighterSim::Step"), TEXT("Invariants") };
+	return names[(int32)_function];
+}
+
+uint32 FighterMatchRunner::FindInvariantViolations(const FSimMatchState& _state)
+{
+	uint32 violations = 0;
+
+	for (const FSimFighterState& fighter : _state.fighters)
+	{
+		if (fighter.health < FFixed::Zero() || fighter.health > FFixed::One())
+		{
+			violations |= EFighterInvariant::HealthOutOfRange;
+		}
+		if (fighter.superMeter < FFixed::Zero() || fighter.superMeter > FFixed::One())
+		{
+			violations |= EFighterInvariant::MeterOutOfRange;
+		}
+		if (fighter.positionZ < FFixed::Zero())
+		{
+			violations |= EFighterInvariant::BelowGround;
+		}
+		if (fighter.positionX < _state.stageLeftX || fighter.positionX > _state.stageRightX)
+		{
+			violations |= EFighterInvariant::OutsideStage;
+		}
+
+		const bool hasRecoveryTimer = fighter.timers.IsRunning(EFighterTimer::Hitstun) || fighter.timers.IsRunning(EFighterTimer::Blockstun)
+			|| fighter.timers.IsRunning(EFighterTimer::Launch) || fighter.timers.IsRunning(EFighterTimer::HitStop);
+		if (!fighter.canMove && fighter.isGrounded && !hasRecoveryTimer)
+		{
+			violations |= EFighterInvariant::StuckWithoutTimer;
+		}
+
+		for (int32 timer = 0; timer < (int32)EFighterTimer::Count; ++timer)
+		{
+			if (fighter.timers.IsRunning((EFighterTimer)timer) && fighter.timers.expiryFrames[timer] <= _state.frame)
+			{
+				violations |= EFighterInvariant::TimerInPast;
+			}
+		}
+	}
+
+	if (FFixed::Abs(_state.fighters[0].positionX - _state.fighters[1].positionX) > FighterSim::MaxDistanceApart)
+	{
+		violations |= EFighterInvariant::TooFarApart;
+	}
+
+	const FFighterMovementParams& player1Movement = FighterMoves::GetMoveSet(_state.fighters[0].moveSetId).movement;
+	const FFighterMovementParams& player2Movement = FighterMoves::GetMoveSet(_state.fighters[1].moveSetId).movement;
+	if (FFixed::Abs(_state.fighters[0].positionX - _state.fighters[1].positionX) < player1Movement.pushboxHalfWidth + player2Movement.pushboxHalfWidth
+		&& FFixed::Abs(_state.fighters[0].positionZ - _state.fighters[1].positionZ) < player1Movement.pushboxHalfHeight + player2Movement.pushboxHalfHeight)
+	{
+		violations |= EFighterInvariant::PushboxesOverlap;
+	}
+
+	return violations;
+}
+
+void FighterMatchRunner::RunMatch(const FFighterMatchSettings& _settings, FFighterMatchResult& _outResult)
+{
+	FMemory::Memzero(&_outResult, sizeof(_outResult));
+	_outResult.winner = INDEX_NONE;
+	_outResult.firstViolationFrame = INDEX_NONE;
+
+	FSimMatchState state;
+	FighterSim::ResetMatch(state, FFixed::FromInt(-200), FFixed::FromInt(200));
+
+	FFighterBot bots[2];
+	bots[0].Initialize(_settings.bots[0], _settings.seed * 2);
+	bots[1].Initialize(_settings.bots[1], _settings.seed * 2 + 1);
+
+	while (state.frame < _settings.maxFrames)
+	{
+		FFighterInput inputs[2];
+		{
+			FScopedFunctionTimer timer(_outResult, EMatchRunnerFunction::Bots);
+			inputs[0] = bots[0].NextInput(state, 0);
+			inputs[1] = bots[1].NextInput(state, 1);
+		}
+
+		{
+			FScopedFunctionTimer timer(_outResult, EMatchRunnerFunction::Step);
+			_outResult.numHits += FighterSim::Step(state, inputs[0], inputs[1]);
+		}
+
+		uint32 violations = 0;
+		{
+			FScopedFunctionTimer timer(_outResult, EMatchRunnerFunction::Invariants);
+			violations = FindInvariantViolations(state);
+		}
+
+		if (violations != 0)
+		{
+			if (_outResult.violations == 0)
+			{
+				_outResult.firstViolationFrame = state.frame;
+				_outResult.firstViolation = violations;
+			}
+			_outResult.violations |= violations;
+			++_outResult.numViolationFrames;
+		}
+
+		if (state.fighters[0].health <= FFixed::Zero() || state.fighters[1].health <= FFixed::Zero())
+		{
+			_outResult.winner = state.fighters[0].health > state.fighters[1].health ? 0 : (state.fighters[1].health > state.fighters[0].health ? 1 : INDEX_NONE);
+			break;
+		}
+	}
+
+	_outResult.frames = state.frame;
+	_outResult.finalChecksum = FighterSim::ComputeChecksum(state);
+}
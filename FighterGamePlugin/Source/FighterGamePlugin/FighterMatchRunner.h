@@ -0,0 +1,122 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/RandomStream.h"
+#include "FighterSimulation.h"
+#include "FighterAI.h"
+
+/**
+ * Plays whole matches on the simulation alone, with bots for both players, for soak tests and benchmarks.
+ * Nothing in here touches the world, so any number of matches can run at once on different threads.
+ */
+
+enum class EFighterBotType : uint8
+{
+	//Holds random inputs for random lengths of time
+	Random,
+
+	//Walks in, attacks, blocks and jumps in a fixed loop
+	Scripted,
+
+	//The CPU opponent's search, limited by node count instead of time so matches stay repeatable
+	Search
+};
+
+struct FIGHTERGAMEPLUGIN_API FFighterBot
+{
+	EFighterBotType type;
+	FRandomStream random;
+	FFighterInput input;
+	int32 framesUntilChange;
+	int32 scriptStep;
+
+	//The search bot's settings, and the action it is doing with its direction when it started
+	FFighterAISettings searchSettings;
+	EFighterAIAction searchAction;
+	FFighterInput searchToward;
+
+	void Initialize(EFighterBotType _type, int32 _seed);
+
+	//The input for fighter _playerIndex on the next frame of _state
+	FFighterInput NextInput(const FSimMatchState& _state, int32 _playerIndex);
+};
+
+//Things that must never be true of a match state, as bits
+namespace EFighterInvariant
+{
+	enum Type : uint32
+	{
+		HealthOutOfRange	= 1 << 0,
+		MeterOutOfRange		= 1 << 1,
+		BelowGround			= 1 << 2,
+		TooFarApart			= 1 << 3,
+
+		//Cannot move, is on the ground and has nothing running that would ever let them move again
+		StuckWithoutTimer	= 1 << 4,
+
+		//A timer that should already have expired
+		TimerInPast			= 1 << 5,
+
+		OutsideStage		= 1 << 6,
+
+		//Both fighters level and their pushboxes still overlapping after the frame
+		PushboxesOverlap	= 1 << 7
+	};
+
+	constexpr int32 Count = 8;
+
+	FIGHTERGAMEPLUGIN_API const TCHAR* GetName(int32 _bitIndex);
+}
+
+//The parts of a match step the runner times
+enum class EMatchRunnerFunction : uint8
+{
+	Bots,
+	Step,
+	Invariants,
+
+	Count
+};
+
+struct FFighterMatchSettings
+{
+	//90 seconds, one round
+	int32 maxFrames = 5400;
+
+	EFighterBotType bots[2] = { EFighterBotType::Random, EFighterBotType::Random };
+
+	int32 seed = 0;
+};
+
+struct FFighterMatchResult
+{
+	int32 frames;
+
+	//0 or 1, or INDEX_NONE for a time out
+	int32 winner;
+
+	//Every invariant broken during the match, and the first one to break
+	uint32 violations;
+	int32 numViolationFrames;
+	int32 firstViolationFrame;
+	uint32 firstViolation;
+
+	int32 numHits;
+	uint32 finalChecksum;
+
+	uint64 cycles[(int32)EMatchRunnerFunction::Count];
+	int64 calls[(int32)EMatchRunnerFunction::Count];
+};
+
+namespace FighterMatchRunner
+{
+	FIGHTERGAMEPLUGIN_API const TCHAR* GetFunctionName(EMatchRunnerFunction _function);
+
+	//Returns the EFighterInvariant bits _state breaks
+	FIGHTERGAMEPLUGIN_API uint32 FindInvariantViolations(const FSimMatchState& _state);
+
+	//Plays one match until a knock out or the frame limit. The same settings always give the same result.
+	FIGHTERGAMEPLUGIN_API void RunMatch(const FFighterMatchSettings& _settings, FFighterMatchResult& _outResult);
+}
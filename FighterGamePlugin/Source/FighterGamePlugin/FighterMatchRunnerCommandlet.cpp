@@ -0,0 +1,179 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FighterMatchRunnerCommandlet.h"
+#include "Async/ParallelFor.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "FighterMatchRunner.h"
+#include "FighterStateMachine.h"
+#include "FighterGamePlugin.h"
+
+UFighterMatchRunnerCommandlet::UFighterMatchRunnerCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UFighterMatchRunnerCommandlet::Main(const FString& Params)
+{
+	int32 numMatches = 2000;
+	int32 maxFrames = 5400;
+	int32 seed = 0;
+	FString bots = TEXT("Mixed");
+	FString csvPath;
+
+	FParse::Value(*Params, TEXT("Matches="), numMatches);
+	FParse::Value(*Params, TEXT("Frames="), maxFrames);
+	FParse::Value(*Params, TEXT("Seed="), seed);
+	FParse::Value(*Params, TEXT("Bots="), bots);
+	FParse::Value(*Params, TEXT("Csv="), csvPath);
+
+	numMatches = FMath::Max(numMatches, 1);
+
+	TArray<FFighterMatchSettings> settings;
+	settings.SetNum(numMatches);
+	for (int32 match = 0; match < numMatches; ++match)
+	{
+		FFighterMatchSettings& matchSettings = settings[match];
+		matchSettings.maxFrames = maxFrames;
+		matchSettings.seed = seed + match;
+
+		//Mixed cycles through every pairing
+		for (int32 playerIndex = 0; playerIndex < 2; ++playerIndex)
+		{
+			if (bots.Equals(TEXT("Scripted"), ESearchCase::IgnoreCase))
+			{
+				matchSettings.bots[playerIndex] = EFighterBotType::Scripted;
+			}
+			else if (bots.Equals(TEXT("Search"), ESearchCase::IgnoreCase))
+			{
+				//The CPU opponent's search as player 1, against the other bots in turn
+				matchSettings.bots[playerIndex] = playerIndex == 0 ? EFighterBotType::Search : ((match & 1) ? EFighterBotType::Scripted : EFighterBotType::Random);
+			}
+			else if (bots.Equals(TEXT("Mixed"), ESearchCase::IgnoreCase))
+			{
+				matchSettings.bots[playerIndex] = ((match >> playerIndex) & 1) ? EFighterBotType::Scripted : EFighterBotType::Random;
+			}
+			else
+			{
+				matchSettings.bots[playerIndex] = EFighterBotType::Random;
+			}
+		}
+	}
+
+	//Each match writes only its own result, so the workers share nothing
+	TArray<FFighterMatchResult> results;
+	results.SetNumZeroed(numMatches);
+
+	FighterStateMachine::ResetIllegalTransitionCounts();
+
+	const double startSeconds = FPlatformTime::Seconds();
+	ParallelFor(numMatches, [&settings, &results](int32 _match)
+	{
+		FighterMatchRunner::RunMatch(settings[_match], results[_match]);
+	});
+	const double wallSeconds = FMath::Max(FPlatformTime::Seconds() - startSeconds, 1.0e-9);
+
+	int64 totalFrames = 0;
+	int64 totalHits = 0;
+	int32 numKnockOuts = 0;
+	int32 numWins[2] = {};
+	int32 numBrokenMatches = 0;
+	int32 violationCounts[EFighterInvariant::Count] = {};
+	uint64 cycles[(int32)EMatchRunnerFunction::Count] = {};
+	int64 calls[(int32)EMatchRunnerFunction::Count] = {};
+
+	for (int32 match = 0; match < numMatches; ++match)
+	{
+		const FFighterMatchResult& result = results[match];
+		totalFrames += result.frames;
+		totalHits += result.numHits;
+		numKnockOuts += result.winner != INDEX_NONE ? 1 : 0;
+		if (result.winner != INDEX_NONE)
+		{
+			++numWins[result.winner];
+		}
+
+		for (int32 function = 0; function < (int32)EMatchRunnerFunction::Count; ++function)
+		{
+			cycles[function] += result.cycles[function];
+			calls[function] += result.calls[function];
+		}
+
+		if (result.violations != 0)
+		{
+			for (int32 bit = 0; bit < EFighterInvariant::Count; ++bit)
+			{
+				violationCounts[bit] += (result.violations >> bit) & 1;
+			}
+
+			//The seed is enough to replay the match exactly
+			if (numBrokenMatches++ < 10)
+			{
+				UE_LOG(LogFighter, Warning, TEXT("Match seed %d broke invariants 0x%x, first 0x%x on frame %d"),
+					settings[match].seed, result.violations, result.firstViolation, result.firstViolationFrame);
+			}
+		}
+	}
+
+	uint64 totalCycles = 0;
+	for (uint64 functionCycles : cycles)
+	{
+		totalCycles += functionCycles;
+	}
+
+	UE_LOG(LogFighter, Display, TEXT("Match runner: %d matches, %lld frames in %.2f s on %d threads"), numMatches, totalFrames, wallSeconds, FPlatformMisc::NumberOfWorkerThreadsToSpawn() + 1);
+	UE_LOG(LogFighter, Display, TEXT("  %.1f matches/s, %.0f frames/s, %d knock outs, %lld hits"), numMatches / wallSeconds, totalFrames / wallSeconds, numKnockOuts, totalHits);
+	UE_LOG(LogFighter, Display, TEXT("  %d wins for player 1, %d for player 2"), numWins[0], numWins[1]);
+
+	for (int32 function = 0; function < (int32)EMatchRunnerFunction::Count; ++function)
+	{
+		const double seconds = cycles[function] * FPlatformTime::GetSecondsPerCycle64();
+		UE_LOG(LogFighter, Display, TEXT("  %-28s %8.1f ns/call %5.1f%%"), FighterMatchRunner::GetFunctionName((EMatchRunnerFunction)function),
+			seconds * 1.0e9 / FMath::Max<int64>(calls[function], 1), totalCycles > 0 ? 100.0 * cycles[function] / totalCycles : 0.0);
+	}
+
+	UE_LOG(LogFighter, Display, TEXT("  %d matches broke invariants"), numBrokenMatches);
+	for (int32 bit = 0; bit < EFighterInvariant::Count; ++bit)
+	{
+		if (violationCounts[bit] > 0)
+		{
+			UE_LOG(LogFighter, Display, TEXT("    %s: %d matches"), EFighterInvariant::GetName(bit), violationCounts[bit]);
+		}
+	}
+
+	UE_LOG(LogFighter, Display, TEXT("  %d illegal state transitions"), FighterStateMachine::GetTotalIllegalTransitionCount());
+	FighterStateMachine::LogIllegalTransitions();
+
+	//One row per run, appended, so nightly runs build up a history
+	if (!csvPath.IsEmpty())
+	{
+		const bool isNewFile = !FPaths::FileExists(csvPath);
+		FString csv;
+		if (isNewFile)
+		{
+			csv += TEXT("Matches,Frames,Seconds,MatchesPerSecond,FramesPerSecond,BrokenMatches");
+			for (int32 function = 0; function < (int32)EMatchRunnerFunction::Count; ++function)
+			{
+				csv += FString::Printf(TEXT(",%sNs"), FighterMatchRunner::GetFunctionName((EMatchRunnerFunction)function));
+			}
+			csv += LINE_TERMINATOR;
+		}
+
+		csv += FString::Printf(TEXT("%d,%lld,%.3f,%.2f,%.0f,%d"), numMatches, totalFrames, wallSeconds, numMatches / wallSeconds, totalFrames / wallSeconds, numBrokenMatches);
+		for (int32 function = 0; function < (int32)EMatchRunnerFunction::Count; ++function)
+		{
+			csv += FString::Printf(TEXT(",%.1f"), cycles[function] * FPlatformTime::GetSecondsPerCycle64() * 1.0e9 / FMath::Max<int64>(calls[function], 1));
+		}
+		csv += LINE_TERMINATOR;
+
+		FFileHelper::SaveStringToFile(csv, *csvPath, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+	}
+
+	return numBrokenMatches > 0 ? 1 : 0;
+}
@@ -0,0 +1,25 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "FighterMatchRunnerCommandlet.generated.h"
+
+/**
+ * Plays thousands of bot matches on the simulation, in parallel across every core, with no map, rendering or UI.
+ * Reports throughput, the cost of each part of a step and any broken state invariants, and fails if any were broken.
+ *
+ * UE4Editor-Cmd <Project>.uproject -run=FighterMatchRunner -nullrhi [-Matches=2000] [-Frames=5400] [-Seed=0]
+ *     [-Bots=Random|Scripted|Mixed|Search] [-Csv=<path>]
+ */
+UCLASS()
+class UFighterMatchRunnerCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UFighterMatchRunnerCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
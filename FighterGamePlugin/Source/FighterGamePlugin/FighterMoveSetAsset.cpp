@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FighterMoveSetAsset.h"
+#include "FighterGamePlugin.h"
+
+static_assert((uint8)EFighterMove::HeavyEx == (uint8)EFighterMoveId::MV_HeavyEx, "EFighterMove must mirror EFighterMoveId");
+static_assert((uint8)EFighterMove::Super == (uint8)EFighterMoveId::MV_Super, "EFighterMove must mirror EFighterMoveId");
+static_assert((uint8)ESimHitboxType::Proximity == (uint8)EHitboxEnum::HB_PROXIMITY, "ESimHitboxType must mirror EHitboxEnum");
+static_assert((uint8)ESimHitboxType::Strike == (uint8)EHitboxEnum::HB_STRIKE, "ESimHitboxType must mirror EHitboxEnum");
+static_assert((uint8)ESimHitboxType::Hurtbox == (uint8)EHitboxEnum::HB_HURTBOX, "ESimHitboxType must mirror EHitboxEnum");
+
+bool UFighterMoveSetAsset::BuildMoveTable(FFighterMoveTable& _outTable) const
+{
+	FFighterMoveTable defaults;
+	FighterMoves::BuildDefaultMoveSet(defaults);
+
+	const FFighterMoveDefinition* definitions[(int32)EFighterMove::Count] = {};
+	bool isValid = true;
+
+	for (const FFighterMoveDefinition& definition : moves)
+	{
+		if (definition.move == EFighterMoveId::MV_None)
+		{
+			UE_LOG(LogFighter, Warning, TEXT("%s: a move has no move id and was left out"), *GetName());
+			isValid = false;
+			continue;
+		}
+		definitions[(int32)definition.move] = &definition;
+	}
+
+	//Rebuilt move by move so replaced default moves do not leave their boxes behind
+	_outTable.Reset();
+	_outTable.movement = defaults.movement;
+
+	for (int32 moveIndex = 1; moveIndex < (int32)EFighterMove::Count; ++moveIndex)
+	{
+		const EFighterMove move = (EFighterMove)moveIndex;
+		const FFighterMoveDefinition* definition = definitions[moveIndex];
+
+		if (!definition)
+		{
+			const FFighterMoveData& data = defaults.GetMove(move);
+			verify(_outTable.SetMove(move, data, defaults.boxes + data.firstBox, data.numBoxes));
+			continue;
+		}
+
+		FFighterMoveData data;
+		FMemory::Memzero(&data, sizeof(data));
+		data.startupFrames = FMath::Max(definition->startupFrames, 0);
+		data.activeFrames = FMath::Max(definition->activeFrames, 0);
+		data.recoveryFrames = FMath::Max(definition->recoveryFrames, 0);
+		data.damage = FFixed::FromFloat(definition->damage);
+		data.hitstunFrames = FMath::Max(definition->hitstunFrames, 0);
+		data.blockstunFrames = FMath::Max(definition->blockstunFrames, 0);
+		data.pushback = FFixed::FromFloat(FMath::Max(definition->pushback, 0.0f));
+		data.meterGain = FFixed::FromFloat(definition->meterGain);
+		data.meterCost = FFixed::FromFloat(FMath::Clamp(definition->meterCost, 0.0f, 1.0f));
+		data.exceptionalMove = (EFighterMove)definition->exceptionalMove;
+
+		const int32 lastMoveFrame = FMath::Min(data.startupFrames + data.activeFrames + data.recoveryFrames - 1, (int32)MAX_uint8);
+
+		TArray<FFighterMoveBox, TInlineAllocator<FFighterMoveTable::MaxBoxes>> boxes;
+		for (const FFighterMoveBoxDefinition& boxDefinition : definition->boxes)
+		{
+			if (boxDefinition.lastFrame < 0 || boxDefinition.firstFrame > boxDefinition.lastFrame || boxDefinition.firstFrame > lastMoveFrame)
+			{
+				UE_LOG(LogFighter, Warning, TEXT("%s: a box of move %d is out on no frame of the move and was left out"), *GetName(), moveIndex);
+				isValid = false;
+				continue;
+			}
+
+			FFighterMoveBox& box = boxes.AddDefaulted_GetRef();
+			box.type = (ESimHitboxType)boxDefinition.hitboxType;
+			box.firstFrame = (uint8)FMath::Max(boxDefinition.firstFrame, 0);
+			box.lastFrame = (uint8)FMath::Min(boxDefinition.lastFrame, lastMoveFrame);
+			box.offsetX = FFixed::FromFloat(boxDefinition.offset.X);
+			box.offsetZ = FFixed::FromFloat(boxDefinition.offset.Y);
+			box.halfWidth = FFixed::FromFloat(FMath::Abs(boxDefinition.halfSize.X));
+			box.halfHeight = FFixed::FromFloat(FMath::Abs(boxDefinition.halfSize.Y));
+		}
+
+		if (!_outTable.SetMove(move, data, boxes.GetData(), boxes.Num()))
+		{
+			UE_LOG(LogFighter, Warning, TEXT("%s: more than %d boxes in total, move %d was left without any"), *GetName(), FFighterMoveTable::MaxBoxes, moveIndex);
+			verify(_outTable.SetMove(move, data, nullptr, 0));
+			isValid = false;
+		}
+	}
+
+	return isValid;
+}
@@ -0,0 +1,113 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "HitboxActor.h"
+#include "FighterMoves.h"
+#include "FighterMoveSetAsset.generated.h"
+
+UENUM(BlueprintType)
+enum class EFighterMoveId : uint8
+{
+	MV_None			UMETA(DisplayName = "None"),
+	MV_Light		UMETA(DisplayName = "Light"),
+	MV_Medium		UMETA(DisplayName = "Medium"),
+	MV_Heavy		UMETA(DisplayName = "Heavy"),
+	MV_Super		UMETA(DisplayName = "Super"),
+	MV_LightEx		UMETA(DisplayName = "Light Exceptional"),
+	MV_MediumEx		UMETA(DisplayName = "Medium Exceptional"),
+	MV_HeavyEx		UMETA(DisplayName = "Heavy Exceptional")
+};
+
+//One box a move puts out, as edited by designers
+USTRUCT(BlueprintType)
+struct FFighterMoveBoxDefinition
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hitbox")
+		EHitboxEnum hitboxType = EHitboxEnum::HB_STRIKE;
+
+	//The first and last frames of the move the box is out on, where 0 is the frame the move starts
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hitbox")
+		int32 firstFrame = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hitbox")
+		int32 lastFrame = 0;
+
+	//Centre of the box from the character, forward along the stage (X) and up (Y)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hitbox")
+		FVector2D offset = FVector2D::ZeroVector;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hitbox")
+		FVector2D halfSize = FVector2D(30.0f, 30.0f);
+};
+
+//The frame data of one move, as edited by designers
+USTRUCT(BlueprintType)
+struct FFighterMoveDefinition
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Attacks")
+		EFighterMoveId move = EFighterMoveId::MV_Light;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Attacks")
+		int32 startupFrames = 4;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Attacks")
+		int32 activeFrames = 4;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Attacks")
+		int32 recoveryFrames = 12;
+
+	//1 is the opponent's full health
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Attacks")
+		float damage = 0.05f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Attacks")
+		int32 hitstunFrames = 12;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Attacks")
+		int32 blockstunFrames = 6;
+
+	//How far a hit or block pushes the defender away, or the attacker if the defender is in the corner
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Attacks")
+		float pushback = 30.0f;
+
+	//Meter the attacker gains on hit, as a fraction of the damage dealt
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Attacks")
+		float meterGain = 0.3f;
+
+	//Meter needed and spent to start the move, where 1 is a full meter
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Attacks")
+		float meterCost = 0.0f;
+
+	//The move this one turns into when the exceptional button is pressed during it
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Attacks")
+		EFighterMoveId exceptionalMove = EFighterMoveId::MV_None;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Attacks")
+		TArray<FFighterMoveBoxDefinition> boxes;
+};
+
+/**
+ * A character's frame data. Converted into an FFighterMoveTable for the simulation when the match starts.
+ * Moves left out of the asset keep their default frame data.
+ */
+UCLASS(BlueprintType)
+class FIGHTERGAMEPLUGIN_API UFighterMoveSetAsset : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Attacks")
+		TArray<FFighterMoveDefinition> moves;
+
+	//Fills _outTable with the asset's moves on top of the defaults. Returns false, with a warning for each problem, if anything had to be left out.
+	bool BuildMoveTable(FFighterMoveTable& _outTable) const;
+};
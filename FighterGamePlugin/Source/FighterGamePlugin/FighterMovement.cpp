@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FighterMovement.h"
+
+FFighterMovementParams FighterMovement::MakeParams(FFixed _walkSpeed, FFixed _jumpHeight, int32 _jumpRiseFrames, int32 _airControlFrames,
+	FFixed _pushboxHalfWidth, FFixed _pushboxHalfHeight)
+{
+	const int32 riseFrames = FMath::Max(_jumpRiseFrames, 1);
+
+	FFighterMovementParams params;
+	params.walkSpeed = _walkSpeed;
+
+	//Height is added after velocity loses gravity each frame, so after n frames it is n * v - g * n * (n + 1) / 2.
+	//That peaks at g * T * T / 2 on frame T when v is g * (T + 1/2), and is back to 0 on frame 2T.
+	params.gravity = (_jumpHeight * 2) / FFixed::FromInt(riseFrames * riseFrames);
+	params.jumpVelocity = GetVelocityForRiseFrames(params, riseFrames);
+
+	params.airAcceleration = _walkSpeed / FFixed::FromInt(FMath::Max(_airControlFrames, 1));
+
+	params.pushboxHalfWidth = FFixed::Max(_pushboxHalfWidth, FFixed::Zero());
+	params.pushboxHalfHeight = FFixed::Max(_pushboxHalfHeight, FFixed::Zero());
+	return params;
+}
+
+const FFighterMovementParams& FighterMovement::GetDefaultParams()
+{
+	static const FFighterMovementParams defaultParams = MakeParams(FFixed::FromInt(DefaultWalkSpeed), FFixed::FromInt(DefaultJumpHeight), DefaultJumpRiseFrames, DefaultAirControlFrames,
+		FFixed::FromInt(DefaultPushboxHalfWidth), FFixed::FromInt(DefaultPushboxHalfHeight));
+	return defaultParams;
+}
+
+FFixed FighterMovement::GetVelocityForRiseFrames(const FFighterMovementParams& _params, int32 _riseFrames)
+{
+	//Rounded down, so the fighter never stays up longer than 2 * _riseFrames
+	return FFixed::FromRaw((_params.gravity.raw * (2 * FMath::Max(_riseFrames, 1) + 1)) / 2);
+}
+
+bool FighterMovement::Step(FSimFighterState& _fighter, FFighterInput _input, const FFighterMovementParams& _params)
+{
+	FFixed targetVelocityX = FFixed::Zero();
+	if (_input & EFighterInput::Right)
+	{
+		targetVelocityX = _params.walkSpeed;
+	}
+	else if (_input & EFighterInput::Left)
+	{
+		targetVelocityX = -_params.walkSpeed;
+	}
+
+	bool hasLanded = false;
+
+	if (_fighter.isGrounded)
+	{
+		const bool isWalking = _fighter.characterState == EFighterSimState::MovingRight || _fighter.characterState == EFighterSimState::MovingLeft;
+		_fighter.velocityX = isWalking ? targetVelocityX : FFixed::Zero();
+	}
+	else
+	{
+		if (_fighter.characterState != EFighterSimState::Launched)
+		{
+			_fighter.velocityX += FFixed::Clamp(targetVelocityX - _fighter.velocityX, -_params.airAcceleration, _params.airAcceleration);
+		}
+
+		_fighter.velocityZ -= _params.gravity;
+		_fighter.positionZ += _fighter.velocityZ;
+
+		//The ground plane
+		if (_fighter.positionZ <= FFixed::Zero())
+		{
+			_fighter.positionZ = FFixed::Zero();
+			_fighter.velocityZ = FFixed::Zero();
+			_fighter.isGrounded = true;
+			hasLanded = true;
+		}
+	}
+
+	_fighter.positionX += _fighter.velocityX;
+
+	return hasLanded;
+}
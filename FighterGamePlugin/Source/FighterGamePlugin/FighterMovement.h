@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FighterSimulation.h"
+
+/**
+ * Kinematic fighter movement: walking, jump arcs, air control and launches, in fixed point and defined in frames, so a
+ * jump lasts the same number of frames and peaks at the same height on every machine at any frame rate.
+ *
+ * The only thing a fighter touches while moving is the ground plane at height 0. The walls and the other fighter are
+ * FighterPushbox's, once both have moved. Nothing is ever asked of the physics scene.
+ */
+
+//How one fighter moves, per simulation frame. Built from the designer's values by FighterMovement::MakeParams.
+struct FFighterMovementParams
+{
+	//Units per frame
+	FFixed walkSpeed;
+
+	//Leaving the ground, in units per frame, and the speed lost to gravity every frame after
+	FFixed jumpVelocity;
+	FFixed gravity;
+
+	//The most air control changes the horizontal velocity by in one frame
+	FFixed airAcceleration;
+
+	//The box around the fighter's position that the other fighter's pushbox cannot overlap
+	FFixed pushboxHalfWidth;
+	FFixed pushboxHalfHeight;
+};
+
+namespace FighterMovement
+{
+	//The designer's values the defaults are made from. They are the old CharacterMovementComponent setup (MaxWalkSpeed 600,
+	//JumpZVelocity 1000, GravityScale 2, AirControl 0.8) measured in frames: the same walk and the same gravity, a jump up
+	//to 245 units 30 frames after take-off, and full speed in the air after 22 frames of holding a direction.
+	constexpr int32 DefaultWalkSpeed = 10;
+	constexpr int32 DefaultJumpHeight = 245;
+	constexpr int32 DefaultJumpRiseFrames = 30;
+	constexpr int32 DefaultAirControlFrames = 22;
+
+	//The old character capsule (radius 42, half height 96)
+	constexpr int32 DefaultPushboxHalfWidth = 42;
+	constexpr int32 DefaultPushboxHalfHeight = 96;
+
+	/**
+	 * Works out the per-frame values for a walk of _walkSpeed units a frame, a jump that peaks _jumpHeight above the ground
+	 * _jumpRiseFrames after take-off and lands exactly as many frames later, and air control that takes _airControlFrames
+	 * to turn standing still into full walking speed, with a pushbox of _pushboxHalfWidth by _pushboxHalfHeight.
+	 */
+	FIGHTERGAMEPLUGIN_API FFighterMovementParams MakeParams(FFixed _walkSpeed, FFixed _jumpHeight, int32 _jumpRiseFrames, int32 _airControlFrames,
+		FFixed _pushboxHalfWidth, FFixed _pushboxHalfHeight);
+
+	FIGHTERGAMEPLUGIN_API const FFighterMovementParams& GetDefaultParams();
+
+	//The upward velocity that takes a fighter to their highest point _riseFrames later under _params' gravity, landing _riseFrames after that
+	FIGHTERGAMEPLUGIN_API FFixed GetVelocityForRiseFrames(const FFighterMovementParams& _params, int32 _riseFrames);
+
+	/**
+	 * Moves _fighter on by one frame: walking on the ground in the walking states, falling and steering with _input in the air,
+	 * then stopping at the ground. Returns true on the frame the fighter lands. Launched fighters follow their launch and cannot steer.
+	 */
+	FIGHTERGAMEPLUGIN_API bool Step(FSimFighterState& _fighter, FFighterInput _input, const FFighterMovementParams& _params);
+}
@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FighterMovementComponent.h"
+
+UFighterMovementComponent::UFighterMovementComponent()
+{
+	//The simulation moves the fighter
+	PrimaryComponentTick.bCanEverTick = false;
+
+	walkSpeed = (float)FighterMovement::DefaultWalkSpeed;
+	jumpHeight = (float)FighterMovement::DefaultJumpHeight;
+	jumpRiseFrames = FighterMovement::DefaultJumpRiseFrames;
+	airControlFrames = FighterMovement::DefaultAirControlFrames;
+	pushboxHalfSize = FVector2D((float)FighterMovement::DefaultPushboxHalfWidth, (float)FighterMovement::DefaultPushboxHalfHeight);
+	isGrounded = true;
+}
+
+FFighterMovementParams UFighterMovementComponent::BuildMovementParams() const
+{
+	return FighterMovement::MakeParams(FFixed::FromFloat(walkSpeed), FFixed::FromFloat(jumpHeight), jumpRiseFrames, airControlFrames,
+		FFixed::FromFloat(pushboxHalfSize.X), FFixed::FromFloat(pushboxHalfSize.Y));
+}
+
+void UFighterMovementComponent::SyncFromSimulation(const FSimFighterState& _state)
+{
+	//In units per second, as animation blueprints expect
+	Velocity = FVector(0.0f, _state.velocityX.ToFloat(), _state.velocityZ.ToFloat()) * FighterSim::FramesPerSecond;
+	isGrounded = _state.isGrounded;
+
+	//So the capsule's GetComponentVelocity agrees with the pawn's GetVelocity, as it did with the CharacterMovementComponent
+	UpdateComponentVelocity();
+}
+
+float UFighterMovementComponent::GetMaxSpeed() const
+{
+	return walkSpeed * FighterSim::FramesPerSecond;
+}
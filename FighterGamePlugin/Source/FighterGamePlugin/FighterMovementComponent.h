@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/PawnMovementComponent.h"
+#include "FighterMovement.h"
+#include "FighterMovementComponent.generated.h"
+
+/**
+ * A fighter's movement, in place of the CharacterMovementComponent. It does no movement of its own: designers set the walk,
+ * jump and air control in frames here, the game mode hands them to the simulation as FFighterMovementParams when the match
+ * starts, and the character copies the simulation's velocity and grounding back so animation can keep reading them.
+ *
+ * It never ticks, sweeps, finds floors or touches physics.
+ */
+UCLASS(ClassGroup = Fighter)
+class FIGHTERGAMEPLUGIN_API UFighterMovementComponent : public UPawnMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+	UFighterMovementComponent();
+
+	//The designer's values as the simulation uses them
+	FFighterMovementParams BuildMovementParams() const;
+
+	//Copy the fighter's velocity and grounding from the simulation
+	void SyncFromSimulation(const FSimFighterState& _state);
+
+	//UMovementComponent interface, answered from the simulation
+	virtual float GetMaxSpeed() const override;
+	virtual bool IsFalling() const override { return !isGrounded; }
+	virtual bool IsMovingOnGround() const override { return isGrounded; }
+
+	//Units per frame
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Fighter Movement")
+		float walkSpeed;
+
+	//How high above the ground a jump peaks, and how many frames after take-off. It lands as many frames after that.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Fighter Movement")
+		float jumpHeight;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Fighter Movement", meta = (ClampMin = "1"))
+		int32 jumpRiseFrames;
+
+	//How many frames holding a direction in the air takes to go from standing still to walking speed
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Fighter Movement", meta = (ClampMin = "1"))
+		int32 airControlFrames;
+
+	//Half the size of the box the other fighter cannot walk into, around the fighter's position
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Fighter Movement")
+		FVector2D pushboxHalfSize;
+
+	//Is the fighter on the ground in the simulation
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "Fighter Movement")
+		bool isGrounded;
+};
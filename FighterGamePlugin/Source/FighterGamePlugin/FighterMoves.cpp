@@ -0,0 +1,179 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FighterMoves.h"
+
+namespace
+{
+	//Where the default moves put their boxes, in front of the fighter's capsule
+	constexpr FFixed StrikeReach = FFixed::FromInt(60);
+	constexpr FFixed StrikeHalfSize = FFixed::FromInt(30);
+	constexpr FFixed ProximityReach = FFixed::FromInt(120);
+	constexpr FFixed ProximityHalfWidth = FFixed::FromInt(120);
+	constexpr FFixed ProximityHalfHeight = FFixed::FromInt(100);
+
+	//Meter the attacker gains on hit, as a fraction of the damage dealt
+	constexpr FFixed DefaultMeterGain = FFixed::FromRatio(30, 100);
+
+	struct FMoveSets
+	{
+		FFighterMoveTable tables[FighterMoves::MaxMoveSets];
+
+		FMoveSets()
+		{
+			FighterMoves::BuildDefaultMoveSet(tables[0]);
+			for (int32 index = 1; index < FighterMoves::MaxMoveSets; ++index)
+			{
+				tables[index] = tables[0];
+			}
+		}
+	};
+
+	FMoveSets& GetMoveSets()
+	{
+		static FMoveSets moveSets;
+		return moveSets;
+	}
+
+	//A move that warns the opponent for its startup and active frames, then strikes for its active frames
+	void SetDefaultMove(FFighterMoveTable& _table, EFighterMove _move, int32 _startupFrames, int32 _activeFrames, int32 _recoveryFrames,
+		int32 _damagePercent, int32 _hitstunFrames, FFixed _meterGain, FFixed _meterCost, EFighterMove _exceptionalMove)
+	{
+		FFighterMoveData data;
+		FMemory::Memzero(&data, sizeof(data));
+		data.startupFrames = _startupFrames;
+		data.activeFrames = _activeFrames;
+		data.recoveryFrames = _recoveryFrames;
+		data.damage = FFixed::FromRatio(_damagePercent, 100);
+		data.hitstunFrames = _hitstunFrames;
+		data.blockstunFrames = _hitstunFrames / 2;
+		data.pushback = FFixed::FromInt(20 + _damagePercent * 2);
+		data.meterGain = _meterGain;
+		data.meterCost = _meterCost;
+		data.exceptionalMove = _exceptionalMove;
+
+		const uint8 lastActiveFrame = (uint8)(_startupFrames + _activeFrames - 1);
+
+		FFighterMoveBox boxes[2];
+		boxes[0].type = ESimHitboxType::Proximity;
+		boxes[0].firstFrame = 0;
+		boxes[0].lastFrame = lastActiveFrame;
+		boxes[0].offsetX = ProximityReach;
+		boxes[0].offsetZ = FFixed::Zero();
+		boxes[0].halfWidth = ProximityHalfWidth;
+		boxes[0].halfHeight = ProximityHalfHeight;
+
+		boxes[1].type = ESimHitboxType::Strike;
+		boxes[1].firstFrame = (uint8)_startupFrames;
+		boxes[1].lastFrame = lastActiveFrame;
+		boxes[1].offsetX = StrikeReach;
+		boxes[1].offsetZ = FFixed::Zero();
+		boxes[1].halfWidth = StrikeHalfSize;
+		boxes[1].halfHeight = StrikeHalfSize;
+
+		verify(_table.SetMove(_move, data, boxes, UE_ARRAY_COUNT(boxes)));
+	}
+}
+
+void FFighterMoveTable::Reset()
+{
+	FMemory::Memzero(this, sizeof(*this));
+}
+
+bool FFighterMoveTable::SetMove(EFighterMove _move, const FFighterMoveData& _data, const FFighterMoveBox* _boxes, int32 _numBoxes)
+{
+	check(_move != EFighterMove::None && _move < EFighterMove::Count);
+
+	if (numBoxes + _numBoxes > MaxBoxes)
+	{
+		return false;
+	}
+
+	FFighterMoveData& move = moves[(int32)_move];
+	move = _data;
+	move.totalFrames = _data.startupFrames + _data.activeFrames + _data.recoveryFrames;
+	move.firstBox = (uint8)numBoxes;
+	move.numBoxes = (uint8)_numBoxes;
+
+	for (int32 index = 0; index < _numBoxes; ++index)
+	{
+		boxes[numBoxes++] = _boxes[index];
+	}
+	return true;
+}
+
+const FFighterMoveTable& FighterMoves::GetMoveSet(uint8 _moveSetId)
+{
+	return GetMoveSets().tables[_moveSetId < MaxMoveSets ? _moveSetId : 0];
+}
+
+void FighterMoves::RegisterMoveSet(uint8 _moveSetId, const FFighterMoveTable& _table)
+{
+	check(_moveSetId > 0 && _moveSetId < MaxMoveSets);
+	GetMoveSets().tables[_moveSetId] = _table;
+}
+
+uint32 FighterMoves::ComputeChecksum(const FFighterMoveTable& _table)
+{
+	uint32 hash = 2166136261u;
+	auto mix = [&hash](int32 _value)
+	{
+		hash = (hash ^ (uint32)_value) * 16777619u;
+	};
+
+	const FFighterMovementParams& movement = _table.movement;
+	mix(movement.walkSpeed.raw);
+	mix(movement.jumpVelocity.raw);
+	mix(movement.gravity.raw);
+	mix(movement.airAcceleration.raw);
+	mix(movement.pushboxHalfWidth.raw);
+	mix(movement.pushboxHalfHeight.raw);
+
+	for (const FFighterMoveData& move : _table.moves)
+	{
+		mix(move.startupFrames);
+		mix(move.activeFrames);
+		mix(move.recoveryFrames);
+		mix(move.totalFrames);
+		mix(move.damage.raw);
+		mix(move.hitstunFrames);
+		mix(move.blockstunFrames);
+		mix(move.pushback.raw);
+		mix(move.meterGain.raw);
+		mix(move.meterCost.raw);
+		mix((int32)move.exceptionalMove);
+		mix(move.firstBox);
+		mix(move.numBoxes);
+	}
+
+	mix(_table.numBoxes);
+	for (int32 boxIndex = 0; boxIndex < _table.numBoxes; ++boxIndex)
+	{
+		const FFighterMoveBox& box = _table.boxes[boxIndex];
+		mix((int32)box.type);
+		mix(box.firstFrame);
+		mix(box.lastFrame);
+		mix(box.offsetX.raw);
+		mix(box.offsetZ.raw);
+		mix(box.halfWidth.raw);
+		mix(box.halfHeight.raw);
+	}
+	return hash;
+}
+
+void FighterMoves::BuildDefaultMoveSet(FFighterMoveTable& _outTable)
+{
+	_outTable.Reset();
+	_outTable.movement = FighterMovement::GetDefaultParams();
+
+	//All 24 frames long, as attacks were before they had frame data
+	SetDefaultMove(_outTable, EFighterMove::Light,		4, 5, 15,	5,	12,	DefaultMeterGain,	FFixed::Zero(),				EFighterMove::LightEx);
+	SetDefaultMove(_outTable, EFighterMove::Medium,		5, 4, 15,	8,	16,	DefaultMeterGain,	FFixed::Zero(),				EFighterMove::MediumEx);
+	SetDefaultMove(_outTable, EFighterMove::Heavy,		6, 4, 14,	12,	20,	DefaultMeterGain,	FFixed::Zero(),				EFighterMove::HeavyEx);
+	SetDefaultMove(_outTable, EFighterMove::Super,		4, 5, 15,	30,	30,	DefaultMeterGain,	FFixed::One(),				EFighterMove::None);
+
+	//The exceptional versions take over partway through the normal ones, so they share their frames. The light one builds no meter.
+	SetDefaultMove(_outTable, EFighterMove::LightEx,	4, 5, 15,	5,	12,	FFixed::Zero(),		FFixed::FromRatio(20, 100),	EFighterMove::None);
+	SetDefaultMove(_outTable, EFighterMove::MediumEx,	5, 4, 15,	8,	16,	DefaultMeterGain,	FFixed::FromRatio(35, 100),	EFighterMove::None);
+	SetDefaultMove(_outTable, EFighterMove::HeavyEx,	6, 4, 14,	12,	20,	DefaultMeterGain,	FFixed::FromRatio(50, 100),	EFighterMove::None);
+}
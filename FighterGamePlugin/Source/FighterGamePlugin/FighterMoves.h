@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FighterSimulation.h"
+#include "FighterCollision.h"
+#include "FighterMovement.h"
+
+/**
+ * Frame data for every attack a fighter can do, as plain data the simulation reads directly.
+ *
+ * A fighter's attack state is just the move it is doing and how many frames into it they are, so everything about
+ * the current frame of an attack (is it active, which boxes are out, what a hit does) is one lookup into the table.
+ */
+
+//One box a move puts out, relative to the fighter
+struct FFighterMoveBox
+{
+	ESimHitboxType type;
+
+	//The move frames the box is out on, counted from 0 on the frame the move starts
+	uint8 firstFrame;
+	uint8 lastFrame;
+
+	//Centre of the box from the fighter's position, with X pointing the way they face
+	FFixed offsetX;
+	FFixed offsetZ;
+
+	FFixed halfWidth;
+	FFixed halfHeight;
+};
+
+struct FFighterMoveData
+{
+	int32 startupFrames;
+	int32 activeFrames;
+	int32 recoveryFrames;
+
+	//startupFrames + activeFrames + recoveryFrames. A move with no frames cannot be started.
+	int32 totalFrames;
+
+	//Dealt by the move's strike boxes. Blocked hits deal part of it and use blockstunFrames instead of hitstunFrames.
+	FFixed damage;
+	int32 hitstunFrames;
+	int32 blockstunFrames;
+
+	//How far a hit or block pushes the defender away, or the attacker if the defender is in the corner
+	FFixed pushback;
+
+	//Meter the attacker gains when the move hits, as a fraction of the damage dealt
+	FFixed meterGain;
+
+	//Meter needed and spent to start the move
+	FFixed meterCost;
+
+	//The move this one turns into when the exceptional button is pressed during it, or None
+	EFighterMove exceptionalMove;
+
+	//The move's boxes in the table's box array
+	uint8 firstBox;
+	uint8 numBoxes;
+};
+
+//Every move of one fighter, indexed by EFighterMove, and how they move. Fixed size, so it can be copied around like the match state.
+struct FFighterMoveTable
+{
+	static constexpr int32 MaxBoxes = 48;
+
+	FFighterMovementParams movement;
+
+	FFighterMoveData moves[(int32)EFighterMove::Count];
+
+	FFighterMoveBox boxes[MaxBoxes];
+	int32 numBoxes;
+
+	//Clears every move, so none of them can be started, and the movement
+	void Reset();
+
+	//Sets _move's frame data and appends its boxes. Returns false if the boxes do not fit.
+	bool SetMove(EFighterMove _move, const FFighterMoveData& _data, const FFighterMoveBox* _boxes, int32 _numBoxes);
+
+	const FFighterMoveData& GetMove(EFighterMove _move) const { return moves[(int32)_move]; }
+};
+
+namespace FighterMoves
+{
+	//Move set 0 is always the built-in default. The others start out as copies of it.
+	constexpr int32 MaxMoveSets = 8;
+
+	//The move set a fighter's moveSetId refers to
+	FIGHTERGAMEPLUGIN_API const FFighterMoveTable& GetMoveSet(uint8 _moveSetId);
+
+	/**
+	 * Replaces move set _moveSetId, which must not be 0. Only call this between matches on the game thread,
+	 * as simulations on any thread read the move sets without locking.
+	 */
+	FIGHTERGAMEPLUGIN_API void RegisterMoveSet(uint8 _moveSetId, const FFighterMoveTable& _table);
+
+	//Fills _outTable with the frame data used when a character has no move set asset
+	FIGHTERGAMEPLUGIN_API void BuildDefaultMoveSet(FFighterMoveTable& _outTable);
+
+	//A hash of every value in _table the simulation reads, field by field so padding never changes it
+	FIGHTERGAMEPLUGIN_API uint32 ComputeChecksum(const FFighterMoveTable& _table);
+}
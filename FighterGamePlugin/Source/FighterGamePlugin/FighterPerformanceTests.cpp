@@ -0,0 +1,332 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/ConfigCacheIni.h"
+#include "Misc/Paths.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "Engine/GameInstance.h"
+#include "FighterGamePluginGameMode.h"
+#include "FighterGamePluginCharacter.h"
+#include "YBotCharacter.h"
+#include "FighterGamePlugin.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * Per-frame performance regression tests. Each one plays a scripted fight between an AFighterGamePluginCharacter and an
+ * AYBotCharacter under the real game mode in a world of their own, pressing their inputs through the character's input
+ * functions before every frame.
+ *
+ * What is timed is one call of the game mode's Tick per frame, which always runs exactly one simulation frame: gathering
+ * both players' input, FighterSim::Step (or the loopback rollback session's tick, with its resimulation), recording the
+ * input and looking for commands, then SyncPlayersFromSimulation copying the state onto both characters and the hitbox
+ * display, and the fight camera's update. Pressing the inputs and the rest of the world's tick are not timed; the world
+ * is still ticked, with the game mode left out, so world time moves on for the rollback session's simulated latency.
+ *
+ * The mean and p99 are checked against the measured baselines in Config/FighterPerformanceBaselines.ini, and the test
+ * fails when either is over by more than the baseline's tolerance. A platform with no baseline fails too, so the gate can never
+ * pass without comparing; its results are logged in the form the baselines take, to be measured and checked in.
+ *
+ * UE4Editor-Cmd <Project>.uproject -nullrhi -unattended -ExecCmds="Automation RunTests Fighter.Performance; Quit"
+ */
+namespace
+{
+	//Frames played before timing starts, while the match sets up and the pools fill
+	constexpr int32 WarmupFrames = 120;
+
+	//One minute of fighting
+	constexpr int32 MeasuredFrames = 3600;
+
+	struct FFighterPerformanceScenario
+	{
+		//The test's name and its section in the baselines
+		const TCHAR* name;
+
+		//Attack strings up close, or just walking and jumping
+		bool isPressure;
+
+		//Run through the loopback rollback session, resimulating every frame that arrives late
+		bool useRollback;
+	};
+
+	struct FFighterPerformanceBaseline
+	{
+		float meanMicroseconds;
+		float p99Microseconds;
+
+		//How far over the baseline a result may be, as a fraction of it
+		float tolerance;
+	};
+
+	struct FFighterPerformanceResult
+	{
+		float meanMicroseconds;
+		float p99Microseconds;
+		float maxMicroseconds;
+	};
+
+	//One fighter's scripted inputs
+	struct FScriptedFighter
+	{
+		AFighterGamePluginCharacter* character;
+		AFighterGamePluginCharacter* opponent;
+
+		//How many frames this fighter's script is ahead, so the two are never in step
+		int32 frameOffset;
+
+		//The direction held since the last frame, Left, Right or None
+		FFighterInput heldDirection;
+
+		void Initialize(AFighterGamePluginCharacter* _character, AFighterGamePluginCharacter* _opponent, int32 _frameOffset)
+		{
+			character = _character;
+			opponent = _opponent;
+			frameOffset = _frameOffset;
+			heldDirection = EFighterInput::None;
+		}
+
+		void HoldDirection(FFighterInput _direction)
+		{
+			if (_direction != heldDirection)
+			{
+				character->ReleaseInput(heldDirection);
+				if (_direction != EFighterInput::None)
+				{
+					character->PressInput(_direction);
+				}
+				heldDirection = _direction;
+			}
+		}
+
+		//Presses and releases this frame's inputs
+		void Update(int32 _frame, bool _isPressure)
+		{
+			const int32 frame = _frame + frameOffset;
+			const bool isOpponentOnRight = opponent->GetActorLocation().Y >= character->GetActorLocation().Y;
+			const FFighterInput forward = isOpponentOnRight ? EFighterInput::Right : EFighterInput::Left;
+			const FFighterInput back = isOpponentOnRight ? EFighterInput::Left : EFighterInput::Right;
+
+			if (_isPressure)
+			{
+				//Walk in, then an attack every 10 frames, with the exceptional attack finishing every fourth string
+				const int32 step = frame % 60;
+				HoldDirection(step < 20 ? forward : EFighterInput::None);
+
+				if (step >= 20 && step % 10 == 0)
+				{
+					switch ((frame / 10) % 4)
+					{
+					case 0:
+						character->StartAttack1();
+						break;
+					case 1:
+						character->StartAttack2();
+						break;
+					case 2:
+						character->StartAttack3();
+						break;
+					default:
+						character->StartAttack4();
+						break;
+					}
+				}
+				if (frame % 240 == 59)
+				{
+					character->StartExceptionalAttack();
+				}
+			}
+			else
+			{
+				//Walk in, back off, then jump in
+				const int32 step = frame % 120;
+				HoldDirection(step < 60 ? forward : (step < 90 ? back : forward));
+
+				if (step == 90)
+				{
+					character->P2KeyboardJump();
+				}
+				if (step == 100)
+				{
+					character->P2KeyboardStopJumping();
+				}
+			}
+		}
+	};
+
+	//Reads _name's baseline, preferring a section for just this platform, like "Pressure.Linux", over the shared one
+	bool LoadBaseline(const TCHAR* _name, FFighterPerformanceBaseline& _outBaseline)
+	{
+		FConfigFile baselines;
+		baselines.Read(FPaths::ProjectConfigDir() / TEXT("FighterPerformanceBaselines.ini"));
+
+		for (const FString& section : { FString::Printf(TEXT("%s.%s"), _name, ANSI_TO_TCHAR(FPlatformProperties::IniPlatformName())), FString(_name) })
+		{
+			FString mean;
+			FString p99;
+			if (baselines.GetString(*section, TEXT("MeanMicroseconds"), mean) && baselines.GetString(*section, TEXT("P99Microseconds"), p99))
+			{
+				FString tolerance;
+				_outBaseline.meanMicroseconds = FCString::Atof(*mean);
+				_outBaseline.p99Microseconds = FCString::Atof(*p99);
+				_outBaseline.tolerance = baselines.GetString(*section, TEXT("Tolerance"), tolerance) ? FCString::Atof(*tolerance) : 0.25f;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	//Plays _scenario in a new world and times it. Returns false if the fight could not be set up.
+	bool RunScenario(FAutomationTestBase& _test, const FFighterPerformanceScenario& _scenario, FFighterPerformanceResult& _outResult)
+	{
+		UGameInstance* gameInstance = NewObject<UGameInstance>(GEngine);
+		gameInstance->InitializeStandalone();
+
+		UWorld* world = gameInstance->GetWorld();
+		world->GetWorldSettings()->DefaultGameMode = AFighterGamePluginGameMode::StaticClass();
+		world->SetGameMode(FURL());
+		world->InitializeActorsForPlay(FURL());
+		world->BeginPlay();
+
+		AFighterGamePluginGameMode* gameMode = world->GetAuthGameMode<AFighterGamePluginGameMode>();
+		if (!gameMode)
+		{
+			_test.AddError(TEXT("The fighter game mode was not created"));
+			GEngine->DestroyWorldContext(world);
+			world->DestroyWorld(false);
+			gameInstance->Shutdown();
+			return false;
+		}
+
+		FActorSpawnParameters spawnParameters;
+		spawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		gameMode->player1 = world->SpawnActor<AFighterGamePluginCharacter>(AFighterGamePluginCharacter::StaticClass(), FVector(0.0f, -200.0f, 100.0f), FRotator(0.0f, 90.0f, 0.0f), spawnParameters);
+		gameMode->player2 = world->SpawnActor<AYBotCharacter>(AYBotCharacter::StaticClass(), FVector(0.0f, 200.0f, 100.0f), FRotator(0.0f, -90.0f, 0.0f), spawnParameters);
+
+		//The game mode is ticked by hand below, on its own, so it is timed without the rest of the world
+		gameMode->SetActorTickEnabled(false);
+
+		FScriptedFighter fighters[2];
+		fighters[0].Initialize(gameMode->player1, gameMode->player2, 0);
+		fighters[1].Initialize(gameMode->player2, gameMode->player1, 37);
+
+		const float deltaSeconds = 1.0f / FighterSim::FramesPerSecond;
+		TArray<float> frameMicroseconds;
+		frameMicroseconds.Reserve(MeasuredFrames);
+
+		for (int32 frame = 0; frame < WarmupFrames + MeasuredFrames; ++frame)
+		{
+			//The match starts on the first tick, and the rollback session starts from it
+			if (frame == 1 && _scenario.useRollback)
+			{
+				gameMode->StartLoopbackRollback(100.0f, 20.0f, 2.0f);
+			}
+
+			for (FScriptedFighter& fighter : fighters)
+			{
+				fighter.Update(frame, _scenario.isPressure);
+			}
+
+			const uint64 startCycles = FPlatformTime::Cycles64();
+			gameMode->Tick(deltaSeconds);
+			const uint64 frameCycles = FPlatformTime::Cycles64() - startCycles;
+
+			world->Tick(LEVELTICK_All, deltaSeconds);
+
+			if (frame >= WarmupFrames)
+			{
+				frameMicroseconds.Add((float)(FPlatformTime::ToMilliseconds64(frameCycles) * 1000.0));
+			}
+		}
+
+		const bool wasMatchStarted = gameMode->isMatchStarted;
+
+		GEngine->DestroyWorldContext(world);
+		world->DestroyWorld(false);
+		gameInstance->Shutdown();
+
+		if (!wasMatchStarted)
+		{
+			_test.AddError(TEXT("The match never started, so no fighter code was timed"));
+			return false;
+		}
+
+		double totalMicroseconds = 0.0;
+		for (float microseconds : frameMicroseconds)
+		{
+			totalMicroseconds += microseconds;
+		}
+		frameMicroseconds.Sort();
+
+		_outResult.meanMicroseconds = (float)(totalMicroseconds / frameMicroseconds.Num());
+		_outResult.p99Microseconds = frameMicroseconds[FMath::Min(FMath::CeilToInt(frameMicroseconds.Num() * 0.99f), frameMicroseconds.Num()) - 1];
+		_outResult.maxMicroseconds = frameMicroseconds.Last();
+		return true;
+	}
+
+	bool RunPerformanceTest(FAutomationTestBase& _test, const FFighterPerformanceScenario& _scenario)
+	{
+		FFighterPerformanceResult result;
+		if (!RunScenario(_test, _scenario, result))
+		{
+			return false;
+		}
+
+		UE_LOG(LogFighter, Display, TEXT("Fighter performance %s: mean %.1f us, p99 %.1f us, max %.1f us per frame over %d frames"),
+			_scenario.name, result.meanMicroseconds, result.p99Microseconds, result.maxMicroseconds, MeasuredFrames);
+
+		//Written so it can be pasted into the baselines as it is
+		_test.AddInfo(FString::Printf(TEXT("[%s.%s] MeanMicroseconds=%.1f P99Microseconds=%.1f"),
+			_scenario.name, ANSI_TO_TCHAR(FPlatformProperties::IniPlatformName()), result.meanMicroseconds, result.p99Microseconds));
+
+		FFighterPerformanceBaseline baseline;
+		if (!LoadBaseline(_scenario.name, baseline))
+		{
+			_test.AddError(FString::Printf(TEXT("No baseline for %s on %s in Config/FighterPerformanceBaselines.ini, so nothing could be compared. Check in values measured on the gating machine."),
+				_scenario.name, ANSI_TO_TCHAR(FPlatformProperties::IniPlatformName())));
+			return false;
+		}
+
+		const float allowedMean = baseline.meanMicroseconds * (1.0f + baseline.tolerance);
+		const float allowedP99 = baseline.p99Microseconds * (1.0f + baseline.tolerance);
+		if (result.meanMicroseconds > allowedMean)
+		{
+			_test.AddError(FString::Printf(TEXT("%s mean frame cost regressed: %.1f us against a baseline of %.1f us (at most %.1f us allowed)"),
+				_scenario.name, result.meanMicroseconds, baseline.meanMicroseconds, allowedMean));
+		}
+		if (result.p99Microseconds > allowedP99)
+		{
+			_test.AddError(FString::Printf(TEXT("%s p99 frame cost regressed: %.1f us against a baseline of %.1f us (at most %.1f us allowed)"),
+				_scenario.name, result.p99Microseconds, baseline.p99Microseconds, allowedP99));
+		}
+		return result.meanMicroseconds <= allowedMean && result.p99Microseconds <= allowedP99;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFighterPerformanceNeutralTest, "Fighter.Performance.Neutral",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FFighterPerformanceNeutralTest::RunTest(const FString& Parameters)
+{
+	return RunPerformanceTest(*this, { TEXT("Neutral"), false, false });
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFighterPerformancePressureTest, "Fighter.Performance.Pressure",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FFighterPerformancePressureTest::RunTest(const FString& Parameters)
+{
+	return RunPerformanceTest(*this, { TEXT("Pressure"), true, false });
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFighterPerformanceRollbackTest, "Fighter.Performance.Rollback",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FFighterPerformanceRollbackTest::RunTest(const FString& Parameters)
+{
+	return RunPerformanceTest(*this, { TEXT("Rollback"), true, true });
+}
+
+#endif
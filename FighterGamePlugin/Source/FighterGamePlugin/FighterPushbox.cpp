@@ -0,0 +1,115 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FighterPushbox.h"
+#include "FighterMoves.h"
+
+namespace
+{
+	bool MovedAwayFrom(FFixed _positionX, FFixed _previousX, FFixed _otherPreviousX)
+	{
+		return _previousX >= _otherPreviousX ? _positionX > _previousX : _positionX < _previousX;
+	}
+
+	//Moves _fighter by _offsetX up to the walls, and returns the part of it the walls stopped
+	FFixed MoveUpToWalls(FSimFighterState& _fighter, FFixed _offsetX, const FSimMatchState& _state)
+	{
+		const FFixed movedX = _fighter.positionX + _offsetX;
+		_fighter.positionX = FFixed::Clamp(movedX, _state.stageLeftX, _state.stageRightX);
+		return movedX - _fighter.positionX;
+	}
+
+	//Cuts _offsetX short where it would take a fighter at _positionX further than MaxDistanceApart from _otherX
+	FFixed ClampToMaxDistance(FFixed _offsetX, FFixed _positionX, FFixed _otherX)
+	{
+		const FFixed movedX = _positionX + _offsetX;
+		if (FFixed::Abs(movedX - _otherX) <= FighterSim::MaxDistanceApart || FFixed::Abs(movedX - _otherX) <= FFixed::Abs(_positionX - _otherX))
+		{
+			return _offsetX;
+		}
+
+		//Never pulled back towards the other fighter, only stopped
+		return movedX > _otherX
+			? FFixed::Max(_otherX + FighterSim::MaxDistanceApart - _positionX, FFixed::Zero())
+			: FFixed::Min(_otherX - FighterSim::MaxDistanceApart - _positionX, FFixed::Zero());
+	}
+}
+
+void FighterPushbox::StartPushback(FSimFighterState& _fighter, FFixed _attackerX, FFixed _distance)
+{
+	//Frame k of N moves v * (N - k) / N, which adds up to v * (N + 1) / 2
+	const FFixed awayFromAttacker = _fighter.positionX != _attackerX ? (_fighter.positionX > _attackerX ? FFixed::One() : -FFixed::One()) : (_fighter.isFlipped ? -FFixed::One() : FFixed::One());
+	_fighter.pushbackVelocityX = awayFromAttacker * FFixed::FromRaw((int32)(((int64)_distance.raw * 2) / (PushbackFrames + 1)));
+	_fighter.pushbackFrames = PushbackFrames;
+}
+
+void FighterPushbox::Solve(FSimMatchState& _state, FFixed _previousX1, FFixed _previousX2)
+{
+	FSimFighterState& player1 = _state.fighters[0];
+	FSimFighterState& player2 = _state.fighters[1];
+
+	//Keep the players within the maximum distance by cancelling whichever of their own moves took them further apart
+	const FFixed distanceApart = FFixed::Abs(player1.positionX - player2.positionX);
+	if (distanceApart > FighterSim::MaxDistanceApart && distanceApart > FFixed::Abs(_previousX1 - _previousX2))
+	{
+		if (MovedAwayFrom(player1.positionX, _previousX1, _previousX2))
+		{
+			player1.positionX = _previousX1;
+		}
+		if (MovedAwayFrom(player2.positionX, _previousX2, _previousX1))
+		{
+			player2.positionX = _previousX2;
+		}
+	}
+
+	//Pushback, which waits out hit-stop like everything else
+	for (int32 playerIndex = 0; playerIndex < 2; ++playerIndex)
+	{
+		FSimFighterState& fighter = _state.fighters[playerIndex];
+		if (fighter.pushbackFrames <= 0 || fighter.timers.IsRunning(EFighterTimer::HitStop))
+		{
+			continue;
+		}
+
+		//Pushback is never cancelled by the maximum distance, it only stops at it
+		FSimFighterState& other = _state.fighters[1 - playerIndex];
+		const FFixed pushX = ClampToMaxDistance(FFixed::FromRaw(fighter.pushbackVelocityX.raw / PushbackFrames * fighter.pushbackFrames), fighter.positionX, other.positionX);
+		--fighter.pushbackFrames;
+
+		//In the corner, the attacker is pushed out instead
+		const FFixed stoppedX = MoveUpToWalls(fighter, pushX, _state);
+		MoveUpToWalls(other, -stoppedX, _state);
+	}
+
+	//The walls. Anything carrying a fighter into one stops there.
+	for (int32 playerIndex = 0; playerIndex < 2; ++playerIndex)
+	{
+		FSimFighterState& fighter = _state.fighters[playerIndex];
+		if (MoveUpToWalls(fighter, FFixed::Zero(), _state) != FFixed::Zero())
+		{
+			fighter.velocityX = FFixed::Zero();
+		}
+	}
+
+	const FFighterMovementParams& player1Movement = FighterMoves::GetMoveSet(player1.moveSetId).movement;
+	const FFighterMovementParams& player2Movement = FighterMoves::GetMoveSet(player2.moveSetId).movement;
+
+	//Pushboxes only meet if the fighters are level enough, so jumping over someone still works
+	const FFixed offsetX = player2.positionX - player1.positionX;
+	const FFixed overlapX = player1Movement.pushboxHalfWidth + player2Movement.pushboxHalfWidth - FFixed::Abs(offsetX);
+	const bool isOverlappingZ = FFixed::Abs(player2.positionZ - player1.positionZ) < player1Movement.pushboxHalfHeight + player2Movement.pushboxHalfHeight;
+	if (overlapX <= FFixed::Zero() || !isOverlappingZ)
+	{
+		return;
+	}
+
+	//Fighters keep their sides, or the sides they had before the frame if they are level, or player 1 goes left
+	const bool isPlayer1Left = offsetX != FFixed::Zero() ? offsetX > FFixed::Zero() : _previousX1 <= _previousX2;
+	const FFixed player1Direction = isPlayer1Left ? -FFixed::One() : FFixed::One();
+
+	//Half each, and a fighter at a wall passes their half on
+	const FFixed player1PushX = FFixed::FromRaw(overlapX.raw / 2);
+	const FFixed player1StoppedX = MoveUpToWalls(player1, player1Direction * player1PushX, _state);
+	const FFixed player2StoppedX = MoveUpToWalls(player2, -player1Direction * (overlapX - player1PushX) - player1StoppedX, _state);
+	MoveUpToWalls(player1, -player2StoppedX, _state);
+}
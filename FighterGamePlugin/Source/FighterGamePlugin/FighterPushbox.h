@@ -0,0 +1,33 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FighterSimulation.h"
+
+/**
+ * Keeps the fighters apart and on the stage, along the stage axis only.
+ *
+ * Each fighter has a pushbox, a box around their position from their movement params that the other fighter cannot walk
+ * into but can jump over. Once both fighters have moved in a frame, Solve settles the maximum separation, hit pushback,
+ * the walls and pushbox overlap in that order, in one pass over plain fixed-point values: no allocations, no engine
+ * collision and nothing depending on the order the fighters were added in.
+ */
+namespace FighterPushbox
+{
+	//How many frames a hit's pushback is spread over, fastest first
+	constexpr int32 PushbackFrames = 8;
+
+	//Pushes _fighter _distance away from _attackerX over the next PushbackFrames frames
+	FIGHTERGAMEPLUGIN_API void StartPushback(FSimFighterState& _fighter, FFixed _attackerX, FFixed _distance);
+
+	/**
+	 * Settles the fighters' positions for the frame, once both have moved. _previousX1 and _previousX2 are where they stood before.
+	 *
+	 * First, the fighters' own moves that take them further than MaxDistanceApart are cancelled. Then pushback moves the
+	 * fighter being pushed, stopping at MaxDistanceApart rather than being cancelled, and whatever a wall stops of it moves
+	 * the other fighter the other way instead, so hitting someone in the corner pushes the attacker out. Fighters stop at
+	 * the walls. Overlapping pushboxes are pushed apart evenly, the fighter at a wall staying put.
+	 */
+	FIGHTERGAMEPLUGIN_API void Solve(FSimMatchState& _state, FFixed _previousX1, FFixed _previousX2);
+}
@@ -0,0 +1,401 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FighterReplay.h"
+#include "Async/MappedFileHandle.h"
+#include "Containers/Queue.h"
+#include "HAL/Event.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Math/RandomStream.h"
+#include "Misc/Paths.h"
+#include "Templates/Atomic.h"
+#include "FighterMoves.h"
+#include "FighterGamePlugin.h"
+
+DECLARE_CYCLE_STAT(TEXT("Replay RecordFrame"), STAT_FighterReplayRecordFrame, STATGROUP_Fighter);
+DECLARE_CYCLE_STAT(TEXT("Replay Seek"), STAT_FighterReplaySeek, STATGROUP_Fighter);
+
+FString FighterReplay::GetReplayPath(const FString& _fileName)
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Replays"), _fileName + TEXT(".fgreplay"));
+}
+
+//Writes queued chunks to the file off the game thread
+class FFighterReplayWriter::FWorker : public FRunnable
+{
+public:
+	FWorker(FArchive* _file)
+		: file(_file)
+		, wakeEvent(FPlatformProcess::GetSynchEventFromPool())
+		, isStopping(false)
+	{
+		thread = FRunnableThread::Create(this, TEXT("FighterReplayWriter"), 0, TPri_BelowNormal);
+	}
+
+	virtual ~FWorker()
+	{
+		isStopping = true;
+		wakeEvent->Trigger();
+		thread->WaitForCompletion();
+		delete thread;
+
+		FPlatformProcess::ReturnSynchEventToPool(wakeEvent);
+		delete file;
+	}
+
+	void Enqueue(TArray<uint8>&& _bytes)
+	{
+		pending.Enqueue(MoveTemp(_bytes));
+		wakeEvent->Trigger();
+	}
+
+	virtual uint32 Run() override
+	{
+		while (!isStopping)
+		{
+			wakeEvent->Wait();
+			Flush();
+		}
+
+		//Anything queued before stopping still goes in the file
+		Flush();
+		return 0;
+	}
+
+private:
+	void Flush()
+	{
+		TArray<uint8> bytes;
+		while (pending.Dequeue(bytes))
+		{
+			file->Serialize(bytes.GetData(), bytes.Num());
+		}
+		file->Flush();
+	}
+
+	FArchive* file;
+	FEvent* wakeEvent;
+	FRunnableThread* thread;
+	TQueue<TArray<uint8>, EQueueMode::Spsc> pending;
+	TAtomic<bool> isStopping;
+};
+
+FFighterReplayWriter::FFighterReplayWriter()
+	: worker(nullptr)
+	, chunkFrames(0)
+{
+}
+
+FFighterReplayWriter::~FFighterReplayWriter()
+{
+	End();
+}
+
+bool FFighterReplayWriter::Begin(const FString& _path, const FSimMatchState& _state)
+{
+	End();
+
+	FArchive* file = IFileManager::Get().CreateFileWriter(*_path);
+	if (!file)
+	{
+		UE_LOG(LogFighter, Warning, TEXT("Could not create replay file %s"), *_path);
+		return false;
+	}
+
+	FighterReplay::FFileHeader header;
+	header.magic = FighterReplay::Magic;
+	header.version = FighterReplay::Version;
+	header.framesPerSecond = FighterSim::FramesPerSecond;
+	header.stateSize = sizeof(FSimMatchState);
+	header.keyframeInterval = FighterReplay::KeyframeInterval;
+	header.firstFrame = _state.frame;
+	for (int32 playerIndex = 0; playerIndex < 2; ++playerIndex)
+	{
+		header.moveSetChecksums[playerIndex] = FighterMoves::ComputeChecksum(FighterMoves::GetMoveSet(_state.fighters[playerIndex].moveSetId));
+	}
+	file->Serialize(&header, sizeof(header));
+
+	worker = new FWorker(file);
+	StartChunk(_state);
+	return true;
+}
+
+void FFighterReplayWriter::RecordFrame(FFighterInput _player1Input, FFighterInput _player2Input, const FSimMatchState& _state)
+{
+	FIGHTER_SCOPE_CYCLE_COUNTER(ReplayRecordFrame);
+
+	if (!worker)
+	{
+		return;
+	}
+
+	const FFighterInput inputs[2] = { _player1Input, _player2Input };
+	chunk.Append(reinterpret_cast<const uint8*>(inputs), sizeof(inputs));
+
+	if (++chunkFrames == FighterReplay::KeyframeInterval)
+	{
+		worker->Enqueue(MoveTemp(chunk));
+		StartChunk(_state);
+	}
+}
+
+void FFighterReplayWriter::End()
+{
+	if (!worker)
+	{
+		return;
+	}
+
+	//The last chunk is cut short. The reader works out how many frames it holds from the file size.
+	worker->Enqueue(MoveTemp(chunk));
+	delete worker;
+	worker = nullptr;
+}
+
+void FFighterReplayWriter::StartChunk(const FSimMatchState& _state)
+{
+	chunk.Reset(FighterReplay::ChunkSize);
+
+	FighterReplay::FChunkHeader chunkHeader;
+	chunkHeader.frame = _state.frame;
+	chunkHeader.checksum = FighterSim::ComputeChecksum(_state);
+
+	chunk.Append(reinterpret_cast<const uint8*>(&chunkHeader), sizeof(chunkHeader));
+	chunk.Append(reinterpret_cast<const uint8*>(&_state), sizeof(_state));
+	chunkFrames = 0;
+}
+
+FFighterReplayReader::FFighterReplayReader()
+	: mappedFile(nullptr)
+	, mappedRegion(nullptr)
+	, data(nullptr)
+	, dataSize(0)
+	, numChunks(0)
+	, lastFrame(0)
+{
+	FMemory::Memzero(&header, sizeof(header));
+}
+
+FFighterReplayReader::~FFighterReplayReader()
+{
+	Close();
+}
+
+bool FFighterReplayReader::Open(const FString& _path)
+{
+	Close();
+
+	mappedFile = FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*_path);
+	if (!mappedFile)
+	{
+		UE_LOG(LogFighter, Warning, TEXT("Could not open replay file %s"), *_path);
+		return false;
+	}
+
+	dataSize = mappedFile->GetFileSize();
+	const int64 firstChunkEnd = sizeof(FighterReplay::FFileHeader) + sizeof(FighterReplay::FChunkHeader) + sizeof(FSimMatchState);
+	mappedRegion = dataSize >= firstChunkEnd ? mappedFile->MapRegion(0, dataSize) : nullptr;
+	if (!mappedRegion)
+	{
+		UE_LOG(LogFighter, Warning, TEXT("Replay file %s is too short"), *_path);
+		Close();
+		return false;
+	}
+
+	data = mappedRegion->GetMappedPtr();
+	FMemory::Memcpy(&header, data, sizeof(header));
+
+	if (header.magic != FighterReplay::Magic || header.version != FighterReplay::Version || header.stateSize != sizeof(FSimMatchState)
+		|| header.keyframeInterval != FighterReplay::KeyframeInterval || header.framesPerSecond != FighterSim::FramesPerSecond)
+	{
+		UE_LOG(LogFighter, Warning, TEXT("Replay file %s was recorded with an incompatible version (%u)"), *_path, (uint32)header.version);
+		Close();
+		return false;
+	}
+
+	//The replay's inputs only reproduce the match on the move sets it was recorded with, which the current match registered
+	FSimMatchState firstKeyframe;
+	FMemory::Memcpy(&firstKeyframe, GetChunk(0) + sizeof(FighterReplay::FChunkHeader), sizeof(firstKeyframe));
+	for (int32 playerIndex = 0; playerIndex < 2; ++playerIndex)
+	{
+		if (FighterMoves::ComputeChecksum(FighterMoves::GetMoveSet(firstKeyframe.fighters[playerIndex].moveSetId)) != header.moveSetChecksums[playerIndex])
+		{
+			UE_LOG(LogFighter, Warning, TEXT("Replay file %s was recorded with different frame data or movement for player %d"), *_path, playerIndex + 1);
+			Close();
+			return false;
+		}
+	}
+
+	//Every chunk is full apart from the last, which has however many frames were recorded into it
+	const int64 chunkBytes = dataSize - sizeof(FighterReplay::FFileHeader);
+	numChunks = (int32)((chunkBytes + FighterReplay::ChunkSize - 1) / FighterReplay::ChunkSize);
+
+	const int64 lastChunkBytes = chunkBytes - (int64)(numChunks - 1) * FighterReplay::ChunkSize;
+	const int64 lastChunkFrames = (lastChunkBytes - (int64)sizeof(FighterReplay::FChunkHeader) - (int64)sizeof(FSimMatchState)) / (2 * sizeof(FFighterInput));
+	if (lastChunkFrames < 0)
+	{
+		//Cut off inside the last keyframe, so drop that chunk
+		--numChunks;
+		lastFrame = header.firstFrame + numChunks * FighterReplay::KeyframeInterval;
+	}
+	else
+	{
+		lastFrame = header.firstFrame + (numChunks - 1) * FighterReplay::KeyframeInterval + (int32)lastChunkFrames;
+	}
+
+	return true;
+}
+
+void FFighterReplayReader::Close()
+{
+	delete mappedRegion;
+	mappedRegion = nullptr;
+	delete mappedFile;
+	mappedFile = nullptr;
+
+	data = nullptr;
+	dataSize = 0;
+	numChunks = 0;
+	lastFrame = 0;
+}
+
+bool FFighterReplayReader::Seek(int32 _frame, FSimMatchState& _outState) const
+{
+	FIGHTER_SCOPE_CYCLE_COUNTER(ReplaySeek);
+
+	if (!data || _frame < header.firstFrame || _frame > lastFrame)
+	{
+		return false;
+	}
+
+	const int32 chunkIndex = FMath::Min((_frame - header.firstFrame) / FighterReplay::KeyframeInterval, numChunks - 1);
+	const uint8* chunkData = GetChunk(chunkIndex);
+
+	FighterReplay::FChunkHeader chunkHeader;
+	FMemory::Memcpy(&chunkHeader, chunkData, sizeof(chunkHeader));
+	FMemory::Memcpy(&_outState, chunkData + sizeof(FighterReplay::FChunkHeader), sizeof(_outState));
+
+	//A corrupt keyframe would resimulate garbage without any error
+	const int32 expectedFrame = header.firstFrame + chunkIndex * FighterReplay::KeyframeInterval;
+	if (chunkHeader.frame != expectedFrame || _outState.frame != expectedFrame || FighterSim::ComputeChecksum(_outState) != chunkHeader.checksum)
+	{
+		UE_LOG(LogFighter, Warning, TEXT("Replay keyframe %d is corrupt"), expectedFrame);
+		return false;
+	}
+
+	const FFighterInput* inputs = reinterpret_cast<const FFighterInput*>(chunkData + sizeof(FighterReplay::FChunkHeader) + sizeof(FSimMatchState));
+	for (int32 frameInChunk = 0; _outState.frame < _frame; ++frameInChunk)
+	{
+		FighterSim::Step(_outState, inputs[frameInChunk * 2], inputs[frameInChunk * 2 + 1]);
+	}
+
+	return true;
+}
+
+bool FFighterReplayReader::GetInputs(int32 _frame, FFighterInput& _outPlayer1Input, FFighterInput& _outPlayer2Input) const
+{
+	if (!data || _frame <= header.firstFrame || _frame > lastFrame)
+	{
+		return false;
+	}
+
+	const int32 frameIndex = _frame - header.firstFrame - 1;
+	const uint8* chunkData = GetChunk(frameIndex / FighterReplay::KeyframeInterval);
+	const uint8* inputData = chunkData + sizeof(FighterReplay::FChunkHeader) + sizeof(FSimMatchState) + (frameIndex % FighterReplay::KeyframeInterval) * 2 * sizeof(FFighterInput);
+
+	FMemory::Memcpy(&_outPlayer1Input, inputData, sizeof(FFighterInput));
+	FMemory::Memcpy(&_outPlayer2Input, inputData + sizeof(FFighterInput), sizeof(FFighterInput));
+	return true;
+}
+
+/**
+ * Records a match of random inputs, then reads it back and checks random seeks against the states seen while recording.
+ * Run "Fighter.ReplaySelfTest [Minutes] [Seeks]" from the console.
+ */
+namespace
+{
+	void ReplaySelfTest(const TArray<FString>& _args)
+	{
+		const int32 minutes = _args.Num() > 0 ? FCString::Atoi(*_args[0]) : 60;
+		const int32 numSeeks = _args.Num() > 1 ? FCString::Atoi(*_args[1]) : 200;
+		const int32 numFrames = minutes * 60 * FighterSim::FramesPerSecond;
+
+		const FString path = FighterReplay::GetReplayPath(TEXT("SelfTest"));
+		FRandomStream random(42);
+
+		FSimMatchState state;
+		FighterSim::ResetMatch(state, FFixed::FromInt(-200), FFixed::FromInt(200));
+
+		//Remember the checksum of every frame so seeks can be checked
+		TArray<uint32> checksums;
+		checksums.Reserve(numFrames + 1);
+		checksums.Add(FighterSim::ComputeChecksum(state));
+
+		FFighterReplayWriter writer;
+		if (!writer.Begin(path, state))
+		{
+			return;
+		}
+
+		FFighterInput inputs[2] = { EFighterInput::None, EFighterInput::None };
+		const double recordStart = FPlatformTime::Seconds();
+		for (int32 frame = 0; frame < numFrames; ++frame)
+		{
+			//Players hold inputs for a while, like real ones
+			for (FFighterInput& input : inputs)
+			{
+				if (random.RandRange(0, 7) == 0)
+				{
+					input = (FFighterInput)(random.RandRange(0, EFighterInput::All) & EFighterInput::All);
+				}
+			}
+
+			FighterSim::Step(state, inputs[0], inputs[1]);
+			writer.RecordFrame(inputs[0], inputs[1], state);
+			checksums.Add(FighterSim::ComputeChecksum(state));
+		}
+		writer.End();
+		const double recordSeconds = FPlatformTime::Seconds() - recordStart;
+
+		FFighterReplayReader reader;
+		if (!reader.Open(path))
+		{
+			return;
+		}
+
+		int32 numMismatches = 0;
+		double totalSeekSeconds = 0.0;
+		double maxSeekSeconds = 0.0;
+		for (int32 seek = 0; seek < numSeeks; ++seek)
+		{
+			const int32 frame = random.RandRange(reader.GetFirstFrame(), reader.GetLastFrame());
+
+			const double seekStart = FPlatformTime::Seconds();
+			FSimMatchState seekState;
+			const bool hasSeeked = reader.Seek(frame, seekState);
+			const double seekSeconds = FPlatformTime::Seconds() - seekStart;
+
+			totalSeekSeconds += seekSeconds;
+			maxSeekSeconds = FMath::Max(maxSeekSeconds, seekSeconds);
+
+			if (!hasSeeked || FighterSim::ComputeChecksum(seekState) != checksums[frame - reader.GetFirstFrame()])
+			{
+				++numMismatches;
+			}
+		}
+
+		UE_LOG(LogFighter, Display, TEXT("Replay self test: %d frames (%d min) recorded in %.1f ms to %s"), numFrames, minutes, recordSeconds * 1000.0, *path);
+		UE_LOG(LogFighter, Display, TEXT("  File size:  %.2f MB"), reader.GetFileSize() / (1024.0 * 1024.0));
+		UE_LOG(LogFighter, Display, TEXT("  Seeks:      %d, %.3f ms mean, %.3f ms max"), numSeeks, totalSeekSeconds * 1000.0 / FMath::Max(numSeeks, 1), maxSeekSeconds * 1000.0);
+		UE_LOG(LogFighter, Display, TEXT("  Mismatches: %d"), numMismatches);
+	}
+
+	FAutoConsoleCommand ReplaySelfTestCommand(
+		TEXT("Fighter.ReplaySelfTest"),
+		TEXT("Records a random match to a replay, then checks and times random seeks. Arguments: [Minutes=60] [Seeks=200]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&ReplaySelfTest));
+}
@@ -0,0 +1,130 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FighterSimulation.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+ * Replay files are a header followed by fixed-size chunks. Each chunk is a full keyframe of the match state
+ * and the next KeyframeInterval frames of input from both players, so any frame can be found by offset alone:
+ * restore the chunk's keyframe and step forward through at most KeyframeInterval - 1 frames of input.
+ * At 60 Hz an hour is about 0.9 MB.
+ */
+namespace FighterReplay
+{
+	constexpr uint32 Magic = 0x50524746; // "FGRP"
+
+	//Bump whenever the file layout, FSimMatchState or its checksum changes
+	constexpr uint16 Version = 6;
+
+	constexpr int32 KeyframeInterval = 600;
+
+	struct FFileHeader
+	{
+		uint32 magic;
+		uint16 version;
+		uint16 framesPerSecond;
+
+		//sizeof(FSimMatchState) when recorded, as a second guard against layout changes
+		uint32 stateSize;
+
+		int32 keyframeInterval;
+
+		//The frame of the first chunk's keyframe
+		int32 firstFrame;
+
+		//FighterMoves::ComputeChecksum of each fighter's move set, frame data and movement, when recorded.
+		//The inputs only replay the same match on the same data, so any other data is rejected.
+		uint32 moveSetChecksums[2];
+	};
+
+	struct FChunkHeader
+	{
+		//The frame of the keyframe that follows
+		int32 frame;
+
+		//FighterSim::ComputeChecksum of the keyframe, checked whenever it is loaded
+		uint32 checksum;
+	};
+
+	//Header, keyframe, then the inputs of both players for the KeyframeInterval frames after it
+	constexpr int32 ChunkSize = sizeof(FChunkHeader) + sizeof(FSimMatchState) + KeyframeInterval * 2 * sizeof(FFighterInput);
+
+	//Replays/<_fileName>.fgreplay in the project's Saved directory
+	FIGHTERGAMEPLUGIN_API FString GetReplayPath(const FString& _fileName);
+}
+
+/**
+ * Records a match into a replay file. Frames are packed into the current chunk on the game thread,
+ * and full chunks are handed to a background thread that does the file writes.
+ */
+class FIGHTERGAMEPLUGIN_API FFighterReplayWriter
+{
+public:
+	FFighterReplayWriter();
+	~FFighterReplayWriter();
+
+	//Creates the file and starts recording from _state, which becomes the first keyframe
+	bool Begin(const FString& _path, const FSimMatchState& _state);
+
+	//Records the inputs that stepped the match into _state. Must be called for every frame in order.
+	void RecordFrame(FFighterInput _player1Input, FFighterInput _player2Input, const FSimMatchState& _state);
+
+	//Writes the last partial chunk and waits for the file to be closed
+	void End();
+
+	bool IsRecording() const { return worker != nullptr; }
+
+private:
+	void StartChunk(const FSimMatchState& _state);
+
+	class FWorker;
+	FWorker* worker;
+
+	//The chunk being filled, handed to the worker once full
+	TArray<uint8> chunk;
+	int32 chunkFrames;
+};
+
+/**
+ * Plays back a replay file. The file is memory-mapped, so opening it reads nothing and
+ * seeking only touches the one chunk it needs.
+ */
+class FIGHTERGAMEPLUGIN_API FFighterReplayReader
+{
+public:
+	FFighterReplayReader();
+	~FFighterReplayReader();
+
+	bool Open(const FString& _path);
+	void Close();
+
+	bool IsOpen() const { return data != nullptr; }
+
+	int32 GetFirstFrame() const { return header.firstFrame; }
+	int32 GetLastFrame() const { return lastFrame; }
+	int64 GetFileSize() const { return dataSize; }
+
+	//Restores the match as it was after _frame. Returns false if the frame is not in the replay or its keyframe is corrupt.
+	bool Seek(int32 _frame, FSimMatchState& _outState) const;
+
+	//The inputs that stepped the match onto _frame
+	bool GetInputs(int32 _frame, FFighterInput& _outPlayer1Input, FFighterInput& _outPlayer2Input) const;
+
+private:
+	const uint8* GetChunk(int32 _chunkIndex) const { return data + sizeof(FighterReplay::FFileHeader) + (int64)_chunkIndex * FighterReplay::ChunkSize; }
+
+	IMappedFileHandle* mappedFile;
+	IMappedFileRegion* mappedRegion;
+
+	const uint8* data;
+	int64 dataSize;
+
+	FighterReplay::FFileHeader header;
+	int32 numChunks;
+	int32 lastFrame;
+};
@@ -0,0 +1,322 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FighterRollback.h"
+#include "HAL/IConsoleManager.h"
+#include "FighterGamePlugin.h"
+
+DECLARE_CYCLE_STAT(TEXT("Rollback Resimulate"), STAT_FighterRollback, STATGROUP_Fighter);
+
+FFighterRollbackSession::FFighterRollbackSession(int32 _localPlayerIndex, const FSimMatchState& _initialState)
+{
+	check(_localPlayerIndex == 0 || _localPlayerIndex == 1);
+
+	localPlayerIndex = _localPlayerIndex;
+	state = _initialState;
+
+	FMemory::Memzero(snapshots, sizeof(snapshots));
+	FMemory::Memzero(localInputs, sizeof(localInputs));
+	FMemory::Memzero(remoteInputs, sizeof(remoteInputs));
+	FMemory::Memzero(simulatedRemoteInputs, sizeof(simulatedRemoteInputs));
+	FMemory::Memzero(&stats, sizeof(stats));
+
+	for (int32 slot = 0; slot < HistoryCapacity; ++slot)
+	{
+		remoteInputFrames[slot] = INDEX_NONE;
+	}
+
+	//Both players start from the same state with no input held
+	snapshots[Slot(state.frame)] = state;
+	remoteInputFrames[Slot(state.frame)] = state.frame;
+
+	confirmedRemoteFrame = state.frame;
+	remoteAckFrame = state.frame;
+	firstMispredictedFrame = INDEX_NONE;
+	verifiedFrame = state.frame;
+}
+
+bool FFighterRollbackSession::AdvanceFrame(FFighterInput _localInput)
+{
+	stats.rollbacksThisFrame = 0;
+	stats.framesResimulatedThisFrame = 0;
+	stats.resimulationSecondsThisFrame = 0.0;
+
+	if (firstMispredictedFrame != INDEX_NONE)
+	{
+		Rollback();
+	}
+
+	const int32 frame = state.frame + 1;
+	if (frame - confirmedRemoteFrame > MaxRollbackFrames)
+	{
+		++stats.stalledFrames;
+		verifiedFrame = FMath::Min(confirmedRemoteFrame, state.frame);
+		return false;
+	}
+
+	localInputs[Slot(frame)] = _localInput;
+	SimulateFrame(frame);
+
+	++stats.totalFrames;
+	verifiedFrame = FMath::Min(confirmedRemoteFrame, state.frame);
+	return true;
+}
+
+void FFighterRollbackSession::SimulateFrame(int32 _frame)
+{
+	const int32 slot = Slot(_frame);
+
+	//Until the real input arrives, assume the remote player keeps doing what they last did
+	const FFighterInput remoteInput = remoteInputFrames[slot] == _frame ? remoteInputs[slot] : remoteInputs[Slot(confirmedRemoteFrame)];
+	simulatedRemoteInputs[slot] = remoteInput;
+
+	if (localPlayerIndex == 0)
+	{
+		FighterSim::Step(state, localInputs[slot], remoteInput);
+	}
+	else
+	{
+		FighterSim::Step(state, remoteInput, localInputs[slot]);
+	}
+
+	check(state.frame == _frame);
+	snapshots[slot] = state;
+}
+
+void FFighterRollbackSession::Rollback()
+{
+	FIGHTER_SCOPE_CYCLE_COUNTER(Rollback);
+
+	const double startSeconds = FPlatformTime::Seconds();
+
+	const int32 currentFrame = state.frame;
+	const int32 rollbackFrame = firstMispredictedFrame;
+	firstMispredictedFrame = INDEX_NONE;
+
+	check(rollbackFrame > currentFrame - HistoryCapacity + 1 && rollbackFrame <= currentFrame);
+
+	state = snapshots[Slot(rollbackFrame - 1)];
+	for (int32 frame = rollbackFrame; frame <= currentFrame; ++frame)
+	{
+		SimulateFrame(frame);
+	}
+
+	const int32 framesResimulated = currentFrame - rollbackFrame + 1;
+	const double resimulationSeconds = FPlatformTime::Seconds() - startSeconds;
+
+	stats.rollbacksThisFrame = 1;
+	stats.framesResimulatedThisFrame = framesResimulated;
+	stats.resimulationSecondsThisFrame = resimulationSeconds;
+	++stats.totalRollbacks;
+	stats.totalFramesResimulated += framesResimulated;
+	stats.maxRollbackFrames = FMath::Max(stats.maxRollbackFrames, framesResimulated);
+	stats.totalResimulationSeconds += resimulationSeconds;
+	stats.maxResimulationSeconds = FMath::Max(stats.maxResimulationSeconds, resimulationSeconds);
+}
+
+void FFighterRollbackSession::ReceivePacket(const FRollbackInputPacket& _packet)
+{
+	remoteAckFrame = FMath::Max(remoteAckFrame, _packet.ackFrame);
+
+	for (int32 input = 0; input < _packet.numInputs; ++input)
+	{
+		const int32 frame = _packet.firstFrame + input;
+
+		//Already confirmed, or so far ahead it would overwrite history that is still needed
+		if (frame <= confirmedRemoteFrame || frame > confirmedRemoteFrame + HistoryCapacity / 2)
+		{
+			continue;
+		}
+
+		const int32 slot = Slot(frame);
+		if (remoteInputFrames[slot] == frame)
+		{
+			continue;
+		}
+
+		remoteInputs[slot] = _packet.inputs[input];
+		remoteInputFrames[slot] = frame;
+
+		if (frame <= state.frame && simulatedRemoteInputs[slot] != _packet.inputs[input])
+		{
+			firstMispredictedFrame = firstMispredictedFrame == INDEX_NONE ? frame : FMath::Min(firstMispredictedFrame, frame);
+		}
+	}
+
+	while (remoteInputFrames[Slot(confirmedRemoteFrame + 1)] == confirmedRemoteFrame + 1)
+	{
+		++confirmedRemoteFrame;
+	}
+}
+
+void FFighterRollbackSession::MakePacket(FRollbackInputPacket& _outPacket) const
+{
+	//Anything older than the history is certain to have arrived, because the remote peer stalls long before that
+	const int32 firstFrame = FMath::Max(remoteAckFrame + 1, state.frame - HistoryCapacity + 1);
+
+	_outPacket.firstFrame = firstFrame;
+	_outPacket.numInputs = FMath::Clamp(state.frame - firstFrame + 1, 0, (int32)FRollbackInputPacket::MaxInputs);
+	_outPacket.ackFrame = confirmedRemoteFrame;
+
+	for (int32 input = 0; input < _outPacket.numInputs; ++input)
+	{
+		_outPacket.inputs[input] = localInputs[Slot(firstFrame + input)];
+	}
+}
+
+uint32 FFighterRollbackSession::GetVerifiedChecksum(int32 _frame) const
+{
+	if (_frame > verifiedFrame || _frame <= state.frame - HistoryCapacity)
+	{
+		return 0;
+	}
+
+	return FighterSim::ComputeChecksum(snapshots[Slot(_frame)]);
+}
+
+const FSimMatchState* FFighterRollbackSession::GetSimulatedFrame(int32 _frame, FFighterInput& _outPlayer1Input, FFighterInput& _outPlayer2Input) const
+{
+	if (_frame > state.frame || _frame <= state.frame - HistoryCapacity)
+	{
+		return nullptr;
+	}
+
+	const int32 slot = Slot(_frame);
+	_outPlayer1Input = localPlayerIndex == 0 ? localInputs[slot] : simulatedRemoteInputs[slot];
+	_outPlayer2Input = localPlayerIndex == 0 ? simulatedRemoteInputs[slot] : localInputs[slot];
+	return &snapshots[slot];
+}
+
+FRollbackLoopback::FRollbackLoopback(const FSimMatchState& _initialState, const FRollbackLoopbackSettings& _settings)
+	: player1Session(0, _initialState)
+	, player2Session(1, _initialState)
+	, settings(_settings)
+	, random(_settings.seed)
+{
+	//Enough for a second of packets in both directions
+	packetsInFlight.Reserve(2 * FighterSim::FramesPerSecond);
+}
+
+void FRollbackLoopback::Tick(double _nowSeconds, FFighterInput _player1Input, FFighterInput _player2Input)
+{
+	//Jitter reorders packets, which the sessions handle like any real network would
+	for (int32 index = packetsInFlight.Num() - 1; index >= 0; --index)
+	{
+		if (packetsInFlight[index].deliverySeconds <= _nowSeconds)
+		{
+			FFighterRollbackSession& receiver = packetsInFlight[index].toPlayer == 0 ? player1Session : player2Session;
+			receiver.ReceivePacket(packetsInFlight[index].packet);
+			packetsInFlight.RemoveAtSwap(index, 1, false);
+		}
+	}
+
+	player1Session.AdvanceFrame(_player1Input);
+	player2Session.AdvanceFrame(_player2Input);
+
+	FRollbackInputPacket packet;
+	player1Session.MakePacket(packet);
+	Send(1, packet, _nowSeconds);
+	player2Session.MakePacket(packet);
+	Send(0, packet, _nowSeconds);
+}
+
+void FRollbackLoopback::Send(int32 _toPlayer, const FRollbackInputPacket& _packet, double _nowSeconds)
+{
+	if (random.FRand() * 100.0f < settings.packetLossPercent)
+	{
+		return;
+	}
+
+	const float delayMilliseconds = FMath::Max(0.0f, settings.latencyMilliseconds + random.FRandRange(-settings.jitterMilliseconds, settings.jitterMilliseconds));
+
+	FPacketInFlight& packetInFlight = packetsInFlight.AddDefaulted_GetRef();
+	packetInFlight.deliverySeconds = _nowSeconds + delayMilliseconds / 1000.0f;
+	packetInFlight.toPlayer = _toPlayer;
+	packetInFlight.packet = _packet;
+}
+
+namespace
+{
+	//Plays a bot-versus-bot match through the loopback and checks that both peers end up with identical states
+	void RunRollbackLoopbackTest(const TArray<FString>& _args)
+	{
+		const int32 numFrames = _args.Num() > 0 ? FCString::Atoi(*_args[0]) : 3600;
+
+		FRollbackLoopbackSettings settings;
+		settings.latencyMilliseconds = _args.Num() > 1 ? FCString::Atof(*_args[1]) : 80.0f;
+		settings.jitterMilliseconds = _args.Num() > 2 ? FCString::Atof(*_args[2]) : 20.0f;
+		settings.packetLossPercent = _args.Num() > 3 ? FCString::Atof(*_args[3]) : 5.0f;
+		settings.seed = 42;
+
+		FSimMatchState initialState;
+		FighterSim::ResetMatch(initialState, FFixed::FromInt(-200), FFixed::FromInt(200));
+
+		FRollbackLoopback loopback(initialState, settings);
+		FRandomStream botRandom(7);
+		FFighterInput botInputs[2] = { EFighterInput::None, EFighterInput::None };
+
+		const double frameSeconds = 1.0 / FighterSim::FramesPerSecond;
+		double maxFrameResimulationSeconds = 0.0;
+		int32 tick = 0;
+
+		for (; tick < numFrames; ++tick)
+		{
+			//Bots hold an input for a while, like a person would
+			for (FFighterInput& botInput : botInputs)
+			{
+				if (botRandom.RandRange(0, 7) == 0)
+				{
+					botInput = (FFighterInput)botRandom.RandRange(0, EFighterInput::All);
+				}
+			}
+
+			loopback.Tick(tick * frameSeconds, botInputs[0], botInputs[1]);
+
+			for (int32 player = 0; player < 2; ++player)
+			{
+				maxFrameResimulationSeconds = FMath::Max(maxFrameResimulationSeconds, loopback.GetSession(player).GetStats().resimulationSecondsThisFrame);
+			}
+		}
+
+		//Let the last inputs arrive so there is a recent frame both peers have verified
+		const int32 targetFrame = FMath::Min(loopback.GetSession(0).GetState().frame, loopback.GetSession(1).GetState().frame);
+		for (int32 drainTick = 0; drainTick < 10 * FighterSim::FramesPerSecond; ++drainTick, ++tick)
+		{
+			if (loopback.GetSession(0).GetVerifiedFrame() >= targetFrame && loopback.GetSession(1).GetVerifiedFrame() >= targetFrame)
+			{
+				break;
+			}
+			loopback.Tick(tick * frameSeconds, EFighterInput::None, EFighterInput::None);
+		}
+
+		const int32 compareFrame = FMath::Min(loopback.GetSession(0).GetVerifiedFrame(), loopback.GetSession(1).GetVerifiedFrame());
+		const uint32 player1Checksum = loopback.GetSession(0).GetVerifiedChecksum(compareFrame);
+		const uint32 player2Checksum = loopback.GetSession(1).GetVerifiedChecksum(compareFrame);
+
+		UE_LOG(LogFighter, Display, TEXT("Rollback loopback: %d frames, %.0f ms latency, %.0f ms jitter, %.1f%% loss"),
+			numFrames, settings.latencyMilliseconds, settings.jitterMilliseconds, settings.packetLossPercent);
+
+		for (int32 player = 0; player < 2; ++player)
+		{
+			const FRollbackStats& stats = loopback.GetSession(player).GetStats();
+			UE_LOG(LogFighter, Display, TEXT("  P%d: %d frames, %d rollbacks, %d frames resimulated (max %d in one rollback), %d stalls, resimulation %.3f ms average / %.3f ms max"),
+				player + 1, stats.totalFrames, stats.totalRollbacks, stats.totalFramesResimulated, stats.maxRollbackFrames, stats.stalledFrames,
+				stats.totalRollbacks > 0 ? stats.totalResimulationSeconds * 1000.0 / stats.totalRollbacks : 0.0, stats.maxResimulationSeconds * 1000.0);
+		}
+
+		if (player1Checksum != 0 && player1Checksum == player2Checksum)
+		{
+			UE_LOG(LogFighter, Display, TEXT("  Frame %d verified identical on both peers (checksum %08x). Worst frame spent %.3f ms resimulating."),
+				compareFrame, player1Checksum, maxFrameResimulationSeconds * 1000.0);
+		}
+		else
+		{
+			UE_LOG(LogFighter, Error, TEXT("  Desync at frame %d: %08x vs %08x"), compareFrame, player1Checksum, player2Checksum);
+		}
+	}
+
+	FAutoConsoleCommand RollbackLoopbackTestCommand(
+		TEXT("Fighter.RollbackLoopbackTest"),
+		TEXT("Runs a bot match through two rollback peers on a simulated network. Arguments: [Frames=3600] [LatencyMs=80] [JitterMs=20] [LossPercent=5]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&RunRollbackLoopbackTest));
+}
@@ -0,0 +1,165 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/RandomStream.h"
+#include "FighterSimulation.h"
+
+//Input sent from one peer to the other every frame. Unacknowledged inputs are resent so lost packets do not stall the match.
+struct FRollbackInputPacket
+{
+	static constexpr int32 MaxInputs = 16;
+
+	//The frame of inputs[0]
+	int32 firstFrame;
+
+	int32 numInputs;
+
+	//The newest frame of the receiver's input that the sender has received, with no gaps
+	int32 ackFrame;
+
+	FFighterInput inputs[MaxInputs];
+};
+
+struct FRollbackStats
+{
+	//Did the last AdvanceFrame roll back, and how far
+	int32 rollbacksThisFrame;
+	int32 framesResimulatedThisFrame;
+	double resimulationSecondsThisFrame;
+
+	int32 totalFrames;
+	int32 totalRollbacks;
+	int32 totalFramesResimulated;
+	int32 maxRollbackFrames;
+	double totalResimulationSeconds;
+	double maxResimulationSeconds;
+
+	//Frames the session could not advance because the remote input was too far behind
+	int32 stalledFrames;
+};
+
+/**
+ * GGPO-style rollback for one peer of a two-player match.
+ *
+ * Every frame is simulated straight away with a prediction of the remote player's input (their last confirmed input).
+ * The state after each frame goes into a preallocated snapshot ring. When real remote input arrives and differs from
+ * the prediction, the session restores the snapshot from before that frame and resimulates up to the present.
+ */
+class FIGHTERGAMEPLUGIN_API FFighterRollbackSession
+{
+public:
+	//The furthest the session will simulate ahead of confirmed remote input before it stalls
+	static constexpr int32 MaxRollbackFrames = 8;
+
+	//Frames of snapshots and inputs kept. Must be a power of two and comfortably above MaxRollbackFrames.
+	static constexpr int32 HistoryCapacity = 32;
+
+	FFighterRollbackSession(int32 _localPlayerIndex, const FSimMatchState& _initialState);
+
+	//Simulates the next frame with the local player's input. Returns false without simulating if the session has to wait for the remote player.
+	bool AdvanceFrame(FFighterInput _localInput);
+
+	//Takes in remote input. Any misprediction is corrected on the next AdvanceFrame.
+	void ReceivePacket(const FRollbackInputPacket& _packet);
+
+	//Builds the packet to send to the remote peer after this frame
+	void MakePacket(FRollbackInputPacket& _outPacket) const;
+
+	const FSimMatchState& GetState() const { return state; }
+
+	//The newest frame simulated with confirmed input from both players. Its snapshot will never change again.
+	int32 GetVerifiedFrame() const { return verifiedFrame; }
+
+	//The checksum of a verified frame still in the snapshot ring, or 0 if it is unavailable
+	uint32 GetVerifiedChecksum(int32 _frame) const;
+
+	//The inputs a frame still in the snapshot ring was last simulated with and the state after it, or null if it is unavailable.
+	//Frames up to GetVerifiedFrame() will not change again; newer ones may still be rolled back.
+	const FSimMatchState* GetSimulatedFrame(int32 _frame, FFighterInput& _outPlayer1Input, FFighterInput& _outPlayer2Input) const;
+
+	const FRollbackStats& GetStats() const { return stats; }
+
+	int32 GetLocalPlayerIndex() const { return localPlayerIndex; }
+
+private:
+	//Restores the snapshot before firstMispredictedFrame and simulates back up to the current frame
+	void Rollback();
+
+	//Simulates one frame from the current state with the best input known for it
+	void SimulateFrame(int32 _frame);
+
+	static int32 Slot(int32 _frame) { return _frame & (HistoryCapacity - 1); }
+
+	int32 localPlayerIndex;
+
+	FSimMatchState state;
+
+	//The state after each frame, indexed by Slot(frame)
+	FSimMatchState snapshots[HistoryCapacity];
+
+	FFighterInput localInputs[HistoryCapacity];
+
+	//Remote input by slot, valid when remoteInputFrames holds the same frame
+	FFighterInput remoteInputs[HistoryCapacity];
+	int32 remoteInputFrames[HistoryCapacity];
+
+	//The remote input each frame was last simulated with, to detect mispredictions
+	FFighterInput simulatedRemoteInputs[HistoryCapacity];
+
+	//The newest frame up to which every remote input has arrived
+	int32 confirmedRemoteFrame;
+
+	//The newest frame up to which the remote peer has every local input
+	int32 remoteAckFrame;
+
+	//The oldest frame simulated with a wrong prediction, or INDEX_NONE
+	int32 firstMispredictedFrame;
+
+	int32 verifiedFrame;
+
+	FRollbackStats stats;
+};
+
+//Settings for the simulated network between two loopback peers
+struct FRollbackLoopbackSettings
+{
+	float latencyMilliseconds = 50.0f;
+	float jitterMilliseconds = 10.0f;
+	float packetLossPercent = 2.0f;
+	int32 seed = 0;
+};
+
+/**
+ * Two rollback sessions in one process, joined by a simulated network with latency, jitter and packet loss.
+ * Used to exercise netcode locally and headless.
+ */
+class FIGHTERGAMEPLUGIN_API FRollbackLoopback
+{
+public:
+	FRollbackLoopback(const FSimMatchState& _initialState, const FRollbackLoopbackSettings& _settings);
+
+	//Delivers the packets due by _nowSeconds, advances both peers with their local inputs and sends their packets.
+	void Tick(double _nowSeconds, FFighterInput _player1Input, FFighterInput _player2Input);
+
+	const FFighterRollbackSession& GetSession(int32 _playerIndex) const { return _playerIndex == 0 ? player1Session : player2Session; }
+
+private:
+	struct FPacketInFlight
+	{
+		double deliverySeconds;
+		int32 toPlayer;
+		FRollbackInputPacket packet;
+	};
+
+	void Send(int32 _toPlayer, const FRollbackInputPacket& _packet, double _nowSeconds);
+
+	FFighterRollbackSession player1Session;
+	FFighterRollbackSession player2Session;
+
+	FRollbackLoopbackSettings settings;
+	FRandomStream random;
+
+	TArray<FPacketInFlight> packetsInFlight;
+};
@@ -0,0 +1,465 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FighterSimulation.h"
+#include "FighterMoves.h"
+#include "FighterCollision.h"
+#include "FighterStateMachine.h"
+#include "FighterMovement.h"
+#include "FighterPushbox.h"
+
+namespace
+{
+	//How long both fighters freeze when a hit connects
+	constexpr int32 HitStopFrames = 4;
+
+	//Meter gained by the defender, and by an attacker hitting outside of a move, as a fraction of the damage dealt
+	constexpr FFixed DefenderMeterGain = FFixed::FromRatio(85, 100);
+	constexpr FFixed AttackerMeterGain = FFixed::FromRatio(30, 100);
+
+	//Fraction of the damage that still gets through a block
+	constexpr FFixed BlockedDamageScale = FFixed::FromRatio(50, 100);
+
+	void AddSuperMeter(FSimFighterState& _fighter, FFixed _amount)
+	{
+		_fighter.superMeter = FFixed::Clamp(_fighter.superMeter + _amount, FFixed::Zero(), FFixed::One());
+	}
+
+	void BeginStun(FSimFighterState& _fighter, EFighterTimer _stunTimer, int32 _frames, int32 _frame)
+	{
+		//Hitstun and blockstun replace each other
+		_fighter.timers.Stop(EFighterTimer::Hitstun);
+		_fighter.timers.Stop(EFighterTimer::Blockstun);
+		_fighter.timers.Start(_stunTimer, _frames, _frame);
+	}
+
+	void BeginHitStop(FSimFighterState& _fighter, int32 _frame)
+	{
+		//Whatever was running picks up where it left off once the freeze is over
+		const int32 remainingFrames = _fighter.timers.GetRemainingFrames(EFighterTimer::HitStop, _frame);
+		if (HitStopFrames > remainingFrames)
+		{
+			_fighter.timers.Delay(HitStopFrames - remainingFrames, _frame, EFighterTimer::HitStop);
+			_fighter.timers.Start(EFighterTimer::HitStop, HitStopFrames, _frame);
+		}
+	}
+
+	void EndMove(FSimFighterState& _fighter)
+	{
+		_fighter.move = EFighterMove::None;
+		_fighter.moveFrame = 0;
+		_fighter.hasMoveConnected = false;
+	}
+
+	//Starts _move if the fighter is free and has the meter for it
+	void StartMove(FSimFighterState& _fighter, EFighterMove _move)
+	{
+		const FFighterMoveData& move = FighterMoves::GetMoveSet(_fighter.moveSetId).GetMove(_move);
+		if (!_fighter.canMove || _fighter.move != EFighterMove::None || move.totalFrames == 0 || _fighter.superMeter < move.meterCost)
+		{
+			return;
+		}
+
+		_fighter.superMeter -= move.meterCost;
+		_fighter.move = _move;
+		_fighter.moveFrame = 0;
+		_fighter.hasMoveConnected = false;
+	}
+
+	//Moves the fighter's attack on by a frame, and ends it after its last frame
+	void AdvanceMove(FSimFighterState& _fighter)
+	{
+		if (_fighter.move != EFighterMove::None && ++_fighter.moveFrame >= FighterMoves::GetMoveSet(_fighter.moveSetId).GetMove(_fighter.move).totalFrames)
+		{
+			EndMove(_fighter);
+		}
+	}
+
+	//Runs _event through the state machine and carries out the actions it asks for
+	void DispatchEvent(FSimFighterState& _fighter, EFighterEvent _event)
+	{
+		const uint8 actions = FighterStateMachine::Dispatch(_fighter, _event);
+
+		//A jump pressed in the air only changes the state
+		const bool isLeavingGround = (actions & EFighterAction::Jump) != 0 && _fighter.isGrounded;
+		_fighter.velocityZ = isLeavingGround ? FighterMoves::GetMoveSet(_fighter.moveSetId).movement.jumpVelocity : _fighter.velocityZ;
+		_fighter.isGrounded = _fighter.isGrounded && !isLeavingGround;
+	}
+
+	//Turns this frame's presses, releases and held directions into state changes
+	void ApplyInput(FSimFighterState& _fighter, FFighterInput _input)
+	{
+		const FFighterInput pressed = _input & ~_fighter.previousInput;
+		const FFighterInput released = _fighter.previousInput & ~_input;
+		_fighter.previousInput = _input;
+
+		//Every possible event is dispatched, as None when it did not happen
+		DispatchEvent(_fighter, FighterStateMachine::EventIf((pressed & EFighterInput::Up) != 0, EFighterEvent::JumpPressed));
+		DispatchEvent(_fighter, FighterStateMachine::EventIf((released & EFighterInput::Up) != 0, EFighterEvent::JumpReleased));
+		DispatchEvent(_fighter, FighterStateMachine::EventIf((pressed & EFighterInput::Down) != 0, EFighterEvent::CrouchPressed));
+		DispatchEvent(_fighter, FighterStateMachine::EventIf((released & EFighterInput::Down) != 0, EFighterEvent::CrouchReleased));
+		DispatchEvent(_fighter, FighterStateMachine::EventIf((pressed & EFighterInput::Block) != 0, EFighterEvent::BlockPressed));
+		DispatchEvent(_fighter, FighterStateMachine::EventIf((released & EFighterInput::Block) != 0, EFighterEvent::BlockReleased));
+
+		//Buttons pressed together start the strongest move
+		if (pressed & EFighterInput::Attack4)
+		{
+			StartMove(_fighter, EFighterMove::Super);
+		}
+		if (pressed & EFighterInput::Attack3)
+		{
+			StartMove(_fighter, EFighterMove::Heavy);
+		}
+		if (pressed & EFighterInput::Attack2)
+		{
+			StartMove(_fighter, EFighterMove::Medium);
+		}
+		if (pressed & EFighterInput::Attack1)
+		{
+			StartMove(_fighter, EFighterMove::Light);
+		}
+		if (pressed & EFighterInput::Exceptional)
+		{
+			FighterSim::StartExceptionalAttack(_fighter);
+		}
+
+		//The held direction walks, in the states that allow it
+		const EFighterEvent holdEvent = (_input & EFighterInput::Right) ? EFighterEvent::HoldRight : ((_input & EFighterInput::Left) ? EFighterEvent::HoldLeft : EFighterEvent::HoldNeutral);
+		DispatchEvent(_fighter, holdEvent);
+	}
+
+	void Move(FSimFighterState& _fighter, FFighterInput _input)
+	{
+		if (FighterMovement::Step(_fighter, _input, FighterMoves::GetMoveSet(_fighter.moveSetId).movement))
+		{
+			//A launched fighter stays down until the launch timer runs out
+			const bool hasLaunchEnded = _fighter.characterState == EFighterSimState::Launched && !_fighter.timers.IsRunning(EFighterTimer::Launch);
+			DispatchEvent(_fighter, hasLaunchEnded ? EFighterEvent::LaunchRecovered : EFighterEvent::Landed);
+		}
+	}
+
+	void AdvanceTimers(FSimFighterState& _fighter, int32 _frame)
+	{
+		const uint8 expired = _fighter.timers.Advance(_frame);
+		if (expired == 0)
+		{
+			return;
+		}
+
+		if (expired & (FFighterTimerWheel::Bit(EFighterTimer::Hitstun) | FFighterTimerWheel::Bit(EFighterTimer::Blockstun)))
+		{
+			DispatchEvent(_fighter, EFighterEvent::StunEnded);
+		}
+
+		//A launched fighter only recovers once they are back on the ground as well
+		if ((expired & FFighterTimerWheel::Bit(EFighterTimer::Launch)) && _fighter.isGrounded)
+		{
+			DispatchEvent(_fighter, EFighterEvent::LaunchRecovered);
+		}
+	}
+
+	//Finds the frame's hits between the two fighters and applies them. Returns the number of fighters whose strike connected.
+	int32 ResolveHits(FSimMatchState& _state)
+	{
+		FFighterHitboxTable table;
+		FighterSim::BuildHitboxTable(_state, table);
+
+		FSimHit hits[FighterCollision::MaxHits];
+		const int32 numHits = FighterCollision::FindHits(table, hits);
+		FighterCollision::ApplyHits(_state, table, hits, numHits);
+
+		//A move's strike only connects once, however many frames it stays out
+		int32 numStrikes = 0;
+		for (int32 index = 0; index < numHits; ++index)
+		{
+			FSimFighterState& attacker = _state.fighters[hits[index].attackerIndex];
+			if (hits[index].type == ESimHitboxType::Strike && !attacker.hasMoveConnected)
+			{
+				attacker.hasMoveConnected = true;
+				++numStrikes;
+			}
+		}
+		return numStrikes;
+	}
+}
+
+int32 FighterSim::SecondsToFrames(float _seconds)
+{
+	return FMath::Max(0, FMath::RoundToInt(_seconds * FramesPerSecond));
+}
+
+void FighterSim::ResetMatch(FSimMatchState& _state, FFixed _player1PositionX, FFixed _player2PositionX, uint8 _player1MoveSetId, uint8 _player2MoveSetId)
+{
+	FMemory::Memzero(&_state, sizeof(_state));
+
+	const FFixed startPositions[2] = { _player1PositionX, _player2PositionX };
+	const uint8 moveSetIds[2] = { _player1MoveSetId, _player2MoveSetId };
+	for (int32 index = 0; index < 2; ++index)
+	{
+		FSimFighterState& fighter = _state.fighters[index];
+		fighter.positionX = startPositions[index];
+		fighter.moveSetId = moveSetIds[index];
+		fighter.health = FFixed::One();
+		fighter.characterState = EFighterSimState::Default;
+		fighter.canMove = true;
+		fighter.isGrounded = true;
+	}
+
+	const FFixed stageCenterX = FFixed::FromRaw((int32)(((int64)_player1PositionX.raw + _player2PositionX.raw) / 2));
+	_state.stageLeftX = stageCenterX - StageHalfWidth;
+	_state.stageRightX = stageCenterX + StageHalfWidth;
+
+	_state.fighters[0].isFlipped = _player2PositionX > _player1PositionX;
+	_state.fighters[1].isFlipped = _player1PositionX > _player2PositionX;
+}
+
+int32 FighterSim::Step(FSimMatchState& _state, FFighterInput _player1Input, FFighterInput _player2Input)
+{
+	++_state.frame;
+
+	FSimFighterState& player1 = _state.fighters[0];
+	FSimFighterState& player2 = _state.fighters[1];
+
+	//Fighters in hit-stop are frozen. Their previous input is kept, so anything still held when it ends registers as a press then.
+	const bool isPlayer1Frozen = player1.timers.IsRunning(EFighterTimer::HitStop);
+	const bool isPlayer2Frozen = player2.timers.IsRunning(EFighterTimer::HitStop);
+
+	if (!isPlayer1Frozen)
+	{
+		ApplyInput(player1, _player1Input);
+	}
+	if (!isPlayer2Frozen)
+	{
+		ApplyInput(player2, _player2Input);
+	}
+
+	const FFixed previousX1 = player1.positionX;
+	const FFixed previousX2 = player2.positionX;
+
+	if (!isPlayer1Frozen)
+	{
+		Move(player1, _player1Input);
+	}
+	if (!isPlayer2Frozen)
+	{
+		Move(player2, _player2Input);
+	}
+
+	//Pushback, the maximum distance, the walls and the pushboxes, all at once
+	FighterPushbox::Solve(_state, previousX1, previousX2);
+
+	//Face the opponent, but never turn around in mid-jump
+	if (FighterStateMachine::GetStateInfo(player1.characterState).canTurn)
+	{
+		player1.isFlipped = player2.positionX > player1.positionX;
+	}
+	if (FighterStateMachine::GetStateInfo(player2.characterState).canTurn)
+	{
+		player2.isFlipped = player1.positionX > player2.positionX;
+	}
+
+	const int32 numStrikes = ResolveHits(_state);
+
+	//Frozen fighters stay on the same frame of their move
+	if (!isPlayer1Frozen)
+	{
+		AdvanceMove(player1);
+	}
+	if (!isPlayer2Frozen)
+	{
+		AdvanceMove(player2);
+	}
+
+	AdvanceTimers(player1, _state.frame);
+	AdvanceTimers(player2, _state.frame);
+
+	return numStrikes;
+}
+
+void FighterSim::BuildHitboxTable(const FSimMatchState& _state, FFighterHitboxTable& _outTable)
+{
+	_outTable.Reset();
+
+	for (int32 playerIndex = 0; playerIndex < 2; ++playerIndex)
+	{
+		const FSimFighterState& fighter = _state.fighters[playerIndex];
+		const FFighterMoveTable& moveSet = FighterMoves::GetMoveSet(fighter.moveSetId);
+		_outTable.AddBodyHurtbox(playerIndex, fighter, moveSet.movement);
+
+		if (fighter.move == EFighterMove::None)
+		{
+			continue;
+		}
+
+		const FFighterMoveData& move = moveSet.GetMove(fighter.move);
+		const FFixed facing = fighter.isFlipped ? FFixed::One() : -FFixed::One();
+
+		for (int32 boxIndex = move.firstBox; boxIndex < move.firstBox + move.numBoxes; ++boxIndex)
+		{
+			const FFighterMoveBox& box = moveSet.boxes[boxIndex];
+			if (fighter.moveFrame < box.firstFrame || fighter.moveFrame > box.lastFrame || (box.type == ESimHitboxType::Strike && fighter.hasMoveConnected))
+			{
+				continue;
+			}
+
+			const FFixed centerX = fighter.positionX + facing * box.offsetX;
+			const FFixed centerZ = fighter.positionZ + box.offsetZ;
+
+			if (box.type == ESimHitboxType::Hurtbox)
+			{
+				_outTable.AddHurtbox(playerIndex, centerX, centerZ, box.halfWidth, box.halfHeight);
+			}
+			else
+			{
+				_outTable.AddAttackBox(playerIndex, box.type, centerX, centerZ, box.halfWidth, box.halfHeight,
+					move.damage, move.hitstunFrames, move.blockstunFrames, move.pushback, boxIndex);
+			}
+		}
+	}
+}
+
+void FighterSim::ApplyHit(FSimMatchState& _state, int32 _defenderIndex, FFixed _damage, int32 _hitstunFrames, int32 _blockstunFrames, FFixed _pushback)
+{
+	check(_defenderIndex == 0 || _defenderIndex == 1);
+
+	FSimFighterState& defender = _state.fighters[_defenderIndex];
+	FSimFighterState& attacker = _state.fighters[1 - _defenderIndex];
+
+	if (!FighterStateMachine::GetStateInfo(defender.characterState).isBlocking)
+	{
+		defender.health -= _damage;
+		AddSuperMeter(defender, _damage * DefenderMeterGain);
+
+		if (_hitstunFrames > 0)
+		{
+			//Getting hit interrupts whatever the defender was doing, a launch included
+			BeginStun(defender, EFighterTimer::Hitstun, _hitstunFrames, _state.frame);
+			defender.timers.Stop(EFighterTimer::Launch);
+			DispatchEvent(defender, EFighterEvent::Hit);
+			EndMove(defender);
+		}
+
+		attacker.hasLandedHit = true;
+
+		const FFixed meterGain = attacker.move != EFighterMove::None ? FighterMoves::GetMoveSet(attacker.moveSetId).GetMove(attacker.move).meterGain : AttackerMeterGain;
+		AddSuperMeter(attacker, _damage * meterGain);
+	}
+	else
+	{
+		defender.health -= _damage * BlockedDamageScale;
+
+		if (_blockstunFrames > 0)
+		{
+			BeginStun(defender, EFighterTimer::Blockstun, _blockstunFrames, _state.frame);
+			DispatchEvent(defender, EFighterEvent::BlockedHit);
+		}
+
+		attacker.hasLandedHit = false;
+	}
+
+	if (defender.health < FFixed::Zero())
+	{
+		defender.health = FFixed::Zero();
+	}
+
+	BeginHitStop(defender, _state.frame);
+	BeginHitStop(attacker, _state.frame);
+
+	FighterPushbox::StartPushback(defender, attacker.positionX, _pushback);
+}
+
+void FighterSim::Launch(FSimMatchState& _state, int32 _defenderIndex, int32 _riseFrames, FFixed _distance, int32 _launchFrames)
+{
+	check(_defenderIndex == 0 || _defenderIndex == 1);
+
+	FSimFighterState& defender = _state.fighters[_defenderIndex];
+	const FSimFighterState& attacker = _state.fighters[1 - _defenderIndex];
+	DispatchEvent(defender, EFighterEvent::Launched);
+
+	//Launched fighters cannot steer, so the whole arc is set here
+	const int32 riseFrames = FMath::Max(_riseFrames, 1);
+	const FFixed awayFromAttacker = defender.positionX >= attacker.positionX ? FFixed::One() : -FFixed::One();
+	defender.velocityX = awayFromAttacker * (_distance / FFixed::FromInt(2 * riseFrames));
+	defender.velocityZ = FighterMovement::GetVelocityForRiseFrames(FighterMoves::GetMoveSet(defender.moveSetId).movement, riseFrames);
+	defender.isGrounded = false;
+
+	//A launch replaces any stun
+	defender.timers.Stop(EFighterTimer::Hitstun);
+	defender.timers.Stop(EFighterTimer::Blockstun);
+	defender.timers.Start(EFighterTimer::Launch, FMath::Max(_launchFrames, 1), _state.frame);
+	EndMove(defender);
+}
+
+int32 FighterSim::GetStunFramesRemaining(const FSimFighterState& _fighter, int32 _frame)
+{
+	return FMath::Max(_fighter.timers.GetRemainingFrames(EFighterTimer::Hitstun, _frame), _fighter.timers.GetRemainingFrames(EFighterTimer::Blockstun, _frame));
+}
+
+void FighterSim::CollideWithProximityHitbox(FSimFighterState& _fighter)
+{
+	DispatchEvent(_fighter, _fighter.isFlipped ? EFighterEvent::ProximityFlipped : EFighterEvent::ProximityUnflipped);
+}
+
+void FighterSim::StartExceptionalAttack(FSimFighterState& _fighter)
+{
+	if (_fighter.move == EFighterMove::None)
+	{
+		return;
+	}
+
+	//The exceptional version carries on from the same frame of the move
+	const FFighterMoveTable& moveSet = FighterMoves::GetMoveSet(_fighter.moveSetId);
+	const EFighterMove exceptionalMove = moveSet.GetMove(_fighter.move).exceptionalMove;
+	if (exceptionalMove != EFighterMove::None && _fighter.superMeter >= moveSet.GetMove(exceptionalMove).meterCost)
+	{
+		_fighter.superMeter -= moveSet.GetMove(exceptionalMove).meterCost;
+		_fighter.move = exceptionalMove;
+	}
+}
+
+uint32 FighterSim::ComputeChecksum(const FSimMatchState& _state)
+{
+	//Field by field, so padding bytes never reach the hash
+	uint32 hash = 2166136261u;
+	auto mix = [&hash](int32 _value)
+	{
+		hash = (hash ^ (uint32)_value) * 16777619u;
+	};
+
+	mix(_state.frame);
+	mix(_state.stageLeftX.raw);
+	mix(_state.stageRightX.raw);
+
+	for (const FSimFighterState& fighter : _state.fighters)
+	{
+		mix(fighter.positionX.raw);
+		mix(fighter.positionZ.raw);
+		mix(fighter.velocityX.raw);
+		mix(fighter.velocityZ.raw);
+		mix(fighter.pushbackVelocityX.raw);
+		mix(fighter.pushbackFrames);
+		mix(fighter.health.raw);
+		mix(fighter.superMeter.raw);
+
+		for (uint8 slotTimers : fighter.timers.slotTimers)
+		{
+			mix(slotTimers);
+		}
+		for (int32 expiryFrame : fighter.timers.expiryFrames)
+		{
+			mix(expiryFrame);
+		}
+
+		mix(fighter.previousInput);
+		mix((int32)fighter.characterState);
+		mix(fighter.canMove);
+		mix(fighter.isFlipped);
+		mix(fighter.isGrounded);
+		mix(fighter.hasLandedHit);
+		mix(fighter.moveSetId);
+		mix((int32)fighter.move);
+		mix(fighter.moveFrame);
+		mix(fighter.hasMoveConnected);
+	}
+	return hash;
+}
@@ -0,0 +1,221 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FighterTimers.h"
+
+struct FFighterHitboxTable;
+
+/**
+ * Engine-independent match simulation.
+ *
+ * Everything in here is plain data and free functions: no UObjects, no timers and no movement components,
+ * so a match can be stepped headless (replays, bots, netcode) and every machine produces bit-identical results.
+ * The characters in the world are only a view over FSimMatchState.
+ */
+
+//Signed 16.16 fixed-point number used for all simulation math
+struct FFixed
+{
+	int32 raw;
+
+	static constexpr int32 FractionBits = 16;
+	static constexpr int32 OneRaw = 1 << FractionBits;
+
+	static constexpr FFixed FromRaw(int32 _raw) { return FFixed{ _raw }; }
+	static constexpr FFixed FromInt(int32 _value) { return FFixed{ _value * OneRaw }; }
+	static constexpr FFixed FromRatio(int32 _numerator, int32 _denominator) { return FFixed{ (int32)(((int64)_numerator * OneRaw) / _denominator) }; }
+	static constexpr FFixed Zero() { return FFixed{ 0 }; }
+	static constexpr FFixed One() { return FFixed{ OneRaw }; }
+
+	//Only for converting designer values and view data at the engine boundary, never inside the simulation
+	static FFixed FromFloat(float _value) { return FFixed{ (int32)FMath::RoundToInt(_value * (float)OneRaw) }; }
+	float ToFloat() const { return (float)raw / (float)OneRaw; }
+
+	constexpr FFixed operator+(FFixed _other) const { return FFixed{ raw + _other.raw }; }
+	constexpr FFixed operator-(FFixed _other) const { return FFixed{ raw - _other.raw }; }
+	constexpr FFixed operator-() const { return FFixed{ -raw }; }
+	constexpr FFixed operator*(FFixed _other) const { return FFixed{ (int32)(((int64)raw * _other.raw) >> FractionBits) }; }
+	constexpr FFixed operator/(FFixed _other) const { return FFixed{ (int32)(((int64)raw * OneRaw) / _other.raw) }; }
+	constexpr FFixed operator*(int32 _scalar) const { return FFixed{ raw * _scalar }; }
+
+	FFixed& operator+=(FFixed _other) { raw += _other.raw; return *this; }
+	FFixed& operator-=(FFixed _other) { raw -= _other.raw; return *this; }
+
+	constexpr bool operator==(FFixed _other) const { return raw == _other.raw; }
+	constexpr bool operator!=(FFixed _other) const { return raw != _other.raw; }
+	constexpr bool operator<(FFixed _other) const { return raw < _other.raw; }
+	constexpr bool operator<=(FFixed _other) const { return raw <= _other.raw; }
+	constexpr bool operator>(FFixed _other) const { return raw > _other.raw; }
+	constexpr bool operator>=(FFixed _other) const { return raw >= _other.raw; }
+
+	static constexpr FFixed Abs(FFixed _value) { return _value.raw < 0 ? -_value : _value; }
+	static constexpr FFixed Min(FFixed _a, FFixed _b) { return _a.raw < _b.raw ? _a : _b; }
+	static constexpr FFixed Max(FFixed _a, FFixed _b) { return _a.raw > _b.raw ? _a : _b; }
+	static constexpr FFixed Clamp(FFixed _value, FFixed _min, FFixed _max) { return Min(Max(_value, _min), _max); }
+};
+
+//One frame of input from one player, as a bitmask of EFighterInput values
+typedef uint16 FFighterInput;
+
+namespace EFighterInput
+{
+	enum Type : uint16
+	{
+		None		= 0,
+		Left		= 1 << 0,
+		Right		= 1 << 1,
+		Up			= 1 << 2,
+		Down		= 1 << 3,
+		Attack1		= 1 << 4,
+		Attack2		= 1 << 5,
+		Attack3		= 1 << 6,
+		Attack4		= 1 << 7,
+		Block		= 1 << 8,
+		Exceptional	= 1 << 9,
+
+		Directions	= Left | Right | Up | Down,
+		Attacks		= Attack1 | Attack2 | Attack3 | Attack4,
+		All			= Directions | Attacks | Block | Exceptional
+	};
+}
+
+//Mirrors ECharacterState value for value so the simulation does not depend on the reflected enum. Changes go through FighterStateMachine.
+enum class EFighterSimState : uint8
+{
+	Default,
+	MovingRight,
+	MovingLeft,
+	Jumping,
+	Stunned,
+	Blocking,
+	Crouching,
+	Launched,
+
+	//Only in the simulation: blocking and stuck in blockstun. Shown to blueprints as Blocking.
+	BlockStunned,
+
+	Count
+};
+
+//Mirrors EFighterMoveId value for value. The frame data of each move is in FighterMoves.h.
+enum class EFighterMove : uint8
+{
+	None,
+	Light,
+	Medium,
+	Heavy,
+	Super,
+	LightEx,
+	MediumEx,
+	HeavyEx,
+
+	Count
+};
+
+//The complete gameplay state of one fighter
+struct FSimFighterState
+{
+	//Position along the stage (world Y) and height above the ground plane
+	FFixed positionX;
+	FFixed positionZ;
+
+	//Velocity in units per frame
+	FFixed velocityX;
+	FFixed velocityZ;
+
+	//Hit pushback still to come, see FighterPushbox
+	FFixed pushbackVelocityX;
+	int32 pushbackFrames;
+
+	//1 is full health
+	FFixed health;
+
+	//1 is a full super meter
+	FFixed superMeter;
+
+	//Hitstun, blockstun, launch and hit-stop, counted in frames
+	FFighterTimerWheel timers;
+
+	//The input from the previous frame, used to find presses and releases
+	FFighterInput previousInput;
+
+	EFighterSimState characterState;
+
+	bool canMove;
+	bool isFlipped;
+	bool isGrounded;
+	bool hasLandedHit;
+
+	//Which FighterMoves move set the fighter's attacks come from
+	uint8 moveSetId;
+
+	//The attack being done, and how many frames into it the fighter is, from 0 on the frame it started
+	EFighterMove move;
+	int32 moveFrame;
+
+	//Has the current move's strike already connected, so its boxes cannot hit again
+	bool hasMoveConnected;
+};
+
+//The complete gameplay state of a match. Copying it is a full snapshot.
+struct FSimMatchState
+{
+	int32 frame;
+
+	//The furthest along the stage either way a fighter can go
+	FFixed stageLeftX;
+	FFixed stageRightX;
+
+	FSimFighterState fighters[2];
+};
+
+static_assert(TIsPODType<FSimMatchState>::Value, "FSimMatchState must stay plain data so it can be copied, hashed and serialized as raw bytes");
+
+namespace FighterSim
+{
+	constexpr int32 FramesPerSecond = 60;
+
+	//The maximum amount of distance that the players can be apart
+	constexpr FFixed MaxDistanceApart = FFixed::FromInt(800);
+
+	//How far the walls are either side of the middle of the fighters' starting positions
+	constexpr FFixed StageHalfWidth = FFixed::FromInt(1100);
+
+	//How far hits from outside the move data push the defender
+	constexpr FFixed DefaultPushback = FFixed::FromInt(40);
+
+	//Converts a designer value in seconds to a whole number of simulation frames
+	FIGHTERGAMEPLUGIN_API int32 SecondsToFrames(float _seconds);
+
+	//Puts both fighters on the ground at the given stage positions with full health and no meter, using the given move sets, with the walls StageHalfWidth either side of them
+	FIGHTERGAMEPLUGIN_API void ResetMatch(FSimMatchState& _state, FFixed _player1PositionX, FFixed _player2PositionX, uint8 _player1MoveSetId = 0, uint8 _player2MoveSetId = 0);
+
+	//Advances the match by exactly one frame, hits included. Returns the number of fighters whose strike connected.
+	FIGHTERGAMEPLUGIN_API int32 Step(FSimMatchState& _state, FFighterInput _player1Input, FFighterInput _player2Input);
+
+	//Fills _outTable with both fighters' bodies and the boxes of the moves they are doing
+	FIGHTERGAMEPLUGIN_API void BuildHitboxTable(const FSimMatchState& _state, FFighterHitboxTable& _outTable);
+
+	//Damages fighter _defenderIndex with a hit from the other fighter, freezes both fighters for the hit-stop, then pushes the defender _pushback away
+	FIGHTERGAMEPLUGIN_API void ApplyHit(FSimMatchState& _state, int32 _defenderIndex, FFixed _damage, int32 _hitstunFrames, int32 _blockstunFrames, FFixed _pushback);
+
+	/**
+	 * Knocks fighter _defenderIndex into the air, to peak _riseFrames later and land _riseFrames after that _distance further
+	 * from the attacker. They cannot act until they land or _launchFrames pass, whichever is later.
+	 */
+	FIGHTERGAMEPLUGIN_API void Launch(FSimMatchState& _state, int32 _defenderIndex, int32 _riseFrames, FFixed _distance, int32 _launchFrames);
+
+	//Frames left in the fighter's hitstun or blockstun
+	FIGHTERGAMEPLUGIN_API int32 GetStunFramesRemaining(const FSimFighterState& _fighter, int32 _frame);
+
+	//Blocks automatically if the fighter is holding away from the opponent
+	FIGHTERGAMEPLUGIN_API void CollideWithProximityHitbox(FSimFighterState& _fighter);
+
+	//Spends meter to turn the move the fighter is doing into its exceptional version, if it has one
+	FIGHTERGAMEPLUGIN_API void StartExceptionalAttack(FSimFighterState& _fighter);
+
+	//FNV-1a hash of every field of the state, for comparing two simulations of the same frame
+	FIGHTERGAMEPLUGIN_API uint32 ComputeChecksum(const FSimMatchState& _state);
+}
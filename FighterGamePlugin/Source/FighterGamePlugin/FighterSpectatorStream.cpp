@@ -0,0 +1,810 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FighterSpectatorStream.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/Paths.h"
+#include "Serialization/BitReader.h"
+#include "FighterGamePlugin.h"
+
+DECLARE_CYCLE_STAT(TEXT("Spectator Broadcast"), STAT_FighterSpectatorBroadcast, STATGROUP_Fighter);
+
+namespace
+{
+	int32 ShowSpectatorView = 0;
+
+	FAutoConsoleVariableRef ShowSpectatorViewVariable(
+		TEXT("Fighter.ShowSpectatorView"),
+		ShowSpectatorView,
+		TEXT("Draws what the first local spectator of the spectator stream sees over the fight, with its bandwidth. 0 is off."));
+
+	//The distance back to a delta packet's baseline, which is always inside the history
+	constexpr int32 BaselineAgeBits = 6;
+	static_assert((1 << BaselineAgeBits) == FighterSpectator::HistoryCapacity, "BaselineAgeBits must cover the history");
+
+	//Changes are mostly small, so signed values are sent in the narrowest of these that fits, after two bits saying which
+	constexpr int32 SignedWidths[4] = { 6, 10, 16, 32 };
+
+	//What keyframes are coded against: both fighters at 0 with nothing going on
+	const FFighterSpectatorFrame& GetEmptyFrame()
+	{
+		static const FFighterSpectatorFrame emptyFrame = {};
+		return emptyFrame;
+	}
+
+	void WriteBits(FBitWriter& _writer, uint32 _value, int32 _numBits)
+	{
+		_writer.SerializeBits(&_value, _numBits);
+	}
+
+	uint32 ReadBits(FBitReader& _reader, int32 _numBits)
+	{
+		uint32 value = 0;
+		_reader.SerializeBits(&value, _numBits);
+		return value;
+	}
+
+	void WriteSigned(FBitWriter& _writer, int32 _value)
+	{
+		//Zigzag, so small negative numbers are small too
+		const uint32 zigzag = ((uint32)_value << 1) ^ (uint32)(_value >> 31);
+
+		int32 widthIndex = 0;
+		while (widthIndex < (int32)UE_ARRAY_COUNT(SignedWidths) - 1 && (zigzag >> SignedWidths[widthIndex]) != 0)
+		{
+			++widthIndex;
+		}
+
+		WriteBits(_writer, widthIndex, 2);
+		WriteBits(_writer, zigzag, SignedWidths[widthIndex]);
+	}
+
+	int32 ReadSigned(FBitReader& _reader)
+	{
+		const uint32 zigzag = ReadBits(_reader, SignedWidths[ReadBits(_reader, 2)]);
+		return (int32)(zigzag >> 1) ^ -(int32)(zigzag & 1);
+	}
+
+	//A bit saying whether the value changed from the baseline, then the change
+	void WriteSignedChange(FBitWriter& _writer, int32 _value, int32 _baseline)
+	{
+		const bool hasChanged = _value != _baseline;
+		_writer.WriteBit(hasChanged);
+		if (hasChanged)
+		{
+			WriteSigned(_writer, (int32)((uint32)_value - (uint32)_baseline));
+		}
+	}
+
+	int32 ReadSignedChange(FBitReader& _reader, int32 _baseline)
+	{
+		return _reader.ReadBit() ? (int32)((uint32)_baseline + (uint32)ReadSigned(_reader)) : _baseline;
+	}
+
+	//A bit saying whether the value changed from the baseline, then the new value
+	void WriteValueChange(FBitWriter& _writer, uint32 _value, uint32 _baseline, int32 _numBits)
+	{
+		const bool hasChanged = _value != _baseline;
+		_writer.WriteBit(hasChanged);
+		if (hasChanged)
+		{
+			WriteBits(_writer, _value, _numBits);
+		}
+	}
+
+	uint32 ReadValueChange(FBitReader& _reader, uint32 _baseline, int32 _numBits)
+	{
+		return _reader.ReadBit() ? ReadBits(_reader, _numBits) : _baseline;
+	}
+
+	//A move carries on counting frames from the baseline, so only its start costs anything
+	int32 PredictMoveFrame(const FFighterSpectatorFighter& _baseline, EFighterMove _move, int32 _baselineAge)
+	{
+		return (_move != EFighterMove::None && _move == _baseline.move) ? _baseline.moveFrame + _baselineAge : 0;
+	}
+
+	void WriteFighter(FBitWriter& _writer, const FFighterSpectatorFighter& _fighter, const FFighterSpectatorFighter& _baseline, int32 _baselineAge)
+	{
+		WriteSignedChange(_writer, _fighter.positionX, _baseline.positionX);
+		WriteSignedChange(_writer, _fighter.positionZ, _baseline.positionZ);
+		WriteValueChange(_writer, _fighter.health, _baseline.health, FighterSpectator::MeterBits);
+		WriteValueChange(_writer, _fighter.superMeter, _baseline.superMeter, FighterSpectator::MeterBits);
+		WriteValueChange(_writer, (uint32)_fighter.characterState, (uint32)_baseline.characterState, FighterSpectator::CharacterStateBits);
+		WriteValueChange(_writer, (uint32)_fighter.move, (uint32)_baseline.move, FighterSpectator::MoveBits);
+		WriteSignedChange(_writer, _fighter.moveFrame, PredictMoveFrame(_baseline, _fighter.move, _baselineAge));
+		_writer.WriteBit(_fighter.isFlipped);
+	}
+
+	void ReadFighter(FBitReader& _reader, FFighterSpectatorFighter& _outFighter, const FFighterSpectatorFighter& _baseline, int32 _baselineAge)
+	{
+		_outFighter.positionX = ReadSignedChange(_reader, _baseline.positionX);
+		_outFighter.positionZ = ReadSignedChange(_reader, _baseline.positionZ);
+		_outFighter.health = (int32)ReadValueChange(_reader, _baseline.health, FighterSpectator::MeterBits);
+		_outFighter.superMeter = (int32)ReadValueChange(_reader, _baseline.superMeter, FighterSpectator::MeterBits);
+		_outFighter.characterState = (EFighterSimState)ReadValueChange(_reader, (uint32)_baseline.characterState, FighterSpectator::CharacterStateBits);
+		_outFighter.move = (EFighterMove)ReadValueChange(_reader, (uint32)_baseline.move, FighterSpectator::MoveBits);
+		_outFighter.moveFrame = ReadSignedChange(_reader, PredictMoveFrame(_baseline, _outFighter.move, _baselineAge));
+		_outFighter.isFlipped = _reader.ReadBit() != 0;
+	}
+
+	/**
+	 * A keyframe bit, then for keyframes the whole frame number, and for the rest the frame's low 16 bits and how far back the
+	 * baseline is. The receiver has the baseline, so its newest frame is never more than a history away from the one sent.
+	 */
+	void WritePacket(FBitWriter& _writer, const FFighterSpectatorFrame& _frame, const FFighterSpectatorFrame* _baseline)
+	{
+		_writer.WriteBit(_baseline == nullptr);
+
+		int32 baselineAge = 0;
+		if (_baseline)
+		{
+			baselineAge = _frame.frame - _baseline->frame;
+			check(baselineAge > 0 && baselineAge < FighterSpectator::HistoryCapacity);
+
+			WriteBits(_writer, (uint32)_frame.frame & 0xFFFF, 16);
+			WriteBits(_writer, baselineAge, BaselineAgeBits);
+		}
+		else
+		{
+			WriteBits(_writer, (uint32)_frame.frame, 32);
+		}
+
+		const FFighterSpectatorFrame& baseline = _baseline ? *_baseline : GetEmptyFrame();
+		for (int32 playerIndex = 0; playerIndex < 2; ++playerIndex)
+		{
+			WriteFighter(_writer, _frame.fighters[playerIndex], baseline.fighters[playerIndex], baselineAge);
+		}
+	}
+
+	int32 QuantizePosition(FFixed _value)
+	{
+		constexpr int32 Shift = FFixed::FractionBits - FighterSpectator::PositionFractionBits;
+		return (_value.raw + (1 << (Shift - 1))) >> Shift;
+	}
+
+	int32 QuantizeMeter(FFixed _value)
+	{
+		return FMath::Clamp((int32)(((int64)_value.raw * FighterSpectator::MeterSteps + FFixed::OneRaw / 2) >> FFixed::FractionBits), 0, FighterSpectator::MeterSteps);
+	}
+}
+
+FString FighterSpectator::GetStreamPath(const FString& _fileName)
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Spectator"), _fileName + TEXT(".fgspec"));
+}
+
+void FighterSpectator::Quantize(const FSimMatchState& _state, FFighterSpectatorFrame& _outFrame)
+{
+	_outFrame.frame = _state.frame;
+
+	for (int32 playerIndex = 0; playerIndex < 2; ++playerIndex)
+	{
+		const FSimFighterState& fighter = _state.fighters[playerIndex];
+		FFighterSpectatorFighter& outFighter = _outFrame.fighters[playerIndex];
+
+		outFighter.positionX = QuantizePosition(fighter.positionX);
+		outFighter.positionZ = QuantizePosition(fighter.positionZ);
+		outFighter.health = QuantizeMeter(fighter.health);
+		outFighter.superMeter = QuantizeMeter(fighter.superMeter);
+		outFighter.characterState = fighter.characterState;
+		outFighter.move = fighter.move;
+		outFighter.moveFrame = fighter.moveFrame;
+		outFighter.isFlipped = fighter.isFlipped;
+	}
+}
+
+FFighterSpectatorServer::FFighterSpectatorServer(const FFighterSpectatorSettings& _settings)
+	: settings(_settings)
+	, writer(FighterSpectator::MaxPacketBytes * 8)
+{
+	//Spectators need a few sent frames inside the history to have an acknowledged one to code against
+	settings.sendIntervalFrames = FMath::Clamp(settings.sendIntervalFrames, 1, FighterSpectator::HistoryCapacity / 4);
+	settings.keyframeIntervalFrames = FMath::Max(settings.keyframeIntervalFrames, FighterSpectator::HistoryCapacity);
+
+	for (FFighterSpectatorFrame& frame : history)
+	{
+		frame.frame = INDEX_NONE;
+	}
+}
+
+IFighterSpectatorConnection* FFighterSpectatorServer::AddSpectator(TUniquePtr<IFighterSpectatorConnection>&& _connection)
+{
+	FSpectator& spectator = spectators.AddDefaulted_GetRef();
+	spectator.connection = MoveTemp(_connection);
+	spectator.lastKeyframeFrame = INDEX_NONE;
+	FMemory::Memzero(spectator.stats);
+	return spectator.connection.Get();
+}
+
+void FFighterSpectatorServer::Broadcast(const FSimMatchState& _state, double _nowSeconds)
+{
+	FIGHTER_SCOPE_CYCLE_COUNTER(SpectatorBroadcast);
+
+	for (FSpectator& spectator : spectators)
+	{
+		spectator.connection->Tick(_nowSeconds);
+		++spectator.stats.numFrames;
+	}
+
+	if (_state.frame % settings.sendIntervalFrames != 0)
+	{
+		return;
+	}
+
+	FFighterSpectatorFrame& frame = history[_state.frame & (FighterSpectator::HistoryCapacity - 1)];
+	FighterSpectator::Quantize(_state, frame);
+	codedPackets.Reset();
+
+	int32 numBytesSent = 0;
+	for (FSpectator& spectator : spectators)
+	{
+		//Coded against the newest frame the spectator has, while the history still has it too
+		int32 baselineFrame = spectator.connection->GetAckedFrame();
+		const bool isKeyframeDue = spectator.lastKeyframeFrame == INDEX_NONE || _state.frame - spectator.lastKeyframeFrame >= settings.keyframeIntervalFrames;
+		const bool hasBaseline = baselineFrame != INDEX_NONE && baselineFrame < _state.frame && _state.frame - baselineFrame < FighterSpectator::HistoryCapacity
+			&& history[baselineFrame & (FighterSpectator::HistoryCapacity - 1)].frame == baselineFrame;
+
+		if (isKeyframeDue || !hasBaseline)
+		{
+			baselineFrame = INDEX_NONE;
+			spectator.lastKeyframeFrame = _state.frame;
+			++spectator.stats.numKeyframes;
+		}
+
+		const FCodedPacket& packet = GetPacket(frame, baselineFrame);
+		spectator.connection->SendPacket(_state.frame, packet.data, packet.numBytes);
+
+		//Every transport frames a packet with its size
+		++spectator.stats.numPackets;
+		spectator.stats.numBytes += packet.numBytes + 1;
+		numBytesSent += packet.numBytes + 1;
+	}
+
+	FIGHTER_ADD_COUNTER(SpectatorBytesSent, numBytesSent);
+}
+
+const FFighterSpectatorServer::FCodedPacket& FFighterSpectatorServer::GetPacket(const FFighterSpectatorFrame& _frame, int32 _baselineFrame)
+{
+	for (const FCodedPacket& codedPacket : codedPackets)
+	{
+		if (codedPacket.baselineFrame == _baselineFrame)
+		{
+			return codedPacket;
+		}
+	}
+
+	writer.Reset();
+	WritePacket(writer, _frame, _baselineFrame == INDEX_NONE ? nullptr : &history[_baselineFrame & (FighterSpectator::HistoryCapacity - 1)]);
+	check(!writer.IsError());
+
+	FCodedPacket& codedPacket = codedPackets.AddDefaulted_GetRef();
+	codedPacket.baselineFrame = _baselineFrame;
+	codedPacket.numBytes = (int32)writer.GetNumBytes();
+	FMemory::Memcpy(codedPacket.data, writer.GetData(), codedPacket.numBytes);
+	return codedPacket;
+}
+
+void FFighterSpectatorServer::LogStats() const
+{
+	for (int32 spectatorIndex = 0; spectatorIndex < spectators.Num(); ++spectatorIndex)
+	{
+		const FFighterSpectatorStats& stats = spectators[spectatorIndex].stats;
+		const float bytesPerSecond = stats.GetBytesPerSecond();
+
+		if (bytesPerSecond > FighterSpectator::BudgetBytesPerSecond)
+		{
+			UE_LOG(LogFighter, Warning, TEXT("Spectator %d: %.0f bytes/s is over the %d bytes/s budget (%d packets, %d keyframes, %lld bytes)"),
+				spectatorIndex, bytesPerSecond, FighterSpectator::BudgetBytesPerSecond, stats.numPackets, stats.numKeyframes, stats.numBytes);
+		}
+		else
+		{
+			UE_LOG(LogFighter, Log, TEXT("Spectator %d: %.0f bytes/s (%d packets, %d keyframes, %lld bytes)"),
+				spectatorIndex, bytesPerSecond, stats.numPackets, stats.numKeyframes, stats.numBytes);
+		}
+	}
+}
+
+FFighterSpectatorViewer::FFighterSpectatorViewer(float _interpolationDelayFrames)
+	: interpolationDelayFrames(_interpolationDelayFrames)
+	, newestFrame(INDEX_NONE)
+	, isPlaying(false)
+	, playbackFrame(0.0)
+{
+	for (FFighterSpectatorFrame& frame : history)
+	{
+		frame.frame = INDEX_NONE;
+	}
+}
+
+bool FFighterSpectatorViewer::IsDisplayEnabled()
+{
+	return ShowSpectatorView != 0;
+}
+
+bool FFighterSpectatorViewer::ReceivePacket(const uint8* _data, int32 _numBytes)
+{
+	FBitReader reader(const_cast<uint8*>(_data), (int64)_numBytes * 8);
+
+	FFighterSpectatorFrame frame;
+
+	const FFighterSpectatorFrame* baseline = &GetEmptyFrame();
+	int32 baselineAge = 0;
+
+	if (reader.ReadBit())
+	{
+		frame.frame = (int32)ReadBits(reader, 32);
+	}
+	else
+	{
+		if (newestFrame == INDEX_NONE)
+		{
+			return false;
+		}
+
+		const uint32 frameLowBits = ReadBits(reader, 16);
+		frame.frame = newestFrame + (int16)(uint16)(frameLowBits - (uint32)newestFrame);
+		baselineAge = (int32)ReadBits(reader, BaselineAgeBits);
+
+		baseline = FindFrame(frame.frame - baselineAge);
+		if (!baseline || baselineAge == 0)
+		{
+			return false;
+		}
+	}
+
+	for (int32 playerIndex = 0; playerIndex < 2; ++playerIndex)
+	{
+		ReadFighter(reader, frame.fighters[playerIndex], baseline->fighters[playerIndex], baselineAge);
+	}
+
+	if (reader.IsError() || frame.frame < 0)
+	{
+		return false;
+	}
+
+	//Jitter can deliver a frame after newer ones, which is still worth keeping to interpolate through
+	FFighterSpectatorFrame& slot = history[frame.frame & (FighterSpectator::HistoryCapacity - 1)];
+	if (slot.frame < frame.frame)
+	{
+		slot = frame;
+	}
+	newestFrame = FMath::Max(newestFrame, frame.frame);
+	return true;
+}
+
+const FFighterSpectatorFrame* FFighterSpectatorViewer::FindFrame(int32 _frame) const
+{
+	if (_frame < 0)
+	{
+		return nullptr;
+	}
+
+	const FFighterSpectatorFrame& frame = history[_frame & (FighterSpectator::HistoryCapacity - 1)];
+	return frame.frame == _frame ? &frame : nullptr;
+}
+
+void FFighterSpectatorViewer::Advance(float _deltaSeconds)
+{
+	if (newestFrame == INDEX_NONE)
+	{
+		return;
+	}
+
+	const double targetFrame = newestFrame - interpolationDelayFrames;
+
+	//On the first frame or after a stall, jump instead of fast forwarding through it
+	if (!isPlaying || FMath::Abs(targetFrame - playbackFrame) > FighterSim::FramesPerSecond / 2)
+	{
+		playbackFrame = targetFrame;
+		isPlaying = true;
+		return;
+	}
+
+	//At most 10% fast or slow, which is too little to see, to drift back to the delay
+	const double rate = 1.0 + FMath::Clamp((targetFrame - playbackFrame) * 0.05, -0.1, 0.1);
+	playbackFrame = FMath::Min(playbackFrame + _deltaSeconds * FighterSim::FramesPerSecond * rate, (double)newestFrame);
+}
+
+bool FFighterSpectatorViewer::GetView(FFighterSpectatorView& _outView) const
+{
+	if (newestFrame == INDEX_NONE)
+	{
+		return false;
+	}
+
+	const double viewFrame = isPlaying ? playbackFrame : (double)newestFrame;
+
+	//The received frames either side of the playback frame
+	const FFighterSpectatorFrame* before = nullptr;
+	const FFighterSpectatorFrame* after = nullptr;
+	for (const FFighterSpectatorFrame& frame : history)
+	{
+		if (frame.frame == INDEX_NONE)
+		{
+			continue;
+		}
+
+		if (frame.frame <= viewFrame)
+		{
+			if (!before || frame.frame > before->frame)
+			{
+				before = &frame;
+			}
+		}
+		else if (!after || frame.frame < after->frame)
+		{
+			after = &frame;
+		}
+	}
+
+	//Playback is behind everything still held, or ahead of everything received
+	if (!before)
+	{
+		before = after;
+	}
+	if (!after)
+	{
+		after = before;
+	}
+
+	const float alpha = after->frame != before->frame ? FMath::Clamp((float)((viewFrame - before->frame) / (after->frame - before->frame)), 0.0f, 1.0f) : 0.0f;
+	const int32 framesSinceBefore = FMath::Max(0, (int32)(viewFrame - before->frame));
+	const float positionScale = 1.0f / (1 << FighterSpectator::PositionFractionBits);
+
+	_outView.frame = (float)viewFrame;
+	for (int32 playerIndex = 0; playerIndex < 2; ++playerIndex)
+	{
+		const FFighterSpectatorFighter& from = before->fighters[playerIndex];
+		const FFighterSpectatorFighter& to = after->fighters[playerIndex];
+		FFighterSpectatorFighterView& fighter = _outView.fighters[playerIndex];
+
+		fighter.positionX = FMath::Lerp((float)from.positionX, (float)to.positionX, alpha) * positionScale;
+		fighter.positionZ = FMath::Lerp((float)from.positionZ, (float)to.positionZ, alpha) * positionScale;
+		fighter.health = FMath::Lerp((float)from.health, (float)to.health, alpha) / FighterSpectator::MeterSteps;
+		fighter.superMeter = FMath::Lerp((float)from.superMeter, (float)to.superMeter, alpha) / FighterSpectator::MeterSteps;
+
+		//Nothing in between two states means anything, so they change on the frame they did
+		fighter.characterState = from.characterState;
+		fighter.move = from.move;
+		fighter.moveFrame = from.move != EFighterMove::None ? from.moveFrame + framesSinceBefore : 0;
+		fighter.isFlipped = from.isFlipped;
+	}
+	return true;
+}
+
+FFighterSpectatorLoopback::FFighterSpectatorLoopback(const FRollbackLoopbackSettings& _settings)
+	: settings(_settings)
+	, random(_settings.seed)
+	, nowSeconds(0.0)
+	, ackedFrame(INDEX_NONE)
+	, numRejectedPackets(0)
+{
+	//Enough for a second of packets in both directions
+	packetsInFlight.Reserve(2 * FighterSim::FramesPerSecond);
+}
+
+void FFighterSpectatorLoopback::SendPacket(int32 _frame, const uint8* _data, int32 _numBytes)
+{
+	if (FPacketInFlight* packetInFlight = Send())
+	{
+		packetInFlight->ackFrame = INDEX_NONE;
+		packetInFlight->numBytes = _numBytes;
+		FMemory::Memcpy(packetInFlight->data, _data, _numBytes);
+	}
+}
+
+void FFighterSpectatorLoopback::Tick(double _nowSeconds)
+{
+	nowSeconds = _nowSeconds;
+	bool hasReceived = false;
+
+	for (int32 index = packetsInFlight.Num() - 1; index >= 0; --index)
+	{
+		const FPacketInFlight& packetInFlight = packetsInFlight[index];
+		if (packetInFlight.deliverySeconds > _nowSeconds)
+		{
+			continue;
+		}
+
+		if (packetInFlight.numBytes == 0)
+		{
+			ackedFrame = FMath::Max(ackedFrame, packetInFlight.ackFrame);
+		}
+		else if (viewer.ReceivePacket(packetInFlight.data, packetInFlight.numBytes))
+		{
+			hasReceived = true;
+		}
+		else
+		{
+			++numRejectedPackets;
+		}
+		packetsInFlight.RemoveAtSwap(index, 1, false);
+	}
+
+	//One acknowledgement for everything that arrived, sent back over the same network
+	if (hasReceived)
+	{
+		if (FPacketInFlight* ack = Send())
+		{
+			ack->ackFrame = viewer.GetNewestFrame();
+			ack->numBytes = 0;
+		}
+	}
+}
+
+FFighterSpectatorLoopback::FPacketInFlight* FFighterSpectatorLoopback::Send()
+{
+	if (random.FRand() * 100.0f < settings.packetLossPercent)
+	{
+		return nullptr;
+	}
+
+	const float delayMilliseconds = FMath::Max(0.0f, settings.latencyMilliseconds + random.FRandRange(-settings.jitterMilliseconds, settings.jitterMilliseconds));
+
+	FPacketInFlight& packetInFlight = packetsInFlight.AddDefaulted_GetRef();
+	packetInFlight.deliverySeconds = nowSeconds + delayMilliseconds / 1000.0f;
+	return &packetInFlight;
+}
+
+FFighterSpectatorFileConnection::FFighterSpectatorFileConnection()
+	: ackedFrame(INDEX_NONE)
+{
+}
+
+FFighterSpectatorFileConnection::~FFighterSpectatorFileConnection()
+{
+}
+
+bool FFighterSpectatorFileConnection::Open(const FString& _path)
+{
+	IPlatformFile& platformFile = FPlatformFileManager::Get().GetPlatformFile();
+	platformFile.CreateDirectoryTree(*FPaths::GetPath(_path));
+
+	//Shared for reading, so readers can follow the stream as it is written
+	file.Reset(platformFile.OpenWrite(*_path, false, true));
+	if (!file.IsValid())
+	{
+		UE_LOG(LogFighter, Warning, TEXT("Could not create spectator stream file %s"), *_path);
+		return false;
+	}
+
+	FighterSpectator::FFileHeader header;
+	header.magic = FighterSpectator::Magic;
+	header.version = FighterSpectator::Version;
+	header.framesPerSecond = FighterSim::FramesPerSecond;
+	file->Write(reinterpret_cast<const uint8*>(&header), sizeof(header));
+	return true;
+}
+
+void FFighterSpectatorFileConnection::SendPacket(int32 _frame, const uint8* _data, int32 _numBytes)
+{
+	if (!file.IsValid())
+	{
+		return;
+	}
+
+	static_assert(FighterSpectator::MaxPacketBytes <= MAX_uint8, "A packet's size must fit in its size byte");
+
+	//One unbuffered write per packet, a few dozen bytes a second, so readers never see half of one for long
+	uint8 framedPacket[FighterSpectator::MaxPacketBytes + 1];
+	framedPacket[0] = (uint8)_numBytes;
+	FMemory::Memcpy(framedPacket + 1, _data, _numBytes);
+	file->Write(framedPacket, _numBytes + 1);
+
+	//The file does not lose packets, so each one is the baseline for the next
+	ackedFrame = _frame;
+}
+
+FFighterSpectatorFileReader::FFighterSpectatorFileReader()
+	: readOffset(0)
+{
+}
+
+FFighterSpectatorFileReader::~FFighterSpectatorFileReader()
+{
+}
+
+bool FFighterSpectatorFileReader::Open(const FString& _path)
+{
+	//Shared for writing, as the stream may still be going
+	file.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*_path, true));
+	if (!file.IsValid())
+	{
+		UE_LOG(LogFighter, Warning, TEXT("Could not open spectator stream file %s"), *_path);
+		return false;
+	}
+
+	FighterSpectator::FFileHeader header;
+	if (!file->Read(reinterpret_cast<uint8*>(&header), sizeof(header)) || header.magic != FighterSpectator::Magic || header.version != FighterSpectator::Version)
+	{
+		UE_LOG(LogFighter, Warning, TEXT("%s is not a spectator stream this build can read"), *_path);
+		file.Reset();
+		return false;
+	}
+
+	readOffset = sizeof(header);
+	return true;
+}
+
+int32 FFighterSpectatorFileReader::Poll(FFighterSpectatorViewer& _viewer)
+{
+	if (!file.IsValid())
+	{
+		return 0;
+	}
+
+	const int64 fileSize = file->Size();
+	file->Seek(readOffset);
+
+	int32 numPackets = 0;
+	uint8 packet[FighterSpectator::MaxPacketBytes];
+	while (readOffset < fileSize)
+	{
+		//The writer may be part way through the last packet, which is picked up on a later poll
+		uint8 numBytes = 0;
+		if (!file->Read(&numBytes, 1) || numBytes > FighterSpectator::MaxPacketBytes || readOffset + 1 + numBytes > fileSize || !file->Read(packet, numBytes))
+		{
+			break;
+		}
+
+		_viewer.ReceivePacket(packet, numBytes);
+		readOffset += 1 + numBytes;
+		++numPackets;
+	}
+	return numPackets;
+}
+
+namespace
+{
+	bool AreFramesEqual(const FFighterSpectatorFrame& _a, const FFighterSpectatorFrame& _b)
+	{
+		if (_a.frame != _b.frame)
+		{
+			return false;
+		}
+
+		for (int32 playerIndex = 0; playerIndex < 2; ++playerIndex)
+		{
+			const FFighterSpectatorFighter& a = _a.fighters[playerIndex];
+			const FFighterSpectatorFighter& b = _b.fighters[playerIndex];
+			if (a.positionX != b.positionX || a.positionZ != b.positionZ || a.health != b.health || a.superMeter != b.superMeter
+				|| a.characterState != b.characterState || a.move != b.move || a.moveFrame != b.moveFrame || a.isFlipped != b.isFlipped)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//Streams a bot match to loopback spectators and a file followed by two readers, and checks every spectator decodes what was sent
+	void RunSpectatorStreamTest(const TArray<FString>& _args)
+	{
+		const int32 numFrames = _args.Num() > 0 ? FCString::Atoi(*_args[0]) : 3600;
+		const int32 numViewers = _args.Num() > 1 ? FCString::Atoi(*_args[1]) : 8;
+
+		FRollbackLoopbackSettings networkSettings;
+		networkSettings.latencyMilliseconds = _args.Num() > 2 ? FCString::Atof(*_args[2]) : 100.0f;
+		networkSettings.jitterMilliseconds = _args.Num() > 3 ? FCString::Atof(*_args[3]) : 30.0f;
+		networkSettings.packetLossPercent = _args.Num() > 4 ? FCString::Atof(*_args[4]) : 5.0f;
+
+		FSimMatchState state;
+		FighterSim::ResetMatch(state, FFixed::FromInt(-200), FFixed::FromInt(200));
+
+		FFighterSpectatorServer server{ FFighterSpectatorSettings() };
+
+		TArray<FFighterSpectatorLoopback*> loopbacks;
+		for (int32 viewerIndex = 0; viewerIndex < numViewers; ++viewerIndex)
+		{
+			networkSettings.seed = 42 + viewerIndex;
+			loopbacks.Add(static_cast<FFighterSpectatorLoopback*>(server.AddSpectator(MakeUnique<FFighterSpectatorLoopback>(networkSettings))));
+		}
+
+		const FString path = FighterSpectator::GetStreamPath(TEXT("SpectatorStreamTest"));
+		TUniquePtr<FFighterSpectatorFileConnection> fileConnection = MakeUnique<FFighterSpectatorFileConnection>();
+		if (!fileConnection->Open(path))
+		{
+			return;
+		}
+		server.AddSpectator(MoveTemp(fileConnection));
+
+		//Like separate processes would, the readers follow the file while it is written
+		FFighterSpectatorFileReader fileReaders[2];
+		FFighterSpectatorViewer fileViewers[2];
+		for (FFighterSpectatorFileReader& fileReader : fileReaders)
+		{
+			if (!fileReader.Open(path))
+			{
+				return;
+			}
+		}
+
+		//Every frame as it was quantized, to check what the spectators decoded against
+		TArray<FFighterSpectatorFrame> sentFrames;
+		sentFrames.SetNumZeroed(numFrames + 1);
+
+		FRandomStream botRandom(7);
+		FFighterInput botInputs[2] = { EFighterInput::None, EFighterInput::None };
+		const double frameSeconds = 1.0 / FighterSim::FramesPerSecond;
+		int32 numMismatches = 0;
+
+		for (int32 tick = 0; tick < numFrames; ++tick)
+		{
+			for (FFighterInput& botInput : botInputs)
+			{
+				if (botRandom.RandRange(0, 7) == 0)
+				{
+					botInput = (FFighterInput)botRandom.RandRange(0, EFighterInput::All);
+				}
+			}
+
+			FighterSim::Step(state, botInputs[0], botInputs[1]);
+			server.Broadcast(state, tick * frameSeconds);
+
+			if (sentFrames.IsValidIndex(state.frame))
+			{
+				FighterSpectator::Quantize(state, sentFrames[state.frame]);
+			}
+
+			auto checkNewestFrame = [&](const FFighterSpectatorViewer& _viewer)
+			{
+				const FFighterSpectatorFrame* received = _viewer.FindFrame(_viewer.GetNewestFrame());
+				if (received && (!sentFrames.IsValidIndex(received->frame) || !AreFramesEqual(*received, sentFrames[received->frame])))
+				{
+					++numMismatches;
+				}
+			};
+
+			for (FFighterSpectatorLoopback* loopback : loopbacks)
+			{
+				checkNewestFrame(loopback->GetViewer());
+			}
+			for (int32 readerIndex = 0; readerIndex < UE_ARRAY_COUNT(fileReaders); ++readerIndex)
+			{
+				fileReaders[readerIndex].Poll(fileViewers[readerIndex]);
+				checkNewestFrame(fileViewers[readerIndex]);
+			}
+		}
+
+		//A spectator that stopped receiving decodes nothing wrong, so also check they all kept up
+		int32 numBehind = 0;
+		for (FFighterSpectatorLoopback* loopback : loopbacks)
+		{
+			numBehind += loopback->GetViewer().GetNewestFrame() < state.frame - FighterSpectator::HistoryCapacity ? 1 : 0;
+		}
+		for (const FFighterSpectatorViewer& fileViewer : fileViewers)
+		{
+			numBehind += fileViewer.GetNewestFrame() < state.frame - FighterSpectator::HistoryCapacity ? 1 : 0;
+		}
+
+		UE_LOG(LogFighter, Display, TEXT("Spectator stream: %d frames to %d loopback spectators (%.0f ms latency, %.0f ms jitter, %.1f%% loss) and %s"),
+			numFrames, numViewers, networkSettings.latencyMilliseconds, networkSettings.jitterMilliseconds, networkSettings.packetLossPercent, *path);
+
+		float maxBytesPerSecond = 0.0f;
+		for (int32 spectatorIndex = 0; spectatorIndex < server.NumSpectators(); ++spectatorIndex)
+		{
+			const FFighterSpectatorStats& stats = server.GetStats(spectatorIndex);
+			const int32 numRejected = spectatorIndex < loopbacks.Num() ? loopbacks[spectatorIndex]->GetNumRejectedPackets() : 0;
+			maxBytesPerSecond = FMath::Max(maxBytesPerSecond, stats.GetBytesPerSecond());
+
+			UE_LOG(LogFighter, Display, TEXT("  Spectator %d: %.0f bytes/s, %d packets, %d keyframes, %d rejected"),
+				spectatorIndex, stats.GetBytesPerSecond(), stats.numPackets, stats.numKeyframes, numRejected);
+		}
+
+		if (numMismatches == 0 && numBehind == 0 && maxBytesPerSecond <= FighterSpectator::BudgetBytesPerSecond)
+		{
+			UE_LOG(LogFighter, Display, TEXT("  Every spectator decoded what was sent, at most %.0f of %d bytes/s"), maxBytesPerSecond, FighterSpectator::BudgetBytesPerSecond);
+		}
+		else
+		{
+			UE_LOG(LogFighter, Error, TEXT("  %d frames decoded wrong, %d spectators fell behind, at most %.0f of %d bytes/s"),
+				numMismatches, numBehind, maxBytesPerSecond, FighterSpectator::BudgetBytesPerSecond);
+		}
+	}
+
+	FAutoConsoleCommand SpectatorStreamTestCommand(
+		TEXT("Fighter.SpectatorStreamTest"),
+		TEXT("Streams a bot match to loopback spectators and a file, and checks what they decode. Arguments: [Frames=3600] [Viewers=8] [LatencyMs=100] [JitterMs=30] [LossPercent=5]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&RunSpectatorStreamTest));
+}
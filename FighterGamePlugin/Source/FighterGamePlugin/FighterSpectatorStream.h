@@ -0,0 +1,325 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/RandomStream.h"
+#include "Serialization/BitWriter.h"
+#include "FighterSimulation.h"
+#include "FighterRollback.h"
+
+class IFileHandle;
+
+/**
+ * Spectator streams carry what a viewer needs to draw the match, not the match itself: each fighter's position, state,
+ * health, meter and move, quantized and coded against a frame the spectator has acknowledged having. A field that did
+ * not change costs one bit and a fighter walking costs about a byte, so a stream stays far under BudgetBytesPerSecond.
+ * Spectators never simulate, so unlike netcode the stream carries no input and needs no determinism.
+ */
+namespace FighterSpectator
+{
+	constexpr uint32 Magic = 0x43505346; // "FSPC"
+
+	//Bump whenever the packet layout changes
+	constexpr uint16 Version = 1;
+
+	//Positions are sent in 1/16ths of a unit
+	constexpr int32 PositionFractionBits = 4;
+
+	//Health and meter are sent as 0 to MeterSteps
+	constexpr int32 MeterBits = 10;
+	constexpr int32 MeterSteps = (1 << MeterBits) - 1;
+
+	constexpr int32 CharacterStateBits = 4;
+	constexpr int32 MoveBits = 3;
+
+	//Sent frames kept on both ends to code against. Must be a power of two. A spectator whose acknowledged frame is older gets a keyframe.
+	constexpr int32 HistoryCapacity = 64;
+
+	//No packet is bigger, keyframes included
+	constexpr int32 MaxPacketBytes = 64;
+
+	constexpr int32 BudgetBytesPerSecond = 2048;
+
+	static_assert((int32)EFighterSimState::Count <= (1 << CharacterStateBits), "EFighterSimState no longer fits in CharacterStateBits");
+	static_assert((int32)EFighterMove::Count <= (1 << MoveBits), "EFighterMove no longer fits in MoveBits");
+
+	//Stream files are this header followed by packets, each after a byte holding its size
+	struct FFileHeader
+	{
+		uint32 magic;
+		uint16 version;
+		uint16 framesPerSecond;
+	};
+
+	//Spectator/<_fileName>.fgspec in the project's Saved directory
+	FIGHTERGAMEPLUGIN_API FString GetStreamPath(const FString& _fileName);
+}
+
+//One fighter as spectators see it, quantized
+struct FFighterSpectatorFighter
+{
+	//In 1/16ths of a unit
+	int32 positionX;
+	int32 positionZ;
+
+	//0 to FighterSpectator::MeterSteps
+	int32 health;
+	int32 superMeter;
+
+	EFighterSimState characterState;
+	EFighterMove move;
+	int32 moveFrame;
+	bool isFlipped;
+};
+
+struct FFighterSpectatorFrame
+{
+	//INDEX_NONE for an empty history slot
+	int32 frame;
+
+	FFighterSpectatorFighter fighters[2];
+};
+
+//One fighter as a viewer draws it, between two received frames
+struct FFighterSpectatorFighterView
+{
+	float positionX;
+	float positionZ;
+	float health;
+	float superMeter;
+
+	EFighterSimState characterState;
+	EFighterMove move;
+	int32 moveFrame;
+	bool isFlipped;
+};
+
+struct FFighterSpectatorView
+{
+	//Fractional between two simulation frames
+	float frame;
+
+	FFighterSpectatorFighterView fighters[2];
+};
+
+namespace FighterSpectator
+{
+	FIGHTERGAMEPLUGIN_API void Quantize(const FSimMatchState& _state, FFighterSpectatorFrame& _outFrame);
+}
+
+//Carries one spectator's packets
+class IFighterSpectatorConnection
+{
+public:
+	virtual ~IFighterSpectatorConnection() {}
+
+	//Sends one packet, which holds _frame
+	virtual void SendPacket(int32 _frame, const uint8* _data, int32 _numBytes) = 0;
+
+	//Delivers whatever has arrived by _nowSeconds. Called before every broadcast.
+	virtual void Tick(double _nowSeconds) {}
+
+	//The newest frame the spectator has acknowledged, or INDEX_NONE
+	virtual int32 GetAckedFrame() const = 0;
+};
+
+struct FFighterSpectatorSettings
+{
+	//Send every this many simulation frames. Viewers interpolate between them.
+	int32 sendIntervalFrames = 2;
+
+	//Send every spectator a keyframe at least this often, so file readers can start part way and spectators whose acks stop arriving recover
+	int32 keyframeIntervalFrames = 10 * FighterSim::FramesPerSecond;
+};
+
+struct FFighterSpectatorStats
+{
+	//Simulation frames broadcast while the spectator was connected
+	int32 numFrames;
+
+	int32 numPackets;
+	int32 numKeyframes;
+
+	//Packets and their size bytes
+	int64 numBytes;
+
+	float GetBytesPerSecond() const { return numFrames > 0 ? (float)numBytes * FighterSim::FramesPerSecond / numFrames : 0.0f; }
+};
+
+/**
+ * Sends the match to any number of spectators. Each sent frame is quantized once and coded once per distinct frame the
+ * spectators have acknowledged, so spectators that keep up share a packet however many of them there are.
+ */
+class FIGHTERGAMEPLUGIN_API FFighterSpectatorServer
+{
+public:
+	FFighterSpectatorServer(const FFighterSpectatorSettings& _settings);
+
+	//Starts sending to _connection, beginning with a keyframe
+	IFighterSpectatorConnection* AddSpectator(TUniquePtr<IFighterSpectatorConnection>&& _connection);
+
+	int32 NumSpectators() const { return spectators.Num(); }
+
+	IFighterSpectatorConnection* GetConnection(int32 _spectatorIndex) const { return spectators[_spectatorIndex].connection.Get(); }
+
+	const FFighterSpectatorStats& GetStats(int32 _spectatorIndex) const { return spectators[_spectatorIndex].stats; }
+
+	//Call after every simulation frame with the match as it is shown
+	void Broadcast(const FSimMatchState& _state, double _nowSeconds);
+
+	//Logs each spectator's bandwidth against FighterSpectator::BudgetBytesPerSecond
+	void LogStats() const;
+
+private:
+	struct FSpectator
+	{
+		TUniquePtr<IFighterSpectatorConnection> connection;
+		int32 lastKeyframeFrame;
+		FFighterSpectatorStats stats;
+	};
+
+	//The packets coded for the current frame, one per baseline
+	struct FCodedPacket
+	{
+		//INDEX_NONE for the keyframe
+		int32 baselineFrame;
+
+		int32 numBytes;
+		uint8 data[FighterSpectator::MaxPacketBytes];
+	};
+
+	//The packet for _frame against _baselineFrame, coding it if no other spectator needed it yet
+	const FCodedPacket& GetPacket(const FFighterSpectatorFrame& _frame, int32 _baselineFrame);
+
+	FFighterSpectatorSettings settings;
+
+	TArray<FSpectator> spectators;
+
+	//Sent frames by frame & (HistoryCapacity - 1)
+	FFighterSpectatorFrame history[FighterSpectator::HistoryCapacity];
+
+	TArray<FCodedPacket, TInlineAllocator<4>> codedPackets;
+
+	FBitWriter writer;
+};
+
+/**
+ * Decodes a spectator stream and plays it back smoothly. Playback stays interpolationDelayFrames behind the newest frame
+ * received, so there is nearly always a frame on either side of it to blend between, and runs slightly fast or slow to
+ * stay there as packets arrive early or late.
+ */
+class FIGHTERGAMEPLUGIN_API FFighterSpectatorViewer
+{
+public:
+	FFighterSpectatorViewer(float _interpolationDelayFrames = 6.0f);
+
+	//Decodes one packet. Returns false, changing nothing, if it is corrupt or coded against a frame the viewer does not have.
+	bool ReceivePacket(const uint8* _data, int32 _numBytes);
+
+	//The newest frame received, which is what the viewer acknowledges, or INDEX_NONE
+	int32 GetNewestFrame() const { return newestFrame; }
+
+	//A received frame still in the history, or null
+	const FFighterSpectatorFrame* FindFrame(int32 _frame) const;
+
+	//Moves playback on by _deltaSeconds
+	void Advance(float _deltaSeconds);
+
+	//The match at the playback frame. Returns false until a frame has arrived.
+	bool GetView(FFighterSpectatorView& _outView) const;
+
+	//Is Fighter.ShowSpectatorView on
+	static bool IsDisplayEnabled();
+
+private:
+	float interpolationDelayFrames;
+
+	//Received frames by frame & (HistoryCapacity - 1)
+	FFighterSpectatorFrame history[FighterSpectator::HistoryCapacity];
+
+	int32 newestFrame;
+
+	//Set by the first Advance after a frame arrives
+	bool isPlaying;
+	double playbackFrame;
+};
+
+/**
+ * A spectator in this process behind a simulated network, standing in for a socket. Packets and acknowledgements
+ * are delayed, jittered and lost the same way as FRollbackLoopback's.
+ */
+class FIGHTERGAMEPLUGIN_API FFighterSpectatorLoopback : public IFighterSpectatorConnection
+{
+public:
+	FFighterSpectatorLoopback(const FRollbackLoopbackSettings& _settings);
+
+	virtual void SendPacket(int32 _frame, const uint8* _data, int32 _numBytes) override;
+	virtual void Tick(double _nowSeconds) override;
+	virtual int32 GetAckedFrame() const override { return ackedFrame; }
+
+	FFighterSpectatorViewer& GetViewer() { return viewer; }
+
+	//Packets the viewer could not decode
+	int32 GetNumRejectedPackets() const { return numRejectedPackets; }
+
+private:
+	struct FPacketInFlight
+	{
+		double deliverySeconds;
+
+		//An acknowledgement on its way back to the server when numBytes is 0
+		int32 ackFrame;
+
+		int32 numBytes;
+		uint8 data[FighterSpectator::MaxPacketBytes];
+	};
+
+	//Null if the network loses it
+	FPacketInFlight* Send();
+
+	FRollbackLoopbackSettings settings;
+	FRandomStream random;
+
+	FFighterSpectatorViewer viewer;
+
+	TArray<FPacketInFlight> packetsInFlight;
+
+	double nowSeconds;
+	int32 ackedFrame;
+	int32 numRejectedPackets;
+};
+
+//Writes a stream to a file that any number of FFighterSpectatorFileReaders can follow while it is written. Everything written counts as acknowledged.
+class FIGHTERGAMEPLUGIN_API FFighterSpectatorFileConnection : public IFighterSpectatorConnection
+{
+public:
+	FFighterSpectatorFileConnection();
+	virtual ~FFighterSpectatorFileConnection();
+
+	bool Open(const FString& _path);
+
+	virtual void SendPacket(int32 _frame, const uint8* _data, int32 _numBytes) override;
+	virtual int32 GetAckedFrame() const override { return ackedFrame; }
+
+private:
+	TUniquePtr<IFileHandle> file;
+	int32 ackedFrame;
+};
+
+//Follows a stream file into a viewer, picking up packets as they are appended
+class FIGHTERGAMEPLUGIN_API FFighterSpectatorFileReader
+{
+public:
+	FFighterSpectatorFileReader();
+	~FFighterSpectatorFileReader();
+
+	bool Open(const FString& _path);
+
+	//Feeds every whole packet written since the last call to _viewer. Returns how many there were.
+	int32 Poll(FFighterSpectatorViewer& _viewer);
+
+private:
+	TUniquePtr<IFileHandle> file;
+	int64 readOffset;
+};
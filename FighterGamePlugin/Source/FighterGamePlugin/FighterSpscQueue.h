@@ -0,0 +1,72 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Fixed-capacity lock-free queue between exactly one producer thread and one consumer thread.
+ * Each side only writes its own index, so neither ever waits for the other, and nothing allocates after construction.
+ * The indices count up forever and wrap as unsigned numbers; only their difference is used.
+ */
+template<typename ElementType, int32 Capacity>
+class TFighterSpscQueue
+{
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+	TFighterSpscQueue()
+		: head(0)
+		, tail(0)
+	{
+	}
+
+	//Producer only. Returns false, and drops _element, when the queue is full.
+	bool Push(const ElementType& _element)
+	{
+		const uint32 currentTail = (uint32)tail;
+		if (currentTail - (uint32)FPlatformAtomics::AtomicRead(&head) == (uint32)Capacity)
+		{
+			return false;
+		}
+
+		elements[currentTail & (Capacity - 1)] = _element;
+
+		//Publishing the new tail after the element is written is what hands the element over
+		FPlatformAtomics::AtomicStore(&tail, (int32)(currentTail + 1));
+		return true;
+	}
+
+	//Consumer only. The oldest element, or null when the queue is empty. It stays valid until Pop.
+	const ElementType* Peek() const
+	{
+		const uint32 currentHead = (uint32)head;
+		if (currentHead == (uint32)FPlatformAtomics::AtomicRead(&tail))
+		{
+			return nullptr;
+		}
+		return &elements[currentHead & (Capacity - 1)];
+	}
+
+	//Consumer only. Removes the element Peek returned.
+	void Pop()
+	{
+		checkSlow(Peek() != nullptr);
+		FPlatformAtomics::AtomicStore(&head, (int32)((uint32)head + 1));
+	}
+
+	//Either side. Only a snapshot, as the other side may be changing it.
+	int32 Num() const
+	{
+		return (int32)((uint32)FPlatformAtomics::AtomicRead(&tail) - (uint32)FPlatformAtomics::AtomicRead(&head));
+	}
+
+private:
+	ElementType elements[Capacity];
+
+	//The next element to read. Only written by the consumer.
+	alignas(PLATFORM_CACHE_LINE_SIZE) volatile int32 head;
+
+	//The next element to write. Only written by the producer, on its own cache line so the two sides do not share one.
+	alignas(PLATFORM_CACHE_LINE_SIZE) volatile int32 tail;
+};
@@ -0,0 +1,107 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FighterStateMachine.h"
+#include "FighterGamePlugin.h"
+
+namespace
+{
+	//Written by every simulation in the process, so only ever touched through atomics
+	volatile int32 IllegalTransitionCounts[FighterStateMachine::NumStates][FighterStateMachine::NumEvents];
+
+	const TCHAR* const StateNames[] =
+	{
+		TEXT("Default"),
+		TEXT("MovingRight"),
+		TEXT("MovingLeft"),
+		TEXT("Jumping"),
+		TEXT("Stunned"),
+		TEXT("Blocking"),
+		TEXT("Crouching"),
+		TEXT("Launched"),
+		TEXT("BlockStunned")
+	};
+	static_assert(UE_ARRAY_COUNT(StateNames) == FighterStateMachine::NumStates, "Every EFighterSimState needs a name");
+
+	const TCHAR* const EventNames[] =
+	{
+		TEXT("None"),
+		TEXT("JumpPressed"),
+		TEXT("JumpReleased"),
+		TEXT("CrouchPressed"),
+		TEXT("CrouchReleased"),
+		TEXT("BlockPressed"),
+		TEXT("BlockReleased"),
+		TEXT("HoldRight"),
+		TEXT("HoldLeft"),
+		TEXT("HoldNeutral"),
+		TEXT("Landed"),
+		TEXT("Hit"),
+		TEXT("BlockedHit"),
+		TEXT("Launched"),
+		TEXT("StunEnded"),
+		TEXT("LaunchRecovered"),
+		TEXT("ProximityFlipped"),
+		TEXT("ProximityUnflipped")
+	};
+	static_assert(UE_ARRAY_COUNT(EventNames) == FighterStateMachine::NumEvents, "Every EFighterEvent needs a name");
+}
+
+void FighterStateMachine::RecordIllegalTransition(EFighterSimState _state, EFighterEvent _event)
+{
+	FPlatformAtomics::InterlockedIncrement(&IllegalTransitionCounts[(int32)_state][(int32)_event]);
+}
+
+int32 FighterStateMachine::GetIllegalTransitionCount(EFighterSimState _state, EFighterEvent _event)
+{
+	return FPlatformAtomics::AtomicRead(&IllegalTransitionCounts[(int32)_state][(int32)_event]);
+}
+
+int32 FighterStateMachine::GetTotalIllegalTransitionCount()
+{
+	int32 total = 0;
+	for (int32 stateIndex = 0; stateIndex < NumStates; ++stateIndex)
+	{
+		for (int32 eventIndex = 0; eventIndex < NumEvents; ++eventIndex)
+		{
+			total += FPlatformAtomics::AtomicRead(&IllegalTransitionCounts[stateIndex][eventIndex]);
+		}
+	}
+	return total;
+}
+
+void FighterStateMachine::ResetIllegalTransitionCounts()
+{
+	for (int32 stateIndex = 0; stateIndex < NumStates; ++stateIndex)
+	{
+		for (int32 eventIndex = 0; eventIndex < NumEvents; ++eventIndex)
+		{
+			FPlatformAtomics::InterlockedExchange(&IllegalTransitionCounts[stateIndex][eventIndex], 0);
+		}
+	}
+}
+
+void FighterStateMachine::LogIllegalTransitions()
+{
+	for (int32 stateIndex = 0; stateIndex < NumStates; ++stateIndex)
+	{
+		for (int32 eventIndex = 0; eventIndex < NumEvents; ++eventIndex)
+		{
+			const int32 count = FPlatformAtomics::AtomicRead(&IllegalTransitionCounts[stateIndex][eventIndex]);
+			if (count > 0)
+			{
+				UE_LOG(LogFighter, Warning, TEXT("Illegal transition: %s in state %s, %d times"), EventNames[eventIndex], StateNames[stateIndex], count);
+			}
+		}
+	}
+}
+
+const TCHAR* FighterStateMachine::GetStateName(EFighterSimState _state)
+{
+	return (int32)_state < NumStates ? StateNames[(int32)_state] : TEXT("Invalid");
+}
+
+const TCHAR* FighterStateMachine::GetEventName(EFighterEvent _event)
+{
+	return (int32)_event < NumEvents ? EventNames[(int32)_event] : TEXT("Invalid");
+}
@@ -0,0 +1,328 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FighterSimulation.h"
+
+/**
+ * Every change of a fighter's EFighterSimState goes through one transition table of state x event -> state + actions.
+ *
+ * The table is built at compile time and checked with static_asserts below, so its rules are tested on every build
+ * without the engine. Dispatching an event is a single lookup with no branches. Events a state has no rule for leave it
+ * as it is, which is what stops input like releasing block from cancelling a stun.
+ */
+
+//Things that can happen to a fighter. None changes nothing, so an event that did not happen can be dispatched as None instead of branched around.
+enum class EFighterEvent : uint8
+{
+	None,
+
+	JumpPressed,
+	JumpReleased,
+	CrouchPressed,
+	CrouchReleased,
+	BlockPressed,
+	BlockReleased,
+
+	//One of these is dispatched every frame from the held direction
+	HoldRight,
+	HoldLeft,
+	HoldNeutral,
+
+	Landed,
+
+	//A hit with hitstun, and a blocked hit with blockstun
+	Hit,
+	BlockedHit,
+	Launched,
+
+	//Hitstun or blockstun ran out
+	StunEnded,
+
+	//The launch timer ran out with the fighter on the ground, or the fighter landed after it ran out
+	LaunchRecovered,
+
+	//An opponent's proximity box touched the fighter, with their model flipped or not
+	ProximityFlipped,
+	ProximityUnflipped,
+
+	Count
+};
+
+//Side effects of a transition, as bits
+namespace EFighterAction
+{
+	enum Type : uint8
+	{
+		None	= 0,
+
+		//Leave the ground, if on it
+		Jump	= 1 << 0
+	};
+}
+
+struct FFighterTransition
+{
+	EFighterSimState nextState;
+	uint8 actions;
+
+	//The event should never reach this state. It is ignored, and counted in development builds.
+	bool isIllegal;
+};
+
+//Fixed facts about each state
+struct FFighterStateInfo
+{
+	//Can the fighter act, or are they stuck until a timer or landing lets them go
+	bool canMove;
+
+	//Are hits against the fighter blocked
+	bool isBlocking;
+
+	//Does the fighter turn to face the opponent
+	bool canTurn;
+};
+
+#ifndef FIGHTER_COUNT_ILLEGAL_TRANSITIONS
+#define FIGHTER_COUNT_ILLEGAL_TRANSITIONS !UE_BUILD_SHIPPING
+#endif
+
+namespace FighterStateMachine
+{
+	constexpr int32 NumStates = (int32)EFighterSimState::Count;
+	constexpr int32 NumEvents = (int32)EFighterEvent::Count;
+
+	struct FTransitionTable
+	{
+		FFighterTransition transitions[NumStates][NumEvents];
+		FFighterStateInfo states[NumStates];
+	};
+
+	constexpr bool IsFree(EFighterSimState _state)
+	{
+		return _state == EFighterSimState::Default || _state == EFighterSimState::MovingRight || _state == EFighterSimState::MovingLeft;
+	}
+
+	constexpr bool IsStuck(EFighterSimState _state)
+	{
+		return _state == EFighterSimState::Stunned || _state == EFighterSimState::BlockStunned || _state == EFighterSimState::Launched;
+	}
+
+	constexpr void SetTransition(FTransitionTable& _table, EFighterSimState _state, EFighterEvent _event, EFighterSimState _nextState, uint8 _actions = EFighterAction::None)
+	{
+		_table.transitions[(int32)_state][(int32)_event] = { _nextState, _actions, false };
+	}
+
+	constexpr void ForbidTransition(FTransitionTable& _table, EFighterSimState _state, EFighterEvent _event)
+	{
+		_table.transitions[(int32)_state][(int32)_event].isIllegal = true;
+	}
+
+	constexpr FTransitionTable BuildTransitionTable()
+	{
+		FTransitionTable table = {};
+
+		for (int32 stateIndex = 0; stateIndex < NumStates; ++stateIndex)
+		{
+			const EFighterSimState state = (EFighterSimState)stateIndex;
+
+			table.states[stateIndex].canMove = !IsStuck(state);
+			table.states[stateIndex].isBlocking = state == EFighterSimState::Blocking || state == EFighterSimState::BlockStunned;
+			table.states[stateIndex].canTurn = state != EFighterSimState::Jumping;
+
+			//By default every event leaves the state alone
+			for (int32 eventIndex = 0; eventIndex < NumEvents; ++eventIndex)
+			{
+				table.transitions[stateIndex][eventIndex] = { state, EFighterAction::None, false };
+			}
+
+			//Anyone can be hit or launched
+			SetTransition(table, state, EFighterEvent::Hit, EFighterSimState::Stunned);
+			SetTransition(table, state, EFighterEvent::Launched, EFighterSimState::Launched);
+
+			if (!IsStuck(state))
+			{
+				SetTransition(table, state, EFighterEvent::JumpPressed, EFighterSimState::Jumping, EFighterAction::Jump);
+			}
+
+			if (IsFree(state) || state == EFighterSimState::Blocking)
+			{
+				SetTransition(table, state, EFighterEvent::CrouchPressed, EFighterSimState::Crouching);
+			}
+
+			//Not in the air, where blocking would change the fighter's state and facing mid-jump
+			if (IsFree(state) || state == EFighterSimState::Crouching)
+			{
+				SetTransition(table, state, EFighterEvent::BlockPressed, EFighterSimState::Blocking);
+			}
+
+			if (IsFree(state))
+			{
+				SetTransition(table, state, EFighterEvent::HoldRight, EFighterSimState::MovingRight);
+				SetTransition(table, state, EFighterEvent::HoldLeft, EFighterSimState::MovingLeft);
+				SetTransition(table, state, EFighterEvent::HoldNeutral, EFighterSimState::Default);
+			}
+
+			//Releasing a button only ends what that button started
+			if (state == EFighterSimState::Crouching)
+			{
+				SetTransition(table, state, EFighterEvent::CrouchReleased, EFighterSimState::Default);
+			}
+			if (state == EFighterSimState::Blocking)
+			{
+				SetTransition(table, state, EFighterEvent::BlockReleased, EFighterSimState::Default);
+			}
+
+			if (state == EFighterSimState::Jumping)
+			{
+				SetTransition(table, state, EFighterEvent::Landed, EFighterSimState::Default);
+			}
+
+			if (state == EFighterSimState::Blocking || state == EFighterSimState::BlockStunned)
+			{
+				SetTransition(table, state, EFighterEvent::BlockedHit, EFighterSimState::BlockStunned);
+			}
+			else
+			{
+				ForbidTransition(table, state, EFighterEvent::BlockedHit);
+			}
+
+			if (state == EFighterSimState::Stunned || state == EFighterSimState::BlockStunned)
+			{
+				SetTransition(table, state, EFighterEvent::StunEnded, EFighterSimState::Default);
+			}
+			else
+			{
+				ForbidTransition(table, state, EFighterEvent::StunEnded);
+			}
+
+			if (state == EFighterSimState::Launched)
+			{
+				SetTransition(table, state, EFighterEvent::LaunchRecovered, EFighterSimState::Default);
+			}
+			else
+			{
+				ForbidTransition(table, state, EFighterEvent::LaunchRecovered);
+			}
+
+			//Walking back from an attack that is about to land blocks it
+			if (state == EFighterSimState::MovingRight)
+			{
+				SetTransition(table, state, EFighterEvent::ProximityFlipped, EFighterSimState::Blocking);
+			}
+			if (state == EFighterSimState::MovingLeft)
+			{
+				SetTransition(table, state, EFighterEvent::ProximityUnflipped, EFighterSimState::Blocking);
+			}
+		}
+
+		return table;
+	}
+
+	constexpr FTransitionTable TransitionTable = BuildTransitionTable();
+
+	constexpr const FFighterTransition& GetTransition(EFighterSimState _state, EFighterEvent _event)
+	{
+		return TransitionTable.transitions[(int32)_state][(int32)_event];
+	}
+
+	constexpr const FFighterStateInfo& GetStateInfo(EFighterSimState _state)
+	{
+		return TransitionTable.states[(int32)_state];
+	}
+
+	//_event if _condition holds, otherwise None, without branching
+	constexpr EFighterEvent EventIf(bool _condition, EFighterEvent _event)
+	{
+		return (EFighterEvent)((uint8)_event * (uint8)_condition);
+	}
+
+	FIGHTERGAMEPLUGIN_API void RecordIllegalTransition(EFighterSimState _state, EFighterEvent _event);
+
+	//Applies _event to the fighter's state and returns the actions the transition asks for
+	FORCEINLINE uint8 Dispatch(FSimFighterState& _fighter, EFighterEvent _event)
+	{
+		const FFighterTransition& transition = GetTransition(_fighter.characterState, _event);
+
+#if FIGHTER_COUNT_ILLEGAL_TRANSITIONS
+		if (UNLIKELY(transition.isIllegal))
+		{
+			RecordIllegalTransition(_fighter.characterState, _event);
+		}
+#endif
+
+		_fighter.characterState = transition.nextState;
+		_fighter.canMove = GetStateInfo(transition.nextState).canMove;
+		return transition.actions;
+	}
+
+	//Illegal transitions seen since the last reset, across every simulation in the process. Always 0 in shipping builds.
+	FIGHTERGAMEPLUGIN_API int32 GetIllegalTransitionCount(EFighterSimState _state, EFighterEvent _event);
+	FIGHTERGAMEPLUGIN_API int32 GetTotalIllegalTransitionCount();
+	FIGHTERGAMEPLUGIN_API void ResetIllegalTransitionCounts();
+
+	//Logs every state and event pair with illegal transitions
+	FIGHTERGAMEPLUGIN_API void LogIllegalTransitions();
+
+	FIGHTERGAMEPLUGIN_API const TCHAR* GetStateName(EFighterSimState _state);
+	FIGHTERGAMEPLUGIN_API const TCHAR* GetEventName(EFighterEvent _event);
+
+	//The rules the table must follow, checked at compile time
+	constexpr bool IsTableValid()
+	{
+		for (int32 stateIndex = 0; stateIndex < NumStates; ++stateIndex)
+		{
+			const EFighterSimState state = (EFighterSimState)stateIndex;
+
+			for (int32 eventIndex = 0; eventIndex < NumEvents; ++eventIndex)
+			{
+				const FFighterTransition& transition = TransitionTable.transitions[stateIndex][eventIndex];
+				const EFighterEvent event = (EFighterEvent)eventIndex;
+
+				//Every transition lands on a real state, and illegal ones change nothing
+				if ((int32)transition.nextState >= NumStates || (transition.isIllegal && (transition.nextState != state || transition.actions != EFighterAction::None)))
+				{
+					return false;
+				}
+
+				//Only stun and launch events end stun and launch, so no button can cancel them
+				const bool isRecovery = event == EFighterEvent::Hit || event == EFighterEvent::BlockedHit || event == EFighterEvent::Launched
+					|| event == EFighterEvent::StunEnded || event == EFighterEvent::LaunchRecovered;
+				if (IsStuck(state) && !isRecovery && transition.nextState != state)
+				{
+					return false;
+				}
+
+				//Stuck fighters cannot jump
+				if (IsStuck(state) && (transition.actions & EFighterAction::Jump))
+				{
+					return false;
+				}
+
+				//Nothing is a no-op
+				if (event == EFighterEvent::None && (transition.nextState != state || transition.actions != EFighterAction::None || transition.isIllegal))
+				{
+					return false;
+				}
+			}
+
+			//Everyone can be hit and launched out of anything
+			if (GetTransition(state, EFighterEvent::Hit).nextState != EFighterSimState::Stunned || GetTransition(state, EFighterEvent::Launched).nextState != EFighterSimState::Launched)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	static_assert(IsTableValid(), "The fighter transition table breaks one of its rules");
+	static_assert(GetTransition(EFighterSimState::Stunned, EFighterEvent::BlockReleased).nextState == EFighterSimState::Stunned, "Releasing block must not cancel a stun");
+	static_assert(GetTransition(EFighterSimState::BlockStunned, EFighterEvent::BlockReleased).nextState == EFighterSimState::BlockStunned, "Releasing block must not cancel blockstun");
+	static_assert(GetTransition(EFighterSimState::Launched, EFighterEvent::Landed).nextState == EFighterSimState::Launched, "Launched fighters stay down until the launch timer runs out");
+	static_assert(GetTransition(EFighterSimState::Jumping, EFighterEvent::JumpReleased).nextState == EFighterSimState::Jumping, "A jump lasts until landing");
+	static_assert(GetTransition(EFighterSimState::Jumping, EFighterEvent::BlockPressed).nextState == EFighterSimState::Jumping, "Pressing block in the air does nothing");
+	static_assert(GetTransition(EFighterSimState::Default, EFighterEvent::JumpPressed).actions == EFighterAction::Jump, "Jumping from the ground leaves it");
+	static_assert(!GetStateInfo(EFighterSimState::Jumping).canTurn && GetStateInfo(EFighterSimState::BlockStunned).isBlocking, "State info is wrong");
+}
@@ -0,0 +1,135 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "FighterStateMachine.h"
+#include "FighterSimulation.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * Walks every state and event pair through the fighter state machine and checks the result against the table below,
+ * which is written out by hand rather than built by the same rules as the real one. Each pair is checked both in the
+ * table and through Dispatch on a fighter, along with whether illegal pairs are counted.
+ *
+ * UE4Editor-Cmd <Project>.uproject -nullrhi -unattended -ExecCmds="Automation RunTests Fighter.StateMachine; Quit"
+ */
+namespace
+{
+	constexpr EFighterSimState D = EFighterSimState::Default;
+	constexpr EFighterSimState MR = EFighterSimState::MovingRight;
+	constexpr EFighterSimState ML = EFighterSimState::MovingLeft;
+	constexpr EFighterSimState J = EFighterSimState::Jumping;
+	constexpr EFighterSimState St = EFighterSimState::Stunned;
+	constexpr EFighterSimState B = EFighterSimState::Blocking;
+	constexpr EFighterSimState C = EFighterSimState::Crouching;
+	constexpr EFighterSimState L = EFighterSimState::Launched;
+	constexpr EFighterSimState BS = EFighterSimState::BlockStunned;
+
+	//The state each state goes to on each event, in the order both enums are declared
+	const EFighterSimState ExpectedNextStates[FighterStateMachine::NumStates][FighterStateMachine::NumEvents] =
+	{
+		//None JumpP JumpR CrchP CrchR BlkP  BlkR  HoldR HoldL HoldN Landed Hit BlkHit Launch StunEnd LaunchRec ProxF ProxU
+		{ D,   J,    D,    C,    D,    B,    D,    MR,   ML,   D,    D,    St,  D,    L,     D,      D,        D,    D  },	//Default
+		{ MR,  J,    MR,   C,    MR,   B,    MR,   MR,   ML,   D,    MR,   St,  MR,   L,     MR,     MR,       B,    MR },	//MovingRight
+		{ ML,  J,    ML,   C,    ML,   B,    ML,   MR,   ML,   D,    ML,   St,  ML,   L,     ML,     ML,       ML,   B  },	//MovingLeft
+		{ J,   J,    J,    J,    J,    J,    J,    J,    J,    J,    D,    St,  J,    L,     J,      J,        J,    J  },	//Jumping
+		{ St,  St,   St,   St,   St,   St,   St,   St,   St,   St,   St,   St,  St,   L,     D,      St,       St,   St },	//Stunned
+		{ B,   J,    B,    C,    B,    B,    D,    B,    B,    B,    B,    St,  BS,   L,     B,      B,        B,    B  },	//Blocking
+		{ C,   J,    C,    C,    D,    B,    C,    C,    C,    C,    C,    St,  C,    L,     C,      C,        C,    C  },	//Crouching
+		{ L,   L,    L,    L,    L,    L,    L,    L,    L,    L,    L,    St,  L,    L,     L,      D,        L,    L  },	//Launched
+		{ BS,  BS,   BS,   BS,   BS,   BS,   BS,   BS,   BS,   BS,   BS,   St,  BS,   L,     D,      BS,       BS,   BS },	//BlockStunned
+	};
+
+	bool IsExpectedStuck(EFighterSimState _state)
+	{
+		return _state == EFighterSimState::Stunned || _state == EFighterSimState::Launched || _state == EFighterSimState::BlockStunned;
+	}
+
+	//Only a fighter who can act jumps when jump is pressed
+	uint8 GetExpectedActions(EFighterSimState _state, EFighterEvent _event)
+	{
+		return _event == EFighterEvent::JumpPressed && !IsExpectedStuck(_state) ? EFighterAction::Jump : EFighterAction::None;
+	}
+
+	//Events that only the simulation sends, to the states that can be in the middle of what they end
+	bool IsExpectedIllegal(EFighterSimState _state, EFighterEvent _event)
+	{
+		switch (_event)
+		{
+		case EFighterEvent::BlockedHit:
+			return _state != EFighterSimState::Blocking && _state != EFighterSimState::BlockStunned;
+		case EFighterEvent::StunEnded:
+			return _state != EFighterSimState::Stunned && _state != EFighterSimState::BlockStunned;
+		case EFighterEvent::LaunchRecovered:
+			return _state != EFighterSimState::Launched;
+		default:
+			return false;
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFighterStateMachineTransitionsTest, "Fighter.StateMachine.Transitions",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::SmokeFilter)
+
+bool FFighterStateMachineTransitionsTest::RunTest(const FString& Parameters)
+{
+	int32 numMismatches = 0;
+
+	for (int32 stateIndex = 0; stateIndex < FighterStateMachine::NumStates; ++stateIndex)
+	{
+		const EFighterSimState state = (EFighterSimState)stateIndex;
+
+		for (int32 eventIndex = 0; eventIndex < FighterStateMachine::NumEvents; ++eventIndex)
+		{
+			const EFighterEvent event = (EFighterEvent)eventIndex;
+			const EFighterSimState expectedState = ExpectedNextStates[stateIndex][eventIndex];
+			const uint8 expectedActions = GetExpectedActions(state, event);
+			const bool expectedIllegal = IsExpectedIllegal(state, event);
+
+			const FFighterTransition& transition = FighterStateMachine::GetTransition(state, event);
+			if (transition.nextState != expectedState || transition.actions != expectedActions || transition.isIllegal != expectedIllegal)
+			{
+				AddError(FString::Printf(TEXT("%s + %s: the table gives %s, actions %d%s, but %s, actions %d%s was expected"),
+					FighterStateMachine::GetStateName(state), FighterStateMachine::GetEventName(event),
+					FighterStateMachine::GetStateName(transition.nextState), transition.actions, transition.isIllegal ? TEXT(", illegal") : TEXT(""),
+					FighterStateMachine::GetStateName(expectedState), expectedActions, expectedIllegal ? TEXT(", illegal") : TEXT("")));
+				++numMismatches;
+				continue;
+			}
+
+			FSimFighterState fighter;
+			FMemory::Memzero(fighter);
+			fighter.characterState = state;
+			fighter.canMove = !IsExpectedStuck(state);
+
+			FighterStateMachine::ResetIllegalTransitionCounts();
+			const uint8 actions = FighterStateMachine::Dispatch(fighter, event);
+
+			if (fighter.characterState != expectedState || actions != expectedActions || fighter.canMove == IsExpectedStuck(expectedState))
+			{
+				AddError(FString::Printf(TEXT("%s + %s: Dispatch left the fighter %s, actions %d, %s"),
+					FighterStateMachine::GetStateName(state), FighterStateMachine::GetEventName(event),
+					FighterStateMachine::GetStateName(fighter.characterState), actions, fighter.canMove ? TEXT("able to move") : TEXT("stuck")));
+				++numMismatches;
+			}
+
+#if FIGHTER_COUNT_ILLEGAL_TRANSITIONS
+			if (FighterStateMachine::GetIllegalTransitionCount(state, event) != (expectedIllegal ? 1 : 0) || FighterStateMachine::GetTotalIllegalTransitionCount() != (expectedIllegal ? 1 : 0))
+			{
+				AddError(FString::Printf(TEXT("%s + %s: Dispatch counted %d illegal transitions"),
+					FighterStateMachine::GetStateName(state), FighterStateMachine::GetEventName(event), FighterStateMachine::GetTotalIllegalTransitionCount()));
+				++numMismatches;
+			}
+#endif
+		}
+	}
+
+	//Leave nothing behind for the next match's report
+	FighterStateMachine::ResetIllegalTransitionCounts();
+
+	TestEqual(TEXT("Mismatched state and event pairs"), numMismatches, 0);
+	return numMismatches == 0;
+}
+
+#endif
@@ -0,0 +1,107 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+//The gameplay timers each fighter can have running, one of each at most
+enum class EFighterTimer : uint8
+{
+	Hitstun,
+	Blockstun,
+	Launch,
+	HitStop,
+
+	Count
+};
+
+/**
+ * Per-fighter timer wheel counted in simulation frames.
+ *
+ * Each timer is hashed into the slot of the frame it expires on, so advancing the wheel only looks at the timers in
+ * the current slot: O(1) per frame, no allocation, and the whole wheel is plain data that snapshots with the match.
+ */
+struct FFighterTimerWheel
+{
+	//Must be a power of two. Timers longer than this simply wrap around the wheel and are skipped until their frame.
+	static constexpr int32 NumSlots = 32;
+
+	//The timers expiring in each slot, one bit per EFighterTimer
+	uint8 slotTimers[NumSlots];
+
+	//The frame each timer expires on, or 0 when it is not running
+	int32 expiryFrames[(int32)EFighterTimer::Count];
+
+	static constexpr uint8 Bit(EFighterTimer _timer) { return (uint8)(1 << (int32)_timer); }
+
+	void Reset()
+	{
+		FMemory::Memzero(slotTimers, sizeof(slotTimers));
+		FMemory::Memzero(expiryFrames, sizeof(expiryFrames));
+	}
+
+	//Starts or restarts _timer so it expires _frames after _currentFrame. Zero or negative lengths stop it instead.
+	void Start(EFighterTimer _timer, int32 _frames, int32 _currentFrame)
+	{
+		Stop(_timer);
+
+		if (_frames > 0)
+		{
+			const int32 expiryFrame = _currentFrame + _frames;
+			expiryFrames[(int32)_timer] = expiryFrame;
+			slotTimers[expiryFrame & (NumSlots - 1)] |= Bit(_timer);
+		}
+	}
+
+	void Stop(EFighterTimer _timer)
+	{
+		const int32 expiryFrame = expiryFrames[(int32)_timer];
+		if (expiryFrame != 0)
+		{
+			slotTimers[expiryFrame & (NumSlots - 1)] &= ~Bit(_timer);
+			expiryFrames[(int32)_timer] = 0;
+		}
+	}
+
+	bool IsRunning(EFighterTimer _timer) const
+	{
+		return expiryFrames[(int32)_timer] != 0;
+	}
+
+	int32 GetRemainingFrames(EFighterTimer _timer, int32 _currentFrame) const
+	{
+		return IsRunning(_timer) ? expiryFrames[(int32)_timer] - _currentFrame : 0;
+	}
+
+	//Pushes every running timer except _exceptTimer back by _frames, used to freeze a fighter during hit-stop
+	void Delay(int32 _frames, int32 _currentFrame, EFighterTimer _exceptTimer)
+	{
+		for (int32 timer = 0; timer < (int32)EFighterTimer::Count; ++timer)
+		{
+			if (timer != (int32)_exceptTimer && expiryFrames[timer] != 0)
+			{
+				Start((EFighterTimer)timer, expiryFrames[timer] - _currentFrame + _frames, _currentFrame);
+			}
+		}
+	}
+
+	//Moves the wheel onto _frame and returns the timers that expired on it, one bit per EFighterTimer
+	uint8 Advance(int32 _frame)
+	{
+		uint8& slot = slotTimers[_frame & (NumSlots - 1)];
+
+		uint8 expired = 0;
+		for (uint32 remaining = slot; remaining != 0; remaining &= remaining - 1)
+		{
+			const int32 timer = (int32)FPlatformMath::CountTrailingZeros(remaining);
+			if (expiryFrames[timer] == _frame)
+			{
+				expired |= (uint8)(1 << timer);
+				expiryFrames[timer] = 0;
+			}
+		}
+
+		slot &= ~expired;
+		return expired;
+	}
+};
@@ -2,16 +2,19 @@
 
 
 #include "HitboxActor.h"
+#include "HitboxDisplayComponent.h"
 
 // Sets default values
 AHitboxActor::AHitboxActor()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+ 	//Hitboxes are moved and toggled by the hitbox pool, so they never need to tick
+	PrimaryActorTick.bCanEverTick = false;
 
+	hitboxExtent = FVector::ZeroVector;
 	hitboxDamage = 0.0f;
 	hitstunTime = 0.0f;
 	blockstunTime = 0.0f;
+	isActiveInPool = false;
 }
 
 // Called when the game starts or when spawned
@@ -21,15 +24,14 @@ void AHitboxActor::BeginPlay()
 	
 }
 
-// Called every frame
-void AHitboxActor::Tick(float DeltaTime)
-{
-	Super::Tick(DeltaTime);
-
-}
-
 void AHitboxActor::TriggerVisualizeHitbox()
 {
+	//The hitbox display draws every box at once, so the per-box blueprint event would only draw them twice
+	if (UHitboxDisplayComponent::IsDisplayEnabled())
+	{
+		return;
+	}
+
 	VisualizeHitbox();
 }
 
@@ -28,9 +28,7 @@ protected:
 	virtual void BeginPlay() override;
 
 public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
-
+	//Calls VisualizeHitbox for this box, unless Fighter.ShowHitboxes is drawing every box already
 	UFUNCTION(BlueprintCallable)
 		void TriggerVisualizeHitbox();
 
@@ -43,6 +41,10 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hitbox")
 		FVector hitboxLocation;
 
+	//Half the box's size in the world, as the simulation has it. Set by the hitbox pool for VisualizeHitbox to draw.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hitbox")
+		FVector hitboxExtent;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hitbox")
 		float hitboxDamage;
 
@@ -51,4 +53,8 @@ public:
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hitbox")
 		float blockstunTime;
+
+	//Is the hitbox pool currently using this box. Inactive boxes are hidden.
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Hitbox")
+		bool isActiveInPool;
 };
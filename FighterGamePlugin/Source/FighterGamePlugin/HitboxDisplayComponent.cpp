@@ -0,0 +1,178 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HitboxDisplayComponent.h"
+#include "PrimitiveSceneProxy.h"
+#include "SceneManagement.h"
+#include "HAL/IConsoleManager.h"
+#include "FighterCollision.h"
+#include "FighterGamePlugin.h"
+
+DECLARE_CYCLE_STAT(TEXT("Hitbox Display Update"), STAT_FighterHitboxDisplayUpdate, STATGROUP_Fighter);
+
+namespace
+{
+	int32 ShowHitboxes = 0;
+
+	FAutoConsoleVariableRef ShowHitboxesVariable(
+		TEXT("Fighter.ShowHitboxes"),
+		ShowHitboxes,
+		TEXT("Draws every hitbox and hurtbox of the match, coloured by type. 0 is off and costs nothing."));
+
+	struct FHitboxDisplayBox
+	{
+		FBox box;
+		FColor color;
+	};
+
+	//Every box of one frame. Kept inline so sending a frame to the render thread never allocates.
+	typedef TArray<FHitboxDisplayBox, TInlineAllocator<FFighterHitboxTable::MaxBoxes * 2>> FHitboxDisplayBoxes;
+
+	class FHitboxDisplaySceneProxy final : public FPrimitiveSceneProxy
+	{
+	public:
+		FHitboxDisplaySceneProxy(const UHitboxDisplayComponent* _component)
+			: FPrimitiveSceneProxy(_component)
+			, lineThickness(_component->lineThickness)
+		{
+			bWillEverBeLit = false;
+		}
+
+		virtual SIZE_T GetTypeHash() const override
+		{
+			static size_t uniquePointer;
+			return reinterpret_cast<size_t>(&uniquePointer);
+		}
+
+		void SetBoxes_RenderThread(const FHitboxDisplayBoxes& _boxes)
+		{
+			check(IsInRenderingThread());
+			boxes = _boxes;
+		}
+
+		//All the boxes' lines go through the same PDI, which batches them into one draw per view
+		virtual void GetDynamicMeshElements(const TArray<const FSceneView*>& Views, const FSceneViewFamily& ViewFamily, uint32 VisibilityMap, FMeshElementCollector& Collector) const override
+		{
+			for (int32 viewIndex = 0; viewIndex < Views.Num(); ++viewIndex)
+			{
+				if (VisibilityMap & (1 << viewIndex))
+				{
+					FPrimitiveDrawInterface* drawInterface = Collector.GetPDI(viewIndex);
+					for (const FHitboxDisplayBox& box : boxes)
+					{
+						DrawWireBox(drawInterface, box.box, box.color, SDPG_Foreground, lineThickness);
+					}
+				}
+			}
+		}
+
+		virtual FPrimitiveViewRelevance GetViewRelevance(const FSceneView* View) const override
+		{
+			FPrimitiveViewRelevance relevance;
+			relevance.bDrawRelevance = IsShown(View) && boxes.Num() > 0;
+			relevance.bDynamicRelevance = true;
+			return relevance;
+		}
+
+		virtual uint32 GetMemoryFootprint() const override
+		{
+			return sizeof(*this) + GetAllocatedSize();
+		}
+
+	private:
+		FHitboxDisplayBoxes boxes;
+		float lineThickness;
+	};
+
+	void AddBox(FHitboxDisplayBoxes& _boxes, const FVector& _origin, float _depth, int32 _minX, int32 _maxX, int32 _minZ, int32 _maxZ, FColor _color)
+	{
+		//The simulation's X is the world's Y, and its Z is the height above the player's origin
+		FHitboxDisplayBox& box = _boxes.AddDefaulted_GetRef();
+		box.box = FBox(
+			FVector(_origin.X - _depth * 0.5f, FFixed::FromRaw(_minX).ToFloat(), _origin.Z + FFixed::FromRaw(_minZ).ToFloat()),
+			FVector(_origin.X + _depth * 0.5f, FFixed::FromRaw(_maxX).ToFloat(), _origin.Z + FFixed::FromRaw(_maxZ).ToFloat()));
+		box.color = _color;
+	}
+}
+
+UHitboxDisplayComponent::UHitboxDisplayComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+
+	SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	SetGenerateOverlapEvents(false);
+	CastShadow = false;
+
+	proximityColor = FColor::Yellow;
+	strikeColor = FColor::Red;
+	hurtboxColor = FColor::Green;
+	lineThickness = 2.0f;
+	boxDepth = 40.0f;
+}
+
+bool UHitboxDisplayComponent::IsDisplayEnabled()
+{
+	return ShowHitboxes != 0;
+}
+
+void UHitboxDisplayComponent::SetDisplayEnabled(bool _isEnabled)
+{
+	ShowHitboxesVariable->Set(_isEnabled ? 1 : 0, ECVF_SetByCode);
+}
+
+void UHitboxDisplayComponent::UpdateFromMatch(const FSimMatchState& _state, const FVector& _player1Origin, const FVector& _player2Origin)
+{
+	FIGHTER_SCOPE_CYCLE_COUNTER(HitboxDisplayUpdate);
+
+	FHitboxDisplaySceneProxy* proxy = static_cast<FHitboxDisplaySceneProxy*>(SceneProxy);
+	if (!proxy)
+	{
+		return;
+	}
+
+	FFighterHitboxTable table;
+	FighterSim::BuildHitboxTable(_state, table);
+
+	const FVector origins[2] = { _player1Origin, _player2Origin };
+
+	FHitboxDisplayBoxes boxes;
+	for (int32 index = 0; index < table.numAttackBoxes; ++index)
+	{
+		AddBox(boxes, origins[table.attackOwner[index]], boxDepth, table.attackMinX[index], table.attackMaxX[index], table.attackMinZ[index], table.attackMaxZ[index],
+			GetColor((EHitboxEnum)table.attackType[index]));
+	}
+	for (int32 index = 0; index < table.numHurtboxes; ++index)
+	{
+		AddBox(boxes, origins[table.hurtOwner[index]], boxDepth, table.hurtMinX[index], table.hurtMaxX[index], table.hurtMinZ[index], table.hurtMaxZ[index],
+			hurtboxColor);
+	}
+
+	ENQUEUE_RENDER_COMMAND(UpdateHitboxDisplay)([proxy, boxes](FRHICommandListImmediate& RHICmdList)
+	{
+		proxy->SetBoxes_RenderThread(boxes);
+	});
+}
+
+FColor UHitboxDisplayComponent::GetColor(EHitboxEnum _hitboxType) const
+{
+	switch (_hitboxType)
+	{
+	case EHitboxEnum::HB_PROXIMITY:
+		return proximityColor;
+	case EHitboxEnum::HB_STRIKE:
+		return strikeColor;
+	default:
+		return hurtboxColor;
+	}
+}
+
+FPrimitiveSceneProxy* UHitboxDisplayComponent::CreateSceneProxy()
+{
+	return new FHitboxDisplaySceneProxy(this);
+}
+
+FBoxSphereBounds UHitboxDisplayComponent::CalcBounds(const FTransform& LocalToWorld) const
+{
+	//The boxes go wherever the fighters do, so like the world's line batcher this is never culled
+	return FBoxSphereBounds(FVector::ZeroVector, FVector(HALF_WORLD_MAX), HALF_WORLD_MAX);
+}
@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/PrimitiveComponent.h"
+#include "HitboxActor.h"
+#include "HitboxDisplayComponent.generated.h"
+
+struct FSimMatchState;
+
+/**
+ * Draws every hitbox and hurtbox of the match as wire boxes coloured by EHitboxEnum, all in one batched line draw.
+ *
+ * Fed straight from the simulation's hitbox table each frame, so nothing goes through the blueprint VM or the pooled
+ * hitbox actors. The game mode only creates it while Fighter.ShowHitboxes is on, so with the display off it costs nothing.
+ */
+UCLASS(ClassGroup = Fighter)
+class FIGHTERGAMEPLUGIN_API UHitboxDisplayComponent : public UPrimitiveComponent
+{
+	GENERATED_BODY()
+
+public:
+	UHitboxDisplayComponent();
+
+	//Fighter.ShowHitboxes, for training mode
+	static bool IsDisplayEnabled();
+	static void SetDisplayEnabled(bool _isEnabled);
+
+	//Sends the boxes of _state to the renderer, placing the simulation's stage and height axes around each player's origin
+	void UpdateFromMatch(const FSimMatchState& _state, const FVector& _player1Origin, const FVector& _player2Origin);
+
+	FColor GetColor(EHitboxEnum _hitboxType) const;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hitbox")
+		FColor proximityColor;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hitbox")
+		FColor strikeColor;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hitbox")
+		FColor hurtboxColor;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hitbox")
+		float lineThickness;
+
+	//The boxes are 2D in the simulation, so this is how deep they are drawn into the screen
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hitbox")
+		float boxDepth;
+
+	virtual FPrimitiveSceneProxy* CreateSceneProxy() override;
+	virtual FBoxSphereBounds CalcBounds(const FTransform& LocalToWorld) const override;
+};
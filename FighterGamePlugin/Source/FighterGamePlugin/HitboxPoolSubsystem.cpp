@@ -0,0 +1,279 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HitboxPoolSubsystem.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "FighterCollision.h"
+#include "FighterGamePlugin.h"
+
+DECLARE_CYCLE_STAT(TEXT("Hitbox Pool Acquire"), STAT_FighterAcquireHitbox, STATGROUP_Fighter);
+DECLARE_CYCLE_STAT(TEXT("Hitbox Pool Release"), STAT_FighterReleaseHitbox, STATGROUP_Fighter);
+DECLARE_CYCLE_STAT(TEXT("Hitbox Pool Show Fighter Boxes"), STAT_FighterShowFighterBoxes, STATGROUP_Fighter);
+
+namespace
+{
+	//The simulation's X is the world's Y, and its Z is the height above the fighter's origin
+	FVector GetBoxCenter(const FVector& _origin, int32 _minX, int32 _maxX, int32 _minZ, int32 _maxZ)
+	{
+		return FVector(_origin.X, FFixed::FromRaw((_minX + _maxX) / 2).ToFloat(), _origin.Z + FFixed::FromRaw((_minZ + _maxZ) / 2).ToFloat());
+	}
+
+	FVector GetBoxExtent(int32 _minX, int32 _maxX, int32 _minZ, int32 _maxZ)
+	{
+		return FVector(0.0f, FFixed::FromRaw((_maxX - _minX) / 2).ToFloat(), FFixed::FromRaw((_maxZ - _minZ) / 2).ToFloat());
+	}
+}
+
+bool UHitboxPoolSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	//Editor and preview worlds never fight
+	const UWorld* world = Cast<UWorld>(Outer);
+	return world && world->IsGameWorld();
+}
+
+void UHitboxPoolSubsystem::PreallocateForFighter(AActor* _fighter, TSubclassOf<AHitboxActor> _hitboxClass, TSubclassOf<AHitboxActor> _hurtboxClass, int32 _numHitboxes, int32 _numHurtboxes)
+{
+	if (!_fighter)
+	{
+		return;
+	}
+
+	FFighterHitboxPool& pool = pools.FindOrAdd(_fighter);
+	pool.hitboxClass = _hitboxClass ? _hitboxClass : TSubclassOf<AHitboxActor>(AHitboxActor::StaticClass());
+	pool.hurtboxClass = _hurtboxClass ? _hurtboxClass : TSubclassOf<AHitboxActor>(AHitboxActor::StaticClass());
+
+	pool.freeHitboxes.Reserve(_numHitboxes);
+	pool.freeHurtboxes.Reserve(_numHurtboxes);
+	pool.activeHitboxes.Reserve(_numHitboxes);
+	pool.activeHurtboxes.Reserve(_numHurtboxes);
+
+	while (pool.freeHitboxes.Num() < _numHitboxes)
+	{
+		pool.freeHitboxes.Add(SpawnPooledBox(_fighter, pool.hitboxClass));
+	}
+	while (pool.freeHurtboxes.Num() < _numHurtboxes)
+	{
+		pool.freeHurtboxes.Add(SpawnPooledBox(_fighter, pool.hurtboxClass));
+	}
+}
+
+AHitboxActor* UHitboxPoolSubsystem::AcquireHitbox(AActor* _fighter, EHitboxEnum _hitboxType, FVector _location, float _hitboxDamage, float _hitstunTime, float _blockstunTime)
+{
+	FIGHTER_SCOPE_CYCLE_COUNTER(AcquireHitbox);
+
+	FFighterHitboxPool* pool = pools.Find(_fighter);
+	if (!pool)
+	{
+		UE_LOG(LogFighter, Warning, TEXT("AcquireHitbox: %s has no hitbox pool. Call PreallocateForFighter when the match starts."), *GetNameSafe(_fighter));
+		return nullptr;
+	}
+
+	const bool isHurtbox = _hitboxType == EHitboxEnum::HB_HURTBOX;
+	TArray<AHitboxActor*>& freeBoxes = isHurtbox ? pool->freeHurtboxes : pool->freeHitboxes;
+
+	AHitboxActor* hitbox = nullptr;
+	if (freeBoxes.Num() > 0)
+	{
+		hitbox = freeBoxes.Pop(false);
+		++stats.numReuses;
+	}
+	else
+	{
+		//Keep the fight going, but the pool should be sized so this never happens
+		hitbox = SpawnPooledBox(_fighter, isHurtbox ? pool->hurtboxClass : pool->hitboxClass);
+		++stats.numOverflowSpawns;
+		UE_LOG(LogFighter, Warning, TEXT("Hitbox pool for %s ran out and had to spawn a new box"), *GetNameSafe(_fighter));
+	}
+
+	Activate(hitbox, _hitboxType, _location, _hitboxDamage, _hitstunTime, _blockstunTime);
+	(isHurtbox ? pool->activeHurtboxes : pool->activeHitboxes).Add(hitbox);
+
+	++stats.numAcquires;
+	++stats.numActive;
+	stats.highWaterMark = FMath::Max(stats.highWaterMark, stats.numActive);
+
+	return hitbox;
+}
+
+void UHitboxPoolSubsystem::ReleaseHitbox(AHitboxActor* _hitbox)
+{
+	FIGHTER_SCOPE_CYCLE_COUNTER(ReleaseHitbox);
+
+	if (!_hitbox || !_hitbox->isActiveInPool)
+	{
+		return;
+	}
+
+	FFighterHitboxPool* pool = pools.Find(_hitbox->GetOwner());
+	const bool isHurtbox = _hitbox->hitboxType == EHitboxEnum::HB_HURTBOX;
+	if (!pool || (isHurtbox ? pool->activeHurtboxes : pool->activeHitboxes).RemoveSingleSwap(_hitbox, false) == 0)
+	{
+		return;
+	}
+
+	TArray<AHitboxActor*>& freeBoxes = isHurtbox ? pool->freeHurtboxes : pool->freeHitboxes;
+	Deactivate(_hitbox);
+	freeBoxes.Add(_hitbox);
+
+	--stats.numActive;
+}
+
+void UHitboxPoolSubsystem::ShowFighterBoxes(AActor* _fighter, int32 _ownerIndex, const FFighterHitboxTable& _table, const FVector& _origin)
+{
+	FIGHTER_SCOPE_CYCLE_COUNTER(ShowFighterBoxes);
+
+	FFighterHitboxPool* pool = pools.Find(_fighter);
+	if (!pool)
+	{
+		return;
+	}
+
+	int32 numHitboxes = 0;
+	for (int32 index = 0; index < _table.numAttackBoxes; ++index)
+	{
+		if (_table.attackOwner[index] != _ownerIndex)
+		{
+			continue;
+		}
+
+		const EHitboxEnum hitboxType = (EHitboxEnum)_table.attackType[index];
+		const FVector location = GetBoxCenter(_origin, _table.attackMinX[index], _table.attackMaxX[index], _table.attackMinZ[index], _table.attackMaxZ[index]);
+		const float damage = _table.attackDamage[index].ToFloat();
+		const float hitstunTime = (float)_table.attackHitstunFrames[index] / FighterSim::FramesPerSecond;
+		const float blockstunTime = (float)_table.attackBlockstunFrames[index] / FighterSim::FramesPerSecond;
+
+		//Drawn once when the box comes out, as when each attack spawned its own
+		const bool isNewBox = numHitboxes >= pool->activeHitboxes.Num();
+
+		AHitboxActor* hitbox = nullptr;
+		if (!isNewBox)
+		{
+			hitbox = pool->activeHitboxes[numHitboxes];
+			Activate(hitbox, hitboxType, location, damage, hitstunTime, blockstunTime);
+		}
+		else
+		{
+			hitbox = AcquireHitbox(_fighter, hitboxType, location, damage, hitstunTime, blockstunTime);
+		}
+		hitbox->hitboxExtent = GetBoxExtent(_table.attackMinX[index], _table.attackMaxX[index], _table.attackMinZ[index], _table.attackMaxZ[index]);
+		++numHitboxes;
+
+		if (isNewBox)
+		{
+			hitbox->TriggerVisualizeHitbox();
+		}
+	}
+	while (pool->activeHitboxes.Num() > numHitboxes)
+	{
+		ReleaseHitbox(pool->activeHitboxes.Last());
+	}
+
+	int32 numHurtboxes = 0;
+	for (int32 index = 0; index < _table.numHurtboxes; ++index)
+	{
+		if (_table.hurtOwner[index] != _ownerIndex)
+		{
+			continue;
+		}
+
+		const FVector location = GetBoxCenter(_origin, _table.hurtMinX[index], _table.hurtMaxX[index], _table.hurtMinZ[index], _table.hurtMaxZ[index]);
+
+		AHitboxActor* hurtbox = nullptr;
+		if (numHurtboxes < pool->activeHurtboxes.Num())
+		{
+			hurtbox = pool->activeHurtboxes[numHurtboxes];
+			Activate(hurtbox, EHitboxEnum::HB_HURTBOX, location, 0.0f, 0.0f, 0.0f);
+		}
+		else
+		{
+			hurtbox = AcquireHitbox(_fighter, EHitboxEnum::HB_HURTBOX, location, 0.0f, 0.0f, 0.0f);
+		}
+		hurtbox->hitboxExtent = GetBoxExtent(_table.hurtMinX[index], _table.hurtMaxX[index], _table.hurtMinZ[index], _table.hurtMaxZ[index]);
+		++numHurtboxes;
+	}
+	while (pool->activeHurtboxes.Num() > numHurtboxes)
+	{
+		ReleaseHitbox(pool->activeHurtboxes.Last());
+	}
+}
+
+void UHitboxPoolSubsystem::ReleaseAllForFighter(AActor* _fighter)
+{
+	if (FFighterHitboxPool* pool = pools.Find(_fighter))
+	{
+		while (pool->activeHitboxes.Num() > 0)
+		{
+			ReleaseHitbox(pool->activeHitboxes.Last());
+		}
+		while (pool->activeHurtboxes.Num() > 0)
+		{
+			ReleaseHitbox(pool->activeHurtboxes.Last());
+		}
+	}
+}
+
+float UHitboxPoolSubsystem::GetReuseRate() const
+{
+	return stats.numAcquires > 0 ? (float)stats.numReuses / (float)stats.numAcquires : 1.0f;
+}
+
+void UHitboxPoolSubsystem::LogStats() const
+{
+	UE_LOG(LogFighter, Display, TEXT("Hitbox pool: %d pooled, %d active, high-water mark %d, %d acquires, %.1f%% reused, %d overflow spawns"),
+		stats.numPooled, stats.numActive, stats.highWaterMark, stats.numAcquires, GetReuseRate() * 100.0f, stats.numOverflowSpawns);
+}
+
+AHitboxActor* UHitboxPoolSubsystem::SpawnPooledBox(AActor* _fighter, TSubclassOf<AHitboxActor> _class)
+{
+	FActorSpawnParameters spawnParameters;
+	spawnParameters.Owner = _fighter;
+	spawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	AHitboxActor* hitbox = GetWorld()->SpawnActor<AHitboxActor>(_class, _fighter->GetActorTransform(), spawnParameters);
+	check(hitbox);
+
+	//Blueprint subclasses may have turned ticking back on
+	hitbox->SetActorTickEnabled(false);
+
+	//Hits come from the simulation, not the physics scene
+	hitbox->SetActorEnableCollision(false);
+
+	Deactivate(hitbox);
+	++stats.numPooled;
+
+	return hitbox;
+}
+
+void UHitboxPoolSubsystem::Activate(AHitboxActor* _hitbox, EHitboxEnum _hitboxType, const FVector& _location, float _hitboxDamage, float _hitstunTime, float _blockstunTime)
+{
+	_hitbox->hitboxType = _hitboxType;
+	_hitbox->hitboxLocation = _location;
+	_hitbox->hitboxDamage = _hitboxDamage;
+	_hitbox->hitstunTime = _hitstunTime;
+	_hitbox->blockstunTime = _blockstunTime;
+	_hitbox->isActiveInPool = true;
+
+	_hitbox->SetActorLocation(_location);
+	_hitbox->SetActorHiddenInGame(false);
+}
+
+void UHitboxPoolSubsystem::Deactivate(AHitboxActor* _hitbox)
+{
+	_hitbox->isActiveInPool = false;
+	_hitbox->SetActorHiddenInGame(true);
+}
+
+namespace
+{
+	FAutoConsoleCommandWithWorld HitboxPoolStatsCommand(
+		TEXT("Fighter.HitboxPoolStats"),
+		TEXT("Logs the hitbox pool's size, high-water mark and reuse rate"),
+		FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* _world)
+		{
+			if (const UHitboxPoolSubsystem* hitboxPool = _world ? _world->GetSubsystem<UHitboxPoolSubsystem>() : nullptr)
+			{
+				hitboxPool->LogStats();
+			}
+		}));
+}
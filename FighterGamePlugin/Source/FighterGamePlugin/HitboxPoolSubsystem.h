@@ -0,0 +1,123 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HitboxActor.h"
+#include "HitboxPoolSubsystem.generated.h"
+
+struct FFighterHitboxTable;
+
+USTRUCT(BlueprintType)
+struct FHitboxPoolStats
+{
+	GENERATED_BODY()
+
+public:
+	//Hitboxes and hurtboxes owned by all the pools, active or not
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Hitbox Pool")
+		int32 numPooled = 0;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Hitbox Pool")
+		int32 numActive = 0;
+
+	//The most boxes that have been active at once
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Hitbox Pool")
+		int32 highWaterMark = 0;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Hitbox Pool")
+		int32 numAcquires = 0;
+
+	//Acquires served by a box that was already in the pool
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Hitbox Pool")
+		int32 numReuses = 0;
+
+	//Acquires that found the pool empty and had to spawn. Should stay at 0; raise the fighter's pool size if it does not.
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Hitbox Pool")
+		int32 numOverflowSpawns = 0;
+};
+
+//The boxes preallocated for one fighter
+USTRUCT()
+struct FFighterHitboxPool
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY()
+		TSubclassOf<AHitboxActor> hitboxClass;
+
+	UPROPERTY()
+		TSubclassOf<AHitboxActor> hurtboxClass;
+
+	UPROPERTY()
+		TArray<AHitboxActor*> freeHitboxes;
+
+	UPROPERTY()
+		TArray<AHitboxActor*> freeHurtboxes;
+
+	UPROPERTY()
+		TArray<AHitboxActor*> activeHitboxes;
+
+	UPROPERTY()
+		TArray<AHitboxActor*> activeHurtboxes;
+};
+
+/**
+ * Owns every hitbox and hurtbox in the world. Each fighter's boxes are spawned once when the match starts,
+ * then shown, hidden and moved as attacks need them, so nothing is spawned or destroyed mid-fight and none of them tick.
+ * Pooled boxes are only for show and never have collision: hits come from the fighters' move sets, inside the simulation.
+ * The game mode puts the simulation's boxes on them after every frame it syncs, through ShowFighterBoxes.
+ */
+UCLASS()
+class FIGHTERGAMEPLUGIN_API UHitboxPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	//Spawns _numHitboxes proximity/strike boxes and _numHurtboxes hurtboxes for _fighter, all inactive
+	UFUNCTION(BlueprintCallable, Category = "Hitbox Pool")
+		void PreallocateForFighter(AActor* _fighter, TSubclassOf<AHitboxActor> _hitboxClass, TSubclassOf<AHitboxActor> _hurtboxClass, int32 _numHitboxes, int32 _numHurtboxes);
+
+	//Activates one of _fighter's boxes at _location with the given values. Replaces spawning HitboxActorBP/HurtboxActorBP.
+	UFUNCTION(BlueprintCallable, Category = "Hitbox Pool")
+		AHitboxActor* AcquireHitbox(AActor* _fighter, EHitboxEnum _hitboxType, FVector _location, float _hitboxDamage, float _hitstunTime, float _blockstunTime);
+
+	//Deactivates _hitbox and returns it to its fighter's pool. Replaces destroying it.
+	UFUNCTION(BlueprintCallable, Category = "Hitbox Pool")
+		void ReleaseHitbox(AHitboxActor* _hitbox);
+
+	/**
+	 * Shows the boxes fighter _ownerIndex has in _table this frame, _origin being where their simulation position is measured from.
+	 * Boxes already out are moved onto this frame's boxes, so a box that lasts several frames keeps its actor and only counts
+	 * as one acquire, and any left over go back to the pool.
+	 */
+	void ShowFighterBoxes(AActor* _fighter, int32 _ownerIndex, const FFighterHitboxTable& _table, const FVector& _origin);
+
+	//Deactivates every box _fighter has out, for example at the end of a round
+	UFUNCTION(BlueprintCallable, Category = "Hitbox Pool")
+		void ReleaseAllForFighter(AActor* _fighter);
+
+	UFUNCTION(BlueprintPure, Category = "Hitbox Pool")
+		FHitboxPoolStats GetStats() const { return stats; }
+
+	//The fraction of acquires that reused a pooled box instead of spawning one
+	UFUNCTION(BlueprintPure, Category = "Hitbox Pool")
+		float GetReuseRate() const;
+
+	void LogStats() const;
+
+protected:
+	AHitboxActor* SpawnPooledBox(AActor* _fighter, TSubclassOf<AHitboxActor> _class);
+
+	static void Activate(AHitboxActor* _hitbox, EHitboxEnum _hitboxType, const FVector& _location, float _hitboxDamage, float _hitstunTime, float _blockstunTime);
+	static void Deactivate(AHitboxActor* _hitbox);
+
+	UPROPERTY()
+		TMap<AActor*, FFighterHitboxPool> pools;
+
+	FHitboxPoolStats stats;
+};